@@ -164,6 +164,7 @@ GPUEngineBase::GPUEngineBase()
 {
 	_gpuSystem = NULL;
 	_IORegisterMap = NULL;
+	_liveIORegisterMap = NULL;
 	_paletteOBJ = NULL;
 	_targetDisplay = NULL;
 	
@@ -202,7 +203,7 @@ GPUEngineBase::GPUEngineBase()
 	if (CommonSettings.num_cores > 1)
 	{
 		_asyncClearTask = new Task;
-		_asyncClearTask->start(false, 0, "async clear");
+		_asyncClearTask->start(TaskGroup_GPU, false);
 	}
 	else
 	{
@@ -217,6 +218,11 @@ GPUEngineBase::GPUEngineBase()
 	_asyncClearIsRunning = false;
 	_asyncClearUseInternalCustomBuffer = false;
 	
+	memset(_reuseLineSignature, 0, sizeof(_reuseLineSignature));
+	_willReuseLines = false;
+	_reuseLineCheckCount = 0;
+	_reuseLineHitCount = 0;
+	
 	_didPassWindowTestCustomMasterPtr = NULL;
 	_didPassWindowTestCustom[GPULayerID_BG0] = NULL;
 	_didPassWindowTestCustom[GPULayerID_BG1] = NULL;
@@ -297,6 +303,7 @@ void GPUEngineBase::Reset()
 	memset(this->_h_win[0], 0, sizeof(this->_h_win[0]));
 	memset(this->_h_win[1], 0, sizeof(this->_h_win[1]));
 	memset(&this->_mosaicColors, 0, sizeof(MosaicColor));
+	memset(this->_reuseLineSignature, 0, sizeof(this->_reuseLineSignature));
 	memset(this->_itemsForPriority, 0, sizeof(this->_itemsForPriority));
 	
 	memset(this->_internalRenderLineTargetNative, 0, GPU_FRAMEBUFFER_NATIVE_WIDTH * sizeof(u16));
@@ -769,7 +776,9 @@ void GPUEngineBase::RenderLineClearAsyncWaitForCustomLine(const size_t l)
 	const s32 lineCompare = (s32)l;
 	while (lineCompare >= atomic_and_barrier32(&this->_asyncClearLineCustom, 0x000000FF))
 	{
-		// Do nothing -- just spin.
+		// Just spin, unless no pool thread has gotten around to the clear yet. In that case,
+		// do the clear here, since nothing else may be free to do it.
+		this->_asyncClearTask->runIfQueued();
 	}
 }
 
@@ -924,6 +933,323 @@ void GPUEngineBase::LastLineProcess()
 	this->RefreshAffineStartRegs();
 }
 
+void GPUEngineBase::_SaveLineState(GPUEngineLineState &state) const
+{
+	memcpy(state.BGLayer, this->_BGLayer, sizeof(this->_BGLayer));
+	memcpy(state.isBGLayerShown, this->_isBGLayerShown, sizeof(this->_isBGLayerShown));
+	state.isAnyBGLayerShown = this->_isAnyBGLayerShown;
+	
+	for (size_t i = 0; i < NB_PRIORITIES; i++)
+	{
+		memcpy(state.BGsForPriority[i], this->_itemsForPriority[i].BGs, NB_BG);
+		state.nbBGsForPriority[i] = this->_itemsForPriority[i].nbBGs;
+	}
+}
+
+void GPUEngineBase::_LoadLineState(const GPUEngineLineState &state)
+{
+	memcpy(this->_BGLayer, state.BGLayer, sizeof(this->_BGLayer));
+	memcpy(this->_isBGLayerShown, state.isBGLayerShown, sizeof(this->_isBGLayerShown));
+	this->_isAnyBGLayerShown = state.isAnyBGLayerShown;
+	
+	for (size_t i = 0; i < NB_PRIORITIES; i++)
+	{
+		memcpy(this->_itemsForPriority[i].BGs, state.BGsForPriority[i], NB_BG);
+		this->_itemsForPriority[i].nbBGs = state.nbBGsForPriority[i];
+	}
+}
+
+void GPUEngineBase::RecordDeferredLine(const size_t l, const bool willRender)
+{
+	GPUEngineLineState &state = this->_deferredLineState[l];
+	
+	state.IORegisterMap = *this->_IORegisterMap;
+	this->_SaveLineState(state);
+	state.willRender = willRender;
+}
+
+void GPUEngineBase::RenderDeferredLinesStart()
+{
+	this->_liveIORegisterMap = this->_IORegisterMap;
+	this->_SaveLineState(this->_liveLineState);
+}
+
+bool GPUEngineBase::RenderDeferredLinesApplyLine(const size_t l, const bool isFirstLine)
+{
+	GPUEngineLineState &state = this->_deferredLineState[l];
+	
+	// Rendering a line advances the affine reference points, but this happens here rather than in
+	// the live registers. Since any CPU write to the reference points flushes the deferred lines
+	// first, every line after the first one continues on from where the previous line left off.
+	if (!isFirstLine)
+	{
+		const GPU_IOREG &prevIORegisterMap = this->_deferredLineState[l-1].IORegisterMap;
+		state.IORegisterMap.BG2Param.BG2X = prevIORegisterMap.BG2Param.BG2X;
+		state.IORegisterMap.BG2Param.BG2Y = prevIORegisterMap.BG2Param.BG2Y;
+		state.IORegisterMap.BG3Param.BG3X = prevIORegisterMap.BG3Param.BG3X;
+		state.IORegisterMap.BG3Param.BG3Y = prevIORegisterMap.BG3Param.BG3Y;
+	}
+	
+	this->_IORegisterMap = &state.IORegisterMap;
+	this->_LoadLineState(state);
+	
+	return state.willRender;
+}
+
+void GPUEngineBase::RenderDeferredLinesFinish(const size_t lastLine)
+{
+	const GPU_IOREG &lastIORegisterMap = this->_deferredLineState[lastLine].IORegisterMap;
+	
+	this->_IORegisterMap = this->_liveIORegisterMap;
+	this->_LoadLineState(this->_liveLineState);
+	
+	this->_IORegisterMap->BG2Param.BG2X = lastIORegisterMap.BG2Param.BG2X;
+	this->_IORegisterMap->BG2Param.BG2Y = lastIORegisterMap.BG2Param.BG2Y;
+	this->_IORegisterMap->BG3Param.BG3X = lastIORegisterMap.BG3Param.BG3X;
+	this->_IORegisterMap->BG3Param.BG3Y = lastIORegisterMap.BG3Param.BG3Y;
+}
+
+static FORCEINLINE u64 GPU_LineSignatureMix(u64 h, const u64 value)
+{
+	// Both steps can be undone, so two inputs that differ in a single value never end up with the same signature.
+	h = (h ^ value) * 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 32);
+}
+
+static u64 GPU_LineSignatureMixBytes(u64 h, const void *src, const size_t len)
+{
+	const u8 *src8 = (const u8 *)src;
+	size_t i = 0;
+	
+	for (; i + sizeof(u64) <= len; i += sizeof(u64))
+	{
+		u64 value;
+		memcpy(&value, src8 + i, sizeof(u64));
+		h = GPU_LineSignatureMix(h, value);
+	}
+	
+	if (i < len)
+	{
+		u64 value = 0;
+		memcpy(&value, src8 + i, len - i);
+		h = GPU_LineSignatureMix(h, value);
+	}
+	
+	return h;
+}
+
+// Mixes in which pages of ARM9_LCD back a range of 2D engine VRAM addresses, along with the generation
+// counters of those pages. The counters only ever increase, so their sum changes whenever a page is written to.
+static u64 GPU_LineSignatureMixVRAM(u64 h, const u32 vramAddr, const u32 len)
+{
+	const u32 firstPage = vramAddr >> 14;
+	const u32 lastPage = (vramAddr + len - 1) >> 14;
+	
+	for (u32 page = firstPage; page <= lastPage; page++)
+	{
+		const u32 lcdPage = vram_arm9_map[page & (VRAM_ARM9_PAGES - 1)];
+		const u32 *__restrict generation = MMU.vramPageGeneration + (lcdPage << (14 - VRAM_GENERATION_PAGE_SHIFT));
+		u64 generationSum = 0;
+		
+		for (size_t i = 0; i < (1 << (14 - VRAM_GENERATION_PAGE_SHIFT)); i++)
+		{
+			generationSum += generation[i];
+		}
+		
+		h = GPU_LineSignatureMix(h, ((u64)lcdPage << 48) | generationSum);
+	}
+	
+	return h;
+}
+
+// Same as GPU_LineSignatureMixVRAM(), but for memory that is already mapped, such as an extended palette slot.
+static u64 GPU_LineSignatureMixMappedVRAM(u64 h, const u8 *hostPtr, const size_t len)
+{
+	const size_t ofs = (size_t)(hostPtr - MMU.ARM9_LCD);
+	h = GPU_LineSignatureMix(h, ofs);
+	
+	if ( (hostPtr < MMU.ARM9_LCD) || (ofs + len > sizeof(MMU.ARM9_LCD)) )
+	{
+		return h;
+	}
+	
+	const size_t lastPage = (ofs + len - 1) >> VRAM_GENERATION_PAGE_SHIFT;
+	for (size_t page = ofs >> VRAM_GENERATION_PAGE_SHIFT; page <= lastPage; page++)
+	{
+		h = GPU_LineSignatureMix(h, MMU.vramPageGeneration[page]);
+	}
+	
+	return h;
+}
+
+u64 GPUEngineBase::_ComputeLineSignature(const GPUEngineCompositorInfo &compInfo) const
+{
+	// The master brightness is applied to the whole framebuffer after the fact, and the selected layer
+	// fields only matter while the line is being composited, so leave them out of the signature.
+	GPUEngineRenderState renderState;
+	memcpy(&renderState, &compInfo.renderState, sizeof(GPUEngineRenderState));
+	renderState.previouslyRenderedLayerID = GPULayerID_Backdrop;
+	renderState.selectedLayerID = GPULayerID_BG0;
+	renderState.selectedBGLayer = NULL;
+	renderState.masterBrightnessMode = GPUMasterBrightMode_Disable;
+	renderState.masterBrightnessIntensity = 0;
+	renderState.masterBrightnessIsMaxOrMin = false;
+	
+	u64 h = GPU_LineSignatureMixBytes(0, &renderState, sizeof(GPUEngineRenderState));
+	
+	// Everything from BGnCNT through BLDY, which includes the current affine reference points.
+	const u8 *IORegisterBytes = (const u8 *)this->_IORegisterMap;
+	h = GPU_LineSignatureMixBytes(h, &this->_IORegisterMap->DISPCNT, sizeof(IOREG_DISPCNT));
+	h = GPU_LineSignatureMixBytes(h, IORegisterBytes + offsetof(GPU_IOREG, BGnCNT), offsetof(GPU_IOREG, unused) - offsetof(GPU_IOREG, BGnCNT));
+	
+	h = GPU_LineSignatureMixBytes(h, this->_BGLayer, sizeof(this->_BGLayer));
+	h = GPU_LineSignatureMixBytes(h, this->_isBGLayerShown, sizeof(this->_isBGLayerShown));
+	h = GPU_LineSignatureMix(h, this->_targetDisplay->GetColorFormat());
+	h = GPU_LineSignatureMix(h, MMU.paletteGeneration[this->_engineID]);
+	
+	for (size_t layerID = GPULayerID_BG0; layerID <= GPULayerID_BG3; layerID++)
+	{
+		const BGLayerInfo &bgLayer = this->_BGLayer[layerID];
+		if (!this->_isBGLayerShown[layerID] || !bgLayer.isVisible)
+		{
+			continue;
+		}
+		
+		const u32 mapEntryCount = (bgLayer.size.width / 8) * (bgLayer.size.height / 8);
+		const u32 pixelCount = bgLayer.size.width * bgLayer.size.height;
+		
+		switch (bgLayer.type)
+		{
+			case BGType_Text:
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.tileMapAddress, mapEntryCount * sizeof(u16));
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.tileEntryAddress, 1024 * 64);
+				h = GPU_LineSignatureMixMappedVRAM(h, (const u8 *)*bgLayer.extPalette, ADDRESS_STEP_8KB);
+				break;
+				
+			case BGType_Affine:
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.tileMapAddress, mapEntryCount);
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.tileEntryAddress, 256 * 64);
+				break;
+				
+			case BGType_AffineExt_256x16:
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.tileMapAddress, mapEntryCount * sizeof(u16));
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.tileEntryAddress, 1024 * 64);
+				h = GPU_LineSignatureMixMappedVRAM(h, (const u8 *)*bgLayer.extPalette, ADDRESS_STEP_8KB);
+				break;
+				
+			case BGType_AffineExt_256x1:
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.BMPAddress, pixelCount);
+				break;
+				
+			case BGType_AffineExt_Direct:
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.BMPAddress, pixelCount * sizeof(u16));
+				break;
+				
+			case BGType_Large8bpp:
+				h = GPU_LineSignatureMixVRAM(h, bgLayer.largeBMPAddress, pixelCount);
+				break;
+				
+			default:
+				break;
+		}
+	}
+	
+	if (this->_isBGLayerShown[GPULayerID_OBJ])
+	{
+		h = GPU_LineSignatureMix(h, MMU.oamGeneration[this->_engineID]);
+		h = GPU_LineSignatureMixVRAM(h, this->_sprMem, ADDRESS_STEP_256KB);
+		h = GPU_LineSignatureMixMappedVRAM(h, MMU.ObjExtPal[this->_engineID][0], ADDRESS_STEP_8KB);
+	}
+	
+	return (h != 0) ? h : 1;
+}
+
+bool GPUEngineBase::_ReuseLineIfUnchanged(const GPUEngineCompositorInfo &compInfo, u64 &outSignature)
+{
+	outSignature = 0;
+	
+	// Mosaic carries pixels over from earlier lines, and reading back VRAM lines that were captured at a
+	// custom size can change the main engine's capture states. Lines like these always need to be rendered.
+	// (OBJ mosaic also reads the sprite numbers left behind by earlier lines wherever no sprite is drawn,
+	// which reused lines don't update. That lookup is already a rough approximation of the hardware.)
+	bool willRenderLine = !this->_willReuseLines ||
+	                      (compInfo.renderState.isOBJMosaicSet && this->_isBGLayerShown[GPULayerID_OBJ]) ||
+	                      this->_gpuSystem->GetEngineMain()->IsAnyVRAMLineCaptureCustom();
+	
+	if (compInfo.renderState.isBGMosaicSet)
+	{
+		for (size_t layerID = GPULayerID_BG0; layerID <= GPULayerID_BG3; layerID++)
+		{
+			willRenderLine = willRenderLine || (this->_isBGLayerShown[layerID] && this->_BGLayer[layerID].isVisible && this->_BGLayer[layerID].isMosaic);
+		}
+	}
+	
+	if (willRenderLine)
+	{
+		return false;
+	}
+	
+	const size_t l = compInfo.line.indexNative;
+	outSignature = this->_ComputeLineSignature(compInfo);
+	this->_reuseLineCheckCount++;
+	
+	if (outSignature != this->_reuseLineSignature[l])
+	{
+		return false;
+	}
+	
+	memcpy(this->_targetDisplay->GetNativeBuffer16() + compInfo.line.blockOffsetNative, this->_reuseLineNative[l], GPU_FRAMEBUFFER_NATIVE_WIDTH * sizeof(u16));
+	
+	// Rendering the line would have advanced the affine reference points, so do the same here.
+	const BGLayerInfo &bg2 = this->_BGLayer[GPULayerID_BG2];
+	if ( this->_isBGLayerShown[GPULayerID_BG2] && bg2.isVisible &&
+	    ((bg2.baseType == BGType_Affine) || (bg2.baseType == BGType_AffineExt) || (bg2.baseType == BGType_Large8bpp)) )
+	{
+		this->_IORegisterMap->BG2Param.BG2X.value += this->_IORegisterMap->BG2Param.BG2PB.value;
+		this->_IORegisterMap->BG2Param.BG2Y.value += this->_IORegisterMap->BG2Param.BG2PD.value;
+	}
+	
+	const BGLayerInfo &bg3 = this->_BGLayer[GPULayerID_BG3];
+	if ( this->_isBGLayerShown[GPULayerID_BG3] && bg3.isVisible &&
+	    ((bg3.baseType == BGType_Affine) || (bg3.baseType == BGType_AffineExt) || (bg3.baseType == BGType_Large8bpp)) )
+	{
+		this->_IORegisterMap->BG3Param.BG3X.value += this->_IORegisterMap->BG3Param.BG3PB.value;
+		this->_IORegisterMap->BG3Param.BG3Y.value += this->_IORegisterMap->BG3Param.BG3PD.value;
+	}
+	
+	this->_reuseLineHitCount++;
+	return true;
+}
+
+void GPUEngineBase::_SaveLineForReuse(const GPUEngineCompositorInfo &compInfo, const u64 signature)
+{
+	const size_t l = compInfo.line.indexNative;
+	
+	// Lines that went to the custom size (because of the 3D layer or custom VRAM) aren't kept. Lines that
+	// stayed native are resolved to the custom size during postprocessing, so keeping the native line is enough.
+	if ( (signature != 0) && this->_isLineRenderNative[l] )
+	{
+		memcpy(this->_reuseLineNative[l], compInfo.target.lineColorHeadNative, GPU_FRAMEBUFFER_NATIVE_WIDTH * sizeof(u16));
+		this->_reuseLineSignature[l] = signature;
+	}
+	else
+	{
+		this->_reuseLineSignature[l] = 0;
+	}
+}
+
+void GPUEngineBase::GetLineReuseStats(u64 &outCheckCount, u64 &outHitCount) const
+{
+	outCheckCount = this->_reuseLineCheckCount;
+	outHitCount = this->_reuseLineHitCount;
+}
+
+void GPUEngineBase::ResetLineReuseStats()
+{
+	this->_reuseLineCheckCount = 0;
+	this->_reuseLineHitCount = 0;
+}
+
 const GPU_IOREG& GPUEngineBase::GetIORegisterMap() const
 {
 	return *this->_IORegisterMap;
@@ -971,6 +1297,7 @@ void GPUEngineBase::SetLayerEnableState(const size_t layerIndex, bool theState)
 void GPUEngineBase::ApplySettings()
 {
 	this->_enableEngine = CommonSettings.showGpu.screens[this->_engineID];
+	this->_willReuseLines = CommonSettings.gpu_line_reuse;
 	
 	bool needResortBGLayers = ( (this->_enableBGLayer[GPULayerID_BG0] != CommonSettings.dispLayers[this->_engineID][GPULayerID_BG0]) ||
 							    (this->_enableBGLayer[GPULayerID_BG1] != CommonSettings.dispLayers[this->_engineID][GPULayerID_BG1]) ||
@@ -1426,6 +1753,84 @@ void GPUEngineBase::_CompositeVRAMLineDeferred(GPUEngineCompositorInfo &compInfo
 /*****************************************************************************/
 //			BACKGROUND RENDERING -TEXT-
 /*****************************************************************************/
+// Tile rows are unpacked to one palette index per byte, 8 pixels at a time, with the flip applied to the whole row
+// at once. The rows are built in registers, since that is cheaper than looking them up again from memory.
+static FORCEINLINE u64 GPU_UnpackTileRow4bpp(const u8 *__restrict vramRow)
+{
+	// the left pixel of every pair is in the low nibble, and ends up in the lower byte
+	u32 packedRow;
+	memcpy(&packedRow, vramRow, sizeof(u32));
+	
+	u64 row = LE_TO_LOCAL_32(packedRow);
+	row = (row | (row << 16)) & 0x0000FFFF0000FFFFULL;
+	row = (row | (row <<  8)) & 0x00FF00FF00FF00FFULL;
+	row = (row | (row <<  4)) & 0x0F0F0F0F0F0F0F0FULL;
+	
+	return LOCAL_TO_LE_64(row);
+}
+
+static FORCEINLINE u64 GPU_FlipTileRow(const u64 row)
+{
+	return ((row & 0x00000000000000FFULL) << 56) | ((row & 0x000000000000FF00ULL) << 40) |
+	       ((row & 0x0000000000FF0000ULL) << 24) | ((row & 0x00000000FF000000ULL) <<  8) |
+	       ((row & 0x000000FF00000000ULL) >>  8) | ((row & 0x0000FF0000000000ULL) >> 24) |
+	       ((row & 0x00FF000000000000ULL) >> 40) | ((row & 0xFF00000000000000ULL) >> 56);
+}
+
+// writes the 8 palette indices of a tile row to tileColorIdx, left to right as they will be drawn
+static FORCEINLINE void GPU_ReadTileRow4bpp(const u8 *__restrict vramRow, const bool hFlip, u8 *__restrict tileColorIdx)
+{
+	const u64 row = GPU_UnpackTileRow4bpp(vramRow);
+	const u64 drawRow = (hFlip) ? GPU_FlipTileRow(row) : row;
+	memcpy(tileColorIdx, &drawRow, sizeof(u64));
+}
+
+static FORCEINLINE void GPU_ReadTileRow8bpp(const u8 *__restrict vramRow, const bool hFlip, u8 *__restrict tileColorIdx)
+{
+	u64 row;
+	memcpy(&row, vramRow, sizeof(u64));
+	
+	const u64 drawRow = (hFlip) ? GPU_FlipTileRow(row) : row;
+	memcpy(tileColorIdx, &drawRow, sizeof(u64));
+}
+
+// draws up to one tile's worth of pixels from a row of palette indices that are already in drawing order
+template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, bool MOSAIC, bool WILLPERFORMWINDOWTEST, bool WILLDEFERCOMPOSITING>
+FORCEINLINE void GPUEngineBase::_RenderLine_BGTextTileRow(GPUEngineCompositorInfo &compInfo, const size_t x, const size_t pixCount, const u8 *__restrict tileColorIdx, const u16 *__restrict tilePal)
+{
+	if (WILLDEFERCOMPOSITING)
+	{
+		u8 *__restrict dstIndex = this->_deferredIndexNative + x;
+		u16 *__restrict dstColor = this->_deferredColorNative + x;
+		
+		if (pixCount == 8)
+		{
+			memcpy(dstIndex, tileColorIdx, 8);
+			for (size_t i = 0; i < 8; i++)
+			{
+				dstColor[i] = LE_TO_LOCAL_16(tilePal[tileColorIdx[i]]);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < pixCount; i++)
+			{
+				dstIndex[i] = tileColorIdx[i];
+				dstColor[i] = LE_TO_LOCAL_16(tilePal[tileColorIdx[i]]);
+			}
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < pixCount; i++)
+		{
+			const u8 index = tileColorIdx[i];
+			const u16 color = LE_TO_LOCAL_16(tilePal[index]);
+			this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x + i, color, (index != 0));
+		}
+	}
+}
+
 // render a text background to the combined pixelbuffer
 template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, bool MOSAIC, bool WILLPERFORMWINDOWTEST, bool WILLDEFERCOMPOSITING>
 void GPUEngineBase::_RenderLine_BGText(GPUEngineCompositorInfo &compInfo, const u16 XBG, const u16 YBG)
@@ -1451,133 +1856,18 @@ void GPUEngineBase::_RenderLine_BGText(GPUEngineCompositorInfo &compInfo, const
 	{
 		const u16 *__restrict pal = this->_paletteBG;
 		const u16 yoff = (YBG & 0x0007) << 2;
-		u8 index;
-		u16 color;
+		CACHE_ALIGN u8 tileColorIdx[8];
 		
 		for (size_t xfin = pixCountLo; x < lineWidth; xfin = std::min<u16>(x+8, lineWidth))
 		{
 			const TILEENTRY tileEntry = this->_GetTileEntry(map, xoff, wmask);
-			const u16 tilePalette = tileEntry.bits.Palette * 16;
-			u8 *__restrict tileColorIdx = (u8 *)MMU_gpu_map(tile + (tileEntry.bits.TileNum * 0x20) + ((tileEntry.bits.VFlip) ? (7*4)-yoff : yoff));
+			const u16 *__restrict tilePal = pal + (tileEntry.bits.Palette * 16);
+			const u8 *__restrict tileRow = (u8 *)MMU_gpu_map(tile + (tileEntry.bits.TileNum * 0x20) + ((tileEntry.bits.VFlip) ? (7*4)-yoff : yoff));
+			GPU_ReadTileRow4bpp(tileRow, (tileEntry.bits.HFlip != 0), tileColorIdx);
 			
-			if (tileEntry.bits.HFlip)
-			{
-				tileColorIdx += 3 - ((xoff & 0x0007) >> 1);
-				
-				if (xoff & 1)
-				{
-					if (WILLDEFERCOMPOSITING)
-					{
-						this->_deferredIndexNative[x] = *tileColorIdx & 0x0F;
-						this->_deferredColorNative[x] = LE_TO_LOCAL_16(pal[this->_deferredIndexNative[x] + tilePalette]);
-					}
-					else
-					{
-						index = *tileColorIdx & 0x0F;
-						color = LE_TO_LOCAL_16(pal[index + tilePalette]);
-						this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-					}
-					
-					x++;
-					xoff++;
-					tileColorIdx--;
-				}
-				
-				for (; x < xfin; tileColorIdx--)
-				{
-					if (WILLDEFERCOMPOSITING)
-					{
-						this->_deferredIndexNative[x] = *tileColorIdx >> 4;
-						this->_deferredColorNative[x] = LE_TO_LOCAL_16(pal[this->_deferredIndexNative[x] + tilePalette]);
-					}
-					else
-					{
-						index = *tileColorIdx >> 4;
-						color = LE_TO_LOCAL_16(pal[index + tilePalette]);
-						this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-					}
-					
-					x++;
-					xoff++;
-					
-					if (x < xfin)
-					{
-						if (WILLDEFERCOMPOSITING)
-						{
-							this->_deferredIndexNative[x] = *tileColorIdx & 0x0F;
-							this->_deferredColorNative[x] = LE_TO_LOCAL_16(pal[this->_deferredIndexNative[x] + tilePalette]);
-						}
-						else
-						{
-							index = *tileColorIdx & 0x0F;
-							color = LE_TO_LOCAL_16(pal[index + tilePalette]);
-							this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-						}
-						
-						x++;
-						xoff++;
-					}
-				}
-			}
-			else
-			{
-				tileColorIdx += ((xoff & 0x0007) >> 1);
-				
-				if (xoff & 1)
-				{
-					if (WILLDEFERCOMPOSITING)
-					{
-						this->_deferredIndexNative[x] = *tileColorIdx >> 4;
-						this->_deferredColorNative[x] = LE_TO_LOCAL_16(pal[this->_deferredIndexNative[x] + tilePalette]);
-					}
-					else
-					{
-						index = *tileColorIdx >> 4;
-						color = LE_TO_LOCAL_16(pal[index + tilePalette]);
-						this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-					}
-					
-					x++;
-					xoff++;
-					tileColorIdx++;
-				}
-				
-				for (; x < xfin; tileColorIdx++)
-				{
-					if (WILLDEFERCOMPOSITING)
-					{
-						this->_deferredIndexNative[x] = *tileColorIdx & 0x0F;
-						this->_deferredColorNative[x] = LE_TO_LOCAL_16(pal[this->_deferredIndexNative[x] + tilePalette]);
-					}
-					else
-					{
-						index = *tileColorIdx & 0x0F;
-						color = LE_TO_LOCAL_16(pal[index + tilePalette]);
-						this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-					}
-					
-					x++;
-					xoff++;
-					
-					if (x < xfin)
-					{
-						if (WILLDEFERCOMPOSITING)
-						{
-							this->_deferredIndexNative[x] = *tileColorIdx >> 4;
-							this->_deferredColorNative[x] = LE_TO_LOCAL_16(pal[this->_deferredIndexNative[x] + tilePalette]);
-						}
-						else
-						{
-							index = *tileColorIdx >> 4;
-							color = LE_TO_LOCAL_16(pal[index + tilePalette]);
-							this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-						}
-						
-						x++;
-						xoff++;
-					}
-				}
-			}
+			this->_RenderLine_BGTextTileRow<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST, WILLDEFERCOMPOSITING>(compInfo, x, xfin - x, tileColorIdx + (xoff & 0x0007), tilePal);
+			xoff += xfin - x;
+			x = xfin;
 		}
 	}
 	else //256-color BG
@@ -1585,39 +1875,18 @@ void GPUEngineBase::_RenderLine_BGText(GPUEngineCompositorInfo &compInfo, const
 		const u16 *__restrict pal = (DISPCNT.ExBGxPalette_Enable) ? *(compInfo.renderState.selectedBGLayer->extPalette) : this->_paletteBG;
 		const u32 extPalMask = -DISPCNT.ExBGxPalette_Enable;
 		const u16 yoff = (YBG & 0x0007) << 3;
-		size_t line_dir;
+		CACHE_ALIGN u8 tileColorIdx[8];
 		
 		for (size_t xfin = pixCountLo; x < lineWidth; xfin = std::min<u16>(x+8, lineWidth))
 		{
 			const TILEENTRY tileEntry = this->_GetTileEntry(map, xoff, wmask);
 			const u16 *__restrict tilePal = (u16 *)((u8 *)pal + ((tileEntry.bits.Palette<<9) & extPalMask));
-			const u8 *__restrict tileColorIdx = (u8 *)MMU_gpu_map(tile + (tileEntry.bits.TileNum * 0x40) + ((tileEntry.bits.VFlip) ? (7*8)-yoff : yoff));
-			
-			if (tileEntry.bits.HFlip)
-			{
-				tileColorIdx += (7 - (xoff & 0x0007));
-				line_dir = -1;
-			}
-			else
-			{
-				tileColorIdx += (xoff & 0x0007);
-				line_dir = 1;
-			}
+			const u8 *__restrict tileRow = (u8 *)MMU_gpu_map(tile + (tileEntry.bits.TileNum * 0x40) + ((tileEntry.bits.VFlip) ? (7*8)-yoff : yoff));
+			GPU_ReadTileRow8bpp(tileRow, (tileEntry.bits.HFlip != 0), tileColorIdx);
 			
-			for (; x < xfin; x++, xoff++, tileColorIdx += line_dir)
-			{
-				if (WILLDEFERCOMPOSITING)
-				{
-					this->_deferredIndexNative[x] = *tileColorIdx;
-					this->_deferredColorNative[x] = LE_TO_LOCAL_16(tilePal[this->_deferredIndexNative[x]]);
-				}
-				else
-				{
-					const u8 index = *tileColorIdx;
-					const u16 color = LE_TO_LOCAL_16(tilePal[index]);
-					this->_CompositePixelImmediate<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST>(compInfo, x, color, (index != 0));
-				}
-			}
+			this->_RenderLine_BGTextTileRow<COMPOSITORMODE, OUTPUTFORMAT, MOSAIC, WILLPERFORMWINDOWTEST, WILLDEFERCOMPOSITING>(compInfo, x, xfin - x, tileColorIdx + (xoff & 0x0007), tilePal);
+			xoff += xfin - x;
+			x = xfin;
 		}
 	}
 }
@@ -1824,13 +2093,23 @@ void GPUEngineBase::_RenderSprite256(GPUEngineCompositorInfo &compInfo,
 									 const u16 *__restrict palColorBuffer, const OBJMode objMode, const u8 prio, const u8 spriteNum,
 									 u16 *__restrict dst, u8 *__restrict dst_alpha, u8 *__restrict typeTab, u8 *__restrict prioTab)
 {
-	for (size_t i = 0; i < length; i++, frameX++, spriteX+=readXStep)
+	// readXStep is -1 for a flipped sprite, so flip the rows and read them forward
+	const bool hFlip = (readXStep < 0);
+	CACHE_ALIGN u8 tileColorIdx[8];
+	
+	for (size_t i = 0; i < length;)
 	{
-		const u32 palIndexAddress = objAddress + (u32)( (spriteX & 0x0007) + ((spriteX & 0xFFF8) << 3) );
-		const u8 *__restrict palIndexBuffer = (u8 *)MMU_gpu_map(palIndexAddress);
-		const u8 idx8 = *palIndexBuffer;
+		const u8 *__restrict tileRow = (u8 *)MMU_gpu_map(objAddress + (u32)((spriteX & 0xFFF8) << 3));
+		const size_t tileX = (hFlip) ? 7 - (spriteX & 0x0007) : (spriteX & 0x0007);
+		const size_t pixCount = std::min<size_t>(8 - tileX, length - i);
+		GPU_ReadTileRow8bpp(tileRow, hFlip, tileColorIdx);
 		
-		this->_RenderSpriteUpdatePixel<ISDEBUGRENDER, false>(compInfo, frameX, palColorBuffer, idx8, objMode, prio, spriteNum, dst, dst_alpha, typeTab, prioTab);
+		for (size_t p = tileX; p < tileX + pixCount; p++, i++, frameX++)
+		{
+			this->_RenderSpriteUpdatePixel<ISDEBUGRENDER, false>(compInfo, frameX, palColorBuffer, tileColorIdx[p], objMode, prio, spriteNum, dst, dst_alpha, typeTab, prioTab);
+		}
+		
+		spriteX += readXStep * (s32)pixCount;
 	}
 }
 
@@ -1840,15 +2119,23 @@ void GPUEngineBase::_RenderSprite16(GPUEngineCompositorInfo &compInfo,
 									const u16 *__restrict palColorBuffer, const OBJMode objMode, const u8 prio, const u8 spriteNum,
 									u16 *__restrict dst, u8 *__restrict dst_alpha, u8 *__restrict typeTab, u8 *__restrict prioTab)
 {
-	for (size_t i = 0; i < length; i++, frameX++, spriteX+=readXStep)
+	// readXStep is -1 for a flipped sprite, so flip the rows and read them forward
+	const bool hFlip = (readXStep < 0);
+	CACHE_ALIGN u8 tileColorIdx[8];
+	
+	for (size_t i = 0; i < length;)
 	{
-		const u32 spriteX_word = (u32)spriteX >> 1;
-		const u32 palIndexAddress = objAddress + (spriteX_word & 0x0003) + ((spriteX_word & 0xFFFC) << 3);
-		const u8 *__restrict palIndexBuffer = (u8 *)MMU_gpu_map(palIndexAddress);
-		const u8 palIndex = *palIndexBuffer;
-		const u8 idx4 = (spriteX & 1) ? palIndex >> 4 : palIndex & 0x0F;
+		const u8 *__restrict tileRow = (u8 *)MMU_gpu_map(objAddress + (u32)((spriteX & 0xFFF8) << 2));
+		const size_t tileX = (hFlip) ? 7 - (spriteX & 0x0007) : (spriteX & 0x0007);
+		const size_t pixCount = std::min<size_t>(8 - tileX, length - i);
+		GPU_ReadTileRow4bpp(tileRow, hFlip, tileColorIdx);
+		
+		for (size_t p = tileX; p < tileX + pixCount; p++, i++, frameX++)
+		{
+			this->_RenderSpriteUpdatePixel<ISDEBUGRENDER, false>(compInfo, frameX, palColorBuffer, tileColorIdx[p], objMode, prio, spriteNum, dst, dst_alpha, typeTab, prioTab);
+		}
 		
-		this->_RenderSpriteUpdatePixel<ISDEBUGRENDER, false>(compInfo, frameX, palColorBuffer, idx4, objMode, prio, spriteNum, dst, dst_alpha, typeTab, prioTab);
+		spriteX += readXStep * (s32)pixCount;
 	}
 }
 
@@ -3472,6 +3759,14 @@ bool GPUEngineA::WillDisplayCapture(const size_t l)
 	return this->_displayCaptureEnable && (vramConfiguration.banks[DISPCAPCNT.VRAMWriteBlock].purpose == VramConfiguration::LCDC) && (l < this->_dispCapCnt.capy);
 }
 
+bool GPUEngineA::IsAnyVRAMLineCaptureCustom() const
+{
+	return (this->_nativeLineCaptureCount[0] != GPU_VRAM_BLOCK_LINES) ||
+	       (this->_nativeLineCaptureCount[1] != GPU_VRAM_BLOCK_LINES) ||
+	       (this->_nativeLineCaptureCount[2] != GPU_VRAM_BLOCK_LINES) ||
+	       (this->_nativeLineCaptureCount[3] != GPU_VRAM_BLOCK_LINES);
+}
+
 void GPUEngineA::SetDisplayCaptureEnable()
 {
 	this->_displayCaptureEnable = (this->_IORegisterMap->DISPCAPCNT.CaptureEnable != 0);
@@ -3523,13 +3818,22 @@ void GPUEngineA::RenderLine(const size_t l)
 	// Render the line
 	if ( (compInfo.renderState.displayOutputMode == GPUDisplayMode_Normal) || isDisplayCaptureNeeded )
 	{
-		if (compInfo.renderState.isAnyWindowEnabled)
-		{
-			this->_RenderLine_Layers<OUTPUTFORMAT, true>(compInfo);
-		}
-		else
+		// Only a line that goes straight to the display can be reused, and never one that shows the 3D layer.
+		const bool canReuseLine = (compInfo.renderState.displayOutputMode == GPUDisplayMode_Normal) && !isDisplayCaptureNeeded && !this->IsForceBlankSet() && !this->WillRender3DLayer();
+		u64 lineSignature = 0;
+		
+		if ( !canReuseLine || !this->_ReuseLineIfUnchanged(compInfo, lineSignature) )
 		{
-			this->_RenderLine_Layers<OUTPUTFORMAT, false>(compInfo);
+			if (compInfo.renderState.isAnyWindowEnabled)
+			{
+				this->_RenderLine_Layers<OUTPUTFORMAT, true>(compInfo);
+			}
+			else
+			{
+				this->_RenderLine_Layers<OUTPUTFORMAT, false>(compInfo);
+			}
+			
+			this->_SaveLineForReuse(compInfo, lineSignature);
 		}
 	}
 	
@@ -3876,6 +4180,7 @@ void GPUEngineA::_RenderLine_DisplayCapture(const GPUEngineCompositorInfo &compI
 	const void *srcAPtr;
 	const void *srcBPtr;
 	u16 *dstNative16 = this->_VRAMNativeBlockPtr[DISPCAPCNT.VRAMWriteBlock] + dstNativeOffset;
+	MMU_VRAMMarkWritten(dstNative16, CAPTURELENGTH * sizeof(u16));
 	
 	if (!willWriteVRAMLineNative)
 	{
@@ -4577,13 +4882,20 @@ void GPUEngineB::RenderLine(const size_t l)
 			
 			case GPUDisplayMode_Normal: // Display BG and OBJ layers
 			{
-				if (compInfo.renderState.isAnyWindowEnabled)
-				{
-					this->_RenderLine_Layers<OUTPUTFORMAT, true>(compInfo);
-				}
-				else
+				u64 lineSignature = 0;
+				
+				if (!this->_ReuseLineIfUnchanged(compInfo, lineSignature))
 				{
-					this->_RenderLine_Layers<OUTPUTFORMAT, false>(compInfo);
+					if (compInfo.renderState.isAnyWindowEnabled)
+					{
+						this->_RenderLine_Layers<OUTPUTFORMAT, true>(compInfo);
+					}
+					else
+					{
+						this->_RenderLine_Layers<OUTPUTFORMAT, false>(compInfo);
+					}
+					
+					this->_SaveLineForReuse(compInfo, lineSignature);
 				}
 				
 				this->_HandleDisplayModeNormal(l);
@@ -4625,7 +4937,7 @@ GPUSubsystem::GPUSubsystem()
 	if (CommonSettings.num_cores > 1)
 	{
 		_asyncEngineBufferSetupTask = new Task;
-		_asyncEngineBufferSetupTask->start(false, 0, "setup gpu bufs");
+		_asyncEngineBufferSetupTask->start(TaskGroup_GPU, false);
 	}
 	else
 	{
@@ -4634,6 +4946,15 @@ GPUSubsystem::GPUSubsystem()
 	
 	_asyncEngineBufferSetupIsRunning = false;
 	
+	_asyncEngineSubRenderTask = NULL;
+	_asyncEngineSubRenderIsRunning = false;
+	_asyncEngineSubRenderLine = 0;
+	_willRenderEngineSubAsync = false;
+	
+	_deferredLineFirst = 0;
+	_deferredLineCount = 0;
+	_willDeferRenderLines = false;
+	
 	_pending3DRendererID = RENDERID_NULL;
 	_needChange3DRenderer = false;
 	
@@ -4701,6 +5022,13 @@ GPUSubsystem::~GPUSubsystem()
 		this->_asyncEngineBufferSetupTask = NULL;
 	}
 	
+	if (this->_asyncEngineSubRenderTask != NULL)
+	{
+		this->AsyncRenderLineEngineSubFinish();
+		delete this->_asyncEngineSubRenderTask;
+		this->_asyncEngineSubRenderTask = NULL;
+	}
+	
 	free_aligned(this->_masterFramebuffer);
 	free_aligned(this->_masterWorkingNativeBuffer32);
 	free_aligned(this->_customVRAM);
@@ -4762,6 +5090,8 @@ GPUEventHandler* GPUSubsystem::GetEventHandler()
 
 void GPUSubsystem::Reset()
 {
+	this->AsyncRenderLineEngineSubFinish();
+	this->_deferredLineCount = 0;
 	this->_engineMain->RenderLineClearAsyncFinish();
 	this->_engineSub->RenderLineClearAsyncFinish();
 	this->AsyncSetupEngineBuffersFinish();
@@ -4819,12 +5149,15 @@ void GPUSubsystem::Reset()
 
 void GPUSubsystem::ForceRender3DFinishAndFlush(bool willFlush)
 {
+	NDSPerfScope perfScope(NDSPerfSection_3D);
 	CurrentRenderer->RenderFinish();
 	CurrentRenderer->RenderFlush(willFlush, willFlush);
 }
 
 void GPUSubsystem::ForceFrameStop()
 {
+	this->FinishPendingLineRender();
+	
 	if (CurrentRenderer->GetRenderNeedsFinish())
 	{
 		this->ForceRender3DFinishAndFlush(true);
@@ -5432,8 +5765,168 @@ void GPUSubsystem::AsyncSetupEngineBuffersFinish()
 	this->_asyncEngineBufferSetupIsRunning = false;
 }
 
+void* GPUSubsystem_AsyncRenderLineEngineSub(void *arg)
+{
+	GPUSubsystem *gpuSubystem = (GPUSubsystem *)arg;
+	gpuSubystem->RenderLineEngineSubAsync();
+	
+	return NULL;
+}
+
+void GPUSubsystem::RenderLineEngineSubAsync()
+{
+	this->_RenderLineEngineSub(this->_asyncEngineSubRenderLine);
+}
+
+void GPUSubsystem::AsyncRenderLineEngineSubStart(const size_t l)
+{
+	if (this->_asyncEngineSubRenderTask == NULL)
+	{
+		return;
+	}
+	
+	this->AsyncRenderLineEngineSubFinish();
+	this->_asyncEngineSubRenderLine = l;
+	this->_asyncEngineSubRenderTask->execute(&GPUSubsystem_AsyncRenderLineEngineSub, this);
+	this->_asyncEngineSubRenderIsRunning = true;
+}
+
+void GPUSubsystem::AsyncRenderLineEngineSubFinish()
+{
+	if (!this->_asyncEngineSubRenderIsRunning)
+	{
+		return;
+	}
+	
+	this->_asyncEngineSubRenderTask->finish();
+	this->_asyncEngineSubRenderIsRunning = false;
+}
+
+void GPUSubsystem::_RenderLineEngineMain(const size_t l)
+{
+	switch (this->_engineMain->GetTargetDisplay()->GetColorFormat())
+	{
+		case NDSColorFormat_BGR555_Rev:
+			this->_engineMain->RenderLine<NDSColorFormat_BGR555_Rev>(l);
+			break;
+			
+		case NDSColorFormat_BGR666_Rev:
+			this->_engineMain->RenderLine<NDSColorFormat_BGR666_Rev>(l);
+			break;
+			
+		case NDSColorFormat_BGR888_Rev:
+			this->_engineMain->RenderLine<NDSColorFormat_BGR888_Rev>(l);
+			break;
+	}
+}
+
+void GPUSubsystem::_RenderLineEngineSub(const size_t l)
+{
+	switch (this->_engineSub->GetTargetDisplay()->GetColorFormat())
+	{
+		case NDSColorFormat_BGR555_Rev:
+			this->_engineSub->RenderLine<NDSColorFormat_BGR555_Rev>(l);
+			break;
+			
+		case NDSColorFormat_BGR666_Rev:
+			this->_engineSub->RenderLine<NDSColorFormat_BGR666_Rev>(l);
+			break;
+			
+		case NDSColorFormat_BGR888_Rev:
+			this->_engineSub->RenderLine<NDSColorFormat_BGR888_Rev>(l);
+			break;
+	}
+}
+
+void* GPUSubsystem_RenderDeferredLinesEngineSub(void *arg)
+{
+	GPUSubsystem *gpuSubystem = (GPUSubsystem *)arg;
+	gpuSubystem->RenderDeferredLinesEngineSub();
+	
+	return NULL;
+}
+
+void GPUSubsystem::_RenderDeferredLinesEngineMain()
+{
+	const size_t lastLine = this->_deferredLineFirst + this->_deferredLineCount - 1;
+	
+	this->_engineMain->RenderDeferredLinesStart();
+	
+	for (size_t l = this->_deferredLineFirst; l <= lastLine; l++)
+	{
+		if (this->_engineMain->RenderDeferredLinesApplyLine(l, (l == this->_deferredLineFirst)))
+		{
+			this->_RenderLineEngineMain(l);
+		}
+		else
+		{
+			this->_engineMain->UpdatePropertiesWithoutRender(l);
+		}
+	}
+	
+	this->_engineMain->RenderDeferredLinesFinish(lastLine);
+}
+
+void GPUSubsystem::RenderDeferredLinesEngineSub()
+{
+	const size_t lastLine = this->_deferredLineFirst + this->_deferredLineCount - 1;
+	
+	this->_engineSub->RenderDeferredLinesStart();
+	
+	for (size_t l = this->_deferredLineFirst; l <= lastLine; l++)
+	{
+		if (this->_engineSub->RenderDeferredLinesApplyLine(l, (l == this->_deferredLineFirst)))
+		{
+			this->_RenderLineEngineSub(l);
+		}
+		else
+		{
+			this->_engineSub->UpdatePropertiesWithoutRender(l);
+		}
+	}
+	
+	this->_engineSub->RenderDeferredLinesFinish(lastLine);
+}
+
+void GPUSubsystem::DeferredRenderLinesFlush()
+{
+	if (this->_deferredLineCount == 0)
+	{
+		return;
+	}
+	
+	// The two engines don't share any working state, so they can render their queued lines at the
+	// same time. Each engine's lines still have to be rendered in order, since every line builds on
+	// the affine, window and mosaic state left behind by the line before it.
+	if (this->_asyncEngineSubRenderTask != NULL)
+	{
+		this->AsyncRenderLineEngineSubFinish();
+		this->_asyncEngineSubRenderTask->execute(&GPUSubsystem_RenderDeferredLinesEngineSub, this);
+		this->_asyncEngineSubRenderIsRunning = true;
+		
+		this->_RenderDeferredLinesEngineMain();
+		this->AsyncRenderLineEngineSubFinish();
+	}
+	else
+	{
+		this->_RenderDeferredLinesEngineMain();
+		this->RenderDeferredLinesEngineSub();
+	}
+	
+	this->_deferredLineCount = 0;
+}
+
+void GPUSubsystem::FinishPendingLineRender()
+{
+	this->AsyncRenderLineEngineSubFinish();
+	this->DeferredRenderLinesFlush();
+}
+
 void GPUSubsystem::RenderLine(const size_t l)
 {
+	// The sub engine may still be working on the previous line.
+	this->AsyncRenderLineEngineSubFinish();
+	
 	if (!this->_frameNeedsFinish)
 	{
 		this->_event->DidApplyGPUSettingsBegin();
@@ -5447,6 +5940,15 @@ void GPUSubsystem::RenderLine(const size_t l)
 		
 		this->_ApplyFramebufferSettings();
 		
+		if ( (CommonSettings.gpu_async_sub_engine || CommonSettings.gpu_deferred_2d) && (CommonSettings.num_cores > 1) && (this->_asyncEngineSubRenderTask == NULL) )
+		{
+			this->_asyncEngineSubRenderTask = new Task;
+			this->_asyncEngineSubRenderTask->start(TaskGroup_GPU, true);
+		}
+		
+		this->_willDeferRenderLines = CommonSettings.gpu_deferred_2d;
+		this->_willRenderEngineSubAsync = CommonSettings.gpu_async_sub_engine && !this->_willDeferRenderLines && (this->_asyncEngineSubRenderTask != NULL);
+		
 		this->_event->DidApplyGPUSettingsEnd();
 		
 		this->_event->DidFrameBegin(l, this->_willFrameSkip, this->_displayInfo.framebufferPageCount, this->_displayInfo.bufferIndex);
@@ -5484,7 +5986,37 @@ void GPUSubsystem::RenderLine(const size_t l)
 		this->_engineSub->UpdateRenderStates(l);
 	}
 	
-	if ( (isFramebufferRenderNeeded[GPUEngineID_Main] || this->_engineMain->IsForceBlankSet() || isDisplayCaptureNeeded) && !this->_willFrameSkip )
+	const bool willRenderEngineMain = (isFramebufferRenderNeeded[GPUEngineID_Main] || this->_engineMain->IsForceBlankSet() || isDisplayCaptureNeeded) && !this->_willFrameSkip;
+	const bool willRenderEngineSub = (isFramebufferRenderNeeded[GPUEngineID_Sub] || this->_engineSub->IsForceBlankSet()) && !this->_willFrameSkip;
+	
+	// Display capture writes to VRAM and main memory display consumes the display FIFO, so those
+	// lines need to happen right now. The same goes for any line that could read back VRAM lines
+	// captured at a custom size, since doing so updates the main engine's capture line states.
+	const bool willDeferLine = this->_willDeferRenderLines &&
+	                           !this->_willFrameSkip &&
+	                           !isDisplayCaptureNeeded &&
+	                           (this->_engineMain->GetIORegisterMap().DISPCNT.DisplayMode != GPUDisplayMode_MainMemory) &&
+	                           !this->_engineMain->IsAnyVRAMLineCaptureCustom();
+	
+	// The sub engine can read back VRAM lines that the main engine captured at a custom size, and
+	// doing so updates the main engine's capture line states. Keep both engines on this thread for
+	// any line where capture state could be touched by either of them.
+	const bool willRenderEngineSubAsync = willRenderEngineSub &&
+	                                      this->_willRenderEngineSubAsync &&
+	                                      !isDisplayCaptureNeeded &&
+	                                      !this->_engineMain->IsAnyVRAMLineCaptureCustom();
+	
+	if (!willDeferLine)
+	{
+		this->DeferredRenderLinesFlush();
+	}
+	
+	if (willRenderEngineSubAsync)
+	{
+		this->AsyncRenderLineEngineSubStart(l);
+	}
+	
+	if (willRenderEngineMain)
 	{
 		// GPUEngineA:WillRender3DLayer() and GPUEngineA:WillCapture3DLayerDirect() both rely on register
 		// states that might change on a per-line basis. Therefore, we need to check these states on a
@@ -5501,6 +6033,8 @@ void GPUSubsystem::RenderLine(const size_t l)
 		
 		if (need3DCaptureFramebuffer || need3DDisplayFramebuffer)
 		{
+			NDSPerfScope perfScope(NDSPerfSection_3D);
+			
 			if (CurrentRenderer->GetRenderNeedsFinish())
 			{
 				CurrentRenderer->RenderFinish();
@@ -5511,51 +6045,47 @@ void GPUSubsystem::RenderLine(const size_t l)
 			CurrentRenderer->RenderFlush(need3DDisplayFramebuffer && CurrentRenderer->GetRenderNeedsFlushMain(),
 			                             need3DCaptureFramebuffer && CurrentRenderer->GetRenderNeedsFlush16());
 		}
-		
-		switch (this->_engineMain->GetTargetDisplay()->GetColorFormat())
-		{
-			case NDSColorFormat_BGR555_Rev:
-				this->_engineMain->RenderLine<NDSColorFormat_BGR555_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR666_Rev:
-				this->_engineMain->RenderLine<NDSColorFormat_BGR666_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR888_Rev:
-				this->_engineMain->RenderLine<NDSColorFormat_BGR888_Rev>(l);
-				break;
-		}
-	}
-	else
-	{
-		this->_engineMain->UpdatePropertiesWithoutRender(l);
 	}
 	
-	if ( (isFramebufferRenderNeeded[GPUEngineID_Sub] || this->_engineSub->IsForceBlankSet()) && !this->_willFrameSkip)
+	if (willDeferLine)
 	{
-		switch (this->_engineSub->GetTargetDisplay()->GetColorFormat())
+		if (this->_deferredLineCount == 0)
 		{
-			case NDSColorFormat_BGR555_Rev:
-				this->_engineSub->RenderLine<NDSColorFormat_BGR555_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR666_Rev:
-				this->_engineSub->RenderLine<NDSColorFormat_BGR666_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR888_Rev:
-				this->_engineSub->RenderLine<NDSColorFormat_BGR888_Rev>(l);
-				break;
+			this->_deferredLineFirst = l;
 		}
+		
+		this->_engineMain->RecordDeferredLine(l, willRenderEngineMain);
+		this->_engineSub->RecordDeferredLine(l, willRenderEngineSub);
+		this->_deferredLineCount++;
 	}
 	else
 	{
-		this->_engineSub->UpdatePropertiesWithoutRender(l);
+		if (willRenderEngineMain)
+		{
+			this->_RenderLineEngineMain(l);
+		}
+		else
+		{
+			this->_engineMain->UpdatePropertiesWithoutRender(l);
+		}
+		
+		if (willRenderEngineSub)
+		{
+			if (!willRenderEngineSubAsync)
+			{
+				this->_RenderLineEngineSub(l);
+			}
+		}
+		else
+		{
+			this->_engineSub->UpdatePropertiesWithoutRender(l);
+		}
 	}
 	
 	if (l == 191)
 	{
+		this->FinishPendingLineRender();
+		
 		this->_engineMain->LastLineProcess();
 		this->_engineSub->LastLineProcess();
 		
@@ -5792,6 +6322,8 @@ void GPUSubsystem::_ConvertAndUpscaleForLoadstate(const NDSDisplayID displayID,
 
 void GPUSubsystem::SaveState(EMUFILE &os)
 {
+	this->FinishPendingLineRender();
+	
 	// Savestate chunk version
 	os.write_32LE(2);
 	
@@ -1359,6 +1359,21 @@ typedef struct
 	GPUEngineTargetState target;
 } GPUEngineCompositorInfo;
 
+// Everything an engine reads from its registers while rendering a line, as it stood when that
+// line was reached. Used to render lines after the fact when deferred rendering is enabled.
+typedef struct
+{
+	GPU_IOREG IORegisterMap;
+	
+	BGLayerInfo BGLayer[4];
+	bool isBGLayerShown[5];
+	bool isAnyBGLayerShown;
+	u8 BGsForPriority[NB_PRIORITIES][NB_BG];
+	u8 nbBGsForPriority[NB_PRIORITIES];
+	
+	bool willRender;
+} GPUEngineLineState;
+
 class GPUSubsystem;
 
 class GPUEngineBase
@@ -1462,6 +1477,18 @@ protected:
 	IOREG_WIN_COORD _prevWINCoord;
 	IOREG_WIN_CTRL _prevWINCtrl;
 	
+	GPUEngineLineState _deferredLineState[GPU_FRAMEBUFFER_NATIVE_HEIGHT];
+	GPUEngineLineState _liveLineState;
+	GPU_IOREG *_liveIORegisterMap;
+	
+	// When line reuse is enabled, each line rendered at the native size is kept here along with a
+	// signature of everything it was rendered from. A signature of 0 means that the line has nothing kept.
+	CACHE_ALIGN u16 _reuseLineNative[GPU_FRAMEBUFFER_NATIVE_HEIGHT][GPU_FRAMEBUFFER_NATIVE_WIDTH];
+	u64 _reuseLineSignature[GPU_FRAMEBUFFER_NATIVE_HEIGHT];
+	bool _willReuseLines;
+	u64 _reuseLineCheckCount;
+	u64 _reuseLineHitCount;
+	
 	Task *_asyncClearTask;
 	bool _asyncClearIsRunning;
 	u8 _asyncClearTransitionedLineFromBackdropCount;
@@ -1472,6 +1499,8 @@ protected:
 	bool _asyncClearUseInternalCustomBuffer; // Do not modify this variable directly.
 	
 	void _ResortBGLayers();
+	void _SaveLineState(GPUEngineLineState &state) const;
+	void _LoadLineState(const GPUEngineLineState &state);
 	
 	template<NDSColorFormat OUTPUTFORMAT> void _TransitionLineNativeToCustom(GPUEngineCompositorInfo &compInfo);
 	
@@ -1497,6 +1526,7 @@ protected:
 	template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, GPULayerType LAYERTYPE, bool WILLPERFORMWINDOWTEST> size_t _CompositeVRAMLineDeferred_LoopOp(GPUEngineCompositorInfo &compInfo, const u8 *__restrict windowTestPtr, const u8 *__restrict colorEffectEnablePtr, const void *__restrict vramColorPtr);
 	
 	template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, bool MOSAIC, bool WILLPERFORMWINDOWTEST, bool WILLDEFERCOMPOSITING> void _RenderLine_BGText(GPUEngineCompositorInfo &compInfo, const u16 XBG, const u16 YBG);
+	template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, bool MOSAIC, bool WILLPERFORMWINDOWTEST, bool WILLDEFERCOMPOSITING> void _RenderLine_BGTextTileRow(GPUEngineCompositorInfo &compInfo, const size_t x, const size_t pixCount, const u8 *__restrict tileColorIdx, const u16 *__restrict tilePal);
 	template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, bool MOSAIC, bool WILLPERFORMWINDOWTEST, bool WILLDEFERCOMPOSITING> void _RenderLine_BGAffine(GPUEngineCompositorInfo &compInfo, const IOREG_BGnParameter &param);
 	template<GPUCompositorMode COMPOSITORMODE, NDSColorFormat OUTPUTFORMAT, bool MOSAIC, bool WILLPERFORMWINDOWTEST, bool WILLDEFERCOMPOSITING> void _RenderLine_BGExtended(GPUEngineCompositorInfo &compInfo, const IOREG_BGnParameter &param, bool &outUseCustomVRAM);
 	
@@ -1508,6 +1538,10 @@ protected:
 	void _RenderLine_SetupSprites(GPUEngineCompositorInfo &compInfo);
 	template<NDSColorFormat OUTPUTFORMAT, bool WILLPERFORMWINDOWTEST> void _RenderLine_Layers(GPUEngineCompositorInfo &compInfo);
 	
+	u64 _ComputeLineSignature(const GPUEngineCompositorInfo &compInfo) const;
+	bool _ReuseLineIfUnchanged(const GPUEngineCompositorInfo &compInfo, u64 &outSignature);
+	void _SaveLineForReuse(const GPUEngineCompositorInfo &compInfo, const u64 signature);
+	
 	void _RenderLineBlank(const size_t l);
 	
 	void _HandleDisplayModeOff(const size_t l);
@@ -1572,6 +1606,14 @@ public:
 	void UpdatePropertiesWithoutRender(const u16 l);
 	void LastLineProcess();
 	
+	void RecordDeferredLine(const size_t l, const bool willRender);
+	void RenderDeferredLinesStart();
+	bool RenderDeferredLinesApplyLine(const size_t l, const bool isFirstLine);
+	void RenderDeferredLinesFinish(const size_t lastLine);
+	
+	void GetLineReuseStats(u64 &outCheckCount, u64 &outHitCount) const;
+	void ResetLineReuseStats();
+	
 	IOREG_BG2X savedBG2X;
 	IOREG_BG2Y savedBG2Y;
 	IOREG_BG3X savedBG3X;
@@ -1687,6 +1729,7 @@ public:
 	bool WillRender3DLayer();
 	bool WillCapture3DLayerDirect(const size_t l);
 	bool WillDisplayCapture(const size_t l);
+	bool IsAnyVRAMLineCaptureCustom() const;
 	void SetDisplayCaptureEnable();
 	void ResetDisplayCaptureEnable();
 	bool VerifyVRAMLineDidChange(const size_t blockID, const size_t l);
@@ -1847,6 +1890,15 @@ private:
 	Task *_asyncEngineBufferSetupTask;
 	bool _asyncEngineBufferSetupIsRunning;
 	
+	Task *_asyncEngineSubRenderTask;
+	bool _asyncEngineSubRenderIsRunning;
+	size_t _asyncEngineSubRenderLine;
+	bool _willRenderEngineSubAsync;
+	
+	size_t _deferredLineFirst;
+	size_t _deferredLineCount;
+	bool _willDeferRenderLines;
+	
 	int _pending3DRendererID;
 	bool _needChange3DRenderer;
 	
@@ -1869,6 +1921,9 @@ private:
 	NDSDisplayInfo _displayInfo;
 	
 	void _UpdateFPSRender3D();
+	void _RenderLineEngineMain(const size_t l);
+	void _RenderLineEngineSub(const size_t l);
+	void _RenderDeferredLinesEngineMain();
 	void _AllocateFramebuffers(NDSColorFormat outputFormat, size_t w, size_t h, size_t pageCount);
 	void _ApplyFramebufferSettings();
 	
@@ -1957,6 +2012,31 @@ public:
 	void AsyncSetupEngineBuffersStart();
 	void AsyncSetupEngineBuffersFinish();
 	
+	// When CommonSettings.gpu_async_sub_engine is enabled, the sub engine renders each of its lines
+	// on a worker thread while the main engine and the emulation core keep running. Any code that
+	// changes the sub engine's inputs (its I/O registers, VRAM mapping, palette, OAM or VRAM) must
+	// call AsyncRenderLineEngineSubFinish() before making the change. The MMU write handlers already
+	// do this for guest memory writes.
+	void AsyncRenderLineEngineSubStart(const size_t l);
+	void AsyncRenderLineEngineSubFinish();
+	bool IsAsyncRenderLineEngineSubRunning() const { return this->_asyncEngineSubRenderIsRunning; }
+	void RenderLineEngineSubAsync();
+	
+	// When CommonSettings.gpu_deferred_2d is enabled, RenderLine() only records each line's register
+	// state, and the queued lines are rendered in one batch at line 191, with each engine on its own
+	// thread. The batch is rendered early whenever something that isn't recorded per line is about to
+	// change (VRAM, palette, OAM, the VRAM mapping, the affine reference points, or display capture
+	// settings) -- the MMU write handlers take care of this -- and before any line that needs display
+	// capture or main memory display, which are always rendered immediately.
+	void DeferredRenderLinesFlush();
+	bool IsDeferredRenderLinePending() const { return (this->_deferredLineCount != 0); }
+	void RenderDeferredLinesEngineSub();
+	
+	// Finishes all outstanding 2D rendering, whether asynchronous or deferred. Call this before
+	// reading or saving anything the 2D engines write to, such as the framebuffers or the affine
+	// BG registers.
+	void FinishPendingLineRender();
+	
 	void RenderLine(const size_t l);
 	void UpdateAverageBacklightIntensityTotal();
 	void ClearWithColor(const u16 colorBGRA5551);
@@ -786,6 +786,35 @@ void MMU_VRAM_unmap_all()
 		MMU.texInfo.textureSlotAddr[i] = MMU.blank_memory;
 }
 
+//marks the page of an address returned by MMU_LCDmap() as written to, if the address is in VRAM
+static FORCEINLINE void MMU_VRAMMarkWrittenLCDC(const u32 lcdcAddr)
+{
+	if ((lcdcAddr >> 24) == 0x06)
+		MMU.vramPageGeneration[(lcdcAddr - LCDC_HACKY_LOCATION) >> VRAM_GENERATION_PAGE_SHIFT]++;
+}
+
+//marks the palette block of an ARM9 address as written to, if the address is in palette memory
+static FORCEINLINE void MMU_PaletteMarkWritten(const u32 adr)
+{
+	if ((adr >> 24) == 0x05)
+		MMU.paletteGeneration[(adr >> 10) & 1]++;
+}
+
+void MMU_VRAMMarkAllWritten()
+{
+	for (size_t i = 0; i < sizeof(MMU.vramPageGeneration)/sizeof(u32); i++)
+		MMU.vramPageGeneration[i]++;
+	for (size_t i = 0; i < 6; i++)
+		MMU.texPalSlotGeneration[i]++;
+	for (size_t i = 0; i < 4; i++)
+		MMU.textureSlotGeneration[i]++;
+	for (size_t i = 0; i < 2; i++)
+	{
+		MMU.paletteGeneration[i]++;
+		MMU.oamGeneration[i]++;
+	}
+}
+
 static inline void MMU_VRAMmapControl(u8 block, u8 VRAMBankCnt)
 {
 	//handle WRAM, first of all
@@ -836,6 +865,19 @@ static inline void MMU_VRAMmapControl(u8 block, u8 VRAMBankCnt)
 	//if texInfo changed, trigger notifications
 	if(memcmp(&oldTexInfo,&MMU.texInfo,sizeof(MMU_struct::TextureInfo)))
 	{
+		//bump the generations of the remapped slots so that the texture cache knows to recheck them
+		for (size_t i = 0; i < 6; i++)
+		{
+			if (oldTexInfo.texPalSlot[i] != MMU.texInfo.texPalSlot[i])
+				MMU.texPalSlotGeneration[i]++;
+		}
+		
+		for (size_t i = 0; i < 4; i++)
+		{
+			if (oldTexInfo.textureSlotAddr[i] != MMU.texInfo.textureSlotAddr[i])
+				MMU.textureSlotGeneration[i]++;
+		}
+		
 		//if(!nds.isIn3dVblank())
 	//		PROGINFO("Changing texture or texture palette mappings outside of 3d vblank\n");
 		CurrentRenderer->VramReconfigureSignal();
@@ -1005,6 +1047,7 @@ void MMU_Reset()
 	T1WriteWord(MMU.ARM7_REG, 0x304, 0x0001);
 	
 	MMU_VRAM_unmap_all();
+	MMU_VRAMMarkAllWritten();
 
 	MMU.powerMan_CntReg = 0x00;
 	MMU.powerMan_CntRegWritten = FALSE;
@@ -1064,7 +1107,7 @@ static void execsqrt() {
 	MMU.sqrtCycles = nds_timer + 26;
 	MMU.sqrtResult = ret;
 	MMU.sqrtRunning = TRUE;
-	NDS_Reschedule();
+	NDS_RescheduleSqrt();
 }
 
 static void execdiv() {
@@ -1136,7 +1179,7 @@ static void execdiv() {
 	MMU.divResult = res;
 	MMU.divMod = mod;
 	MMU.divRunning = TRUE;
-	NDS_Reschedule();
+	NDS_RescheduleDivider();
 }
 
 DSI_TSC::DSI_TSC()
@@ -2277,6 +2320,144 @@ void DmaController::exec()
 	driver->DEBUG_UpdateIORegView(BaseDriver::EDEBUG_IOREG_DMA);
 }
 
+static FORCEINLINE void MMU_ARM9_SyncGPULineRender(const u32 adr);
+
+//true if a range touches the ARM9 DTCM, which DMA can't see
+static FORCEINLINE bool DMA_OverlapsDTCM(const u32 adr, const u32 len)
+{
+	return ((adr & ~0x3FFF) <= MMU.DTCMRegion) && (MMU.DTCMRegion <= ((adr + len - 1) & ~0x3FFF));
+}
+
+//copies a whole DMA transfer at once when both ends are plain memory, so that no single word of it can have
+//a side effect. the source has to be main memory with incrementing or fixed addressing, and the destination
+//has to be incrementing main memory or, for the ARM9, palette, VRAM or OAM. whatever the per-word writes would
+//have notified (the JIT, the SPU, the 2D line renderer, the VRAM generations) is notified once for the range.
+//returns false without doing anything if the transfer doesn't qualify; the caller then copies word by word.
+template<int PROCNUM>
+static bool DMA_CopyBulk(const u32 src, const u32 dst, const u32 todo, const u32 sz, const u32 srcinc, const u32 dstinc)
+{
+	if (todo == 0 || dstinc != sz || (srcinc != sz && srcinc != 0)) return false;
+	if (((src | dst) & (sz - 1)) != 0 || ((src | dst) >> 28) != 0) return false;
+
+	//anything watching individual accesses needs the generic path
+	if (!memReadBreakPoints.empty() || !memWriteBreakPoints.empty()) return false;
+	if (CheckDebugEvent(DEBUG_EVENT_READ) || CheckDebugEvent(DEBUG_EVENT_WRITE)) return false;
+#ifdef HAVE_LUA
+	if (hookedRegions[LUAMEMHOOK_READ].NotEmpty() || hookedRegions[LUAMEMHOOK_WRITE].NotEmpty()) return false;
+#endif
+#ifdef TARGET_INTERFACE
+	return false;
+#endif
+
+	const u32 len = todo * sz;
+	if (len / sz != todo || ((dst + len - 1) >> 24) != (dst >> 24)) return false;
+
+	const u32 srcLen = (srcinc == 0) ? sz : len;
+	const u32 srcOfs = src & _MMU_MAIN_MEM_MASK;
+	if ((src >> 24) != 0x02 || srcOfs + srcLen > _MMU_MAIN_MEM_MASK + 1) return false;
+	if (PROCNUM == ARMCPU_ARM9 && DMA_OverlapsDTCM(src, srcLen)) return false;
+	const u8 *srcPtr = MMU.MAIN_MEM + srcOfs;
+
+	switch (dst >> 24)
+	{
+		case 0x02:
+		{
+			const u32 dstOfs = dst & _MMU_MAIN_MEM_MASK;
+			if (dstOfs + len > _MMU_MAIN_MEM_MASK + 1) return false;
+			if (PROCNUM == ARMCPU_ARM9 && DMA_OverlapsDTCM(dst, len)) return false;
+			//a forward copy onto itself would re-read what it just wrote. a fill can't notice.
+			if (srcinc != 0 && dstOfs > srcOfs && dstOfs - srcOfs < len) return false;
+
+#ifdef HAVE_JIT
+			for (u32 i = 0; i < len; i += 2)
+				JIT_COMPILED_FUNC_KNOWNBANK(dst + i, MAIN_MEM, _MMU_MAIN_MEM_MASK, 0) = 0;
+#endif
+			SPU_WatchMainWriteRange(dstOfs, len);
+
+			u8 *dstPtr = MMU.MAIN_MEM + dstOfs;
+			if (srcinc != 0)
+				memmove(dstPtr, srcPtr, len);
+			else
+				for (u32 i = 0; i < len; i += sz)
+					memcpy(dstPtr + i, srcPtr, sz);
+			return true;
+		}
+
+		case 0x05: // Palette
+		case 0x06: // VRAM
+		case 0x07: // OAM
+		{
+			if (PROCNUM != ARMCPU_ARM9) return false;
+
+			//the sub engine's palette, OAM or VRAM can lie anywhere inside the range, not just at its ends,
+			//so rather than testing every address let its line finish. this also flushes deferred lines.
+			GPU->AsyncRenderLineEngineSubFinish();
+			MMU_ARM9_SyncGPULineRender(dst);
+
+			//VRAM is mapped in 16KB pages, so walk the range in pieces that stay within one page and one mirror
+			for (u32 done = 0; done < len; )
+			{
+				const u32 adr = dst + done;
+				u32 chunk = std::min<u32>(len - done, 0x4000 - (adr & 0x3FFF));
+				u8 *dstPtr;
+
+				if ((adr >> 24) == 0x07)
+				{
+					chunk = std::min<u32>(chunk, 0x800 - (adr & 0x7FF));
+					dstPtr = MMU.ARM9_OAM + (adr & 0x7FF);
+					MMU.oamGeneration[(adr >> 10) & 1]++;
+					MMU.oamGeneration[((adr + chunk - 1) >> 10) & 1]++;
+				}
+				else
+				{
+					bool unmapped, restricted;
+					const u32 lcdc = MMU_LCDmap<ARMCPU_ARM9>(adr, unmapped, restricted);
+					if (unmapped)
+					{
+						done += chunk;
+						continue;
+					}
+
+					const u32 mask = MMU.MMU_MASK[ARMCPU_ARM9][lcdc >> 20];
+					chunk = std::min<u32>(chunk, mask + 1 - (lcdc & mask));
+
+					if ((lcdc >> 24) == 0x06)
+					{
+						const u32 lastPage = (lcdc + chunk - 1 - LCDC_HACKY_LOCATION) >> VRAM_GENERATION_PAGE_SHIFT;
+						for (u32 page = (lcdc - LCDC_HACKY_LOCATION) >> VRAM_GENERATION_PAGE_SHIFT; page <= lastPage; page++)
+							MMU.vramPageGeneration[page]++;
+					}
+					else if ((lcdc >> 24) == 0x05)
+					{
+						MMU.paletteGeneration[(lcdc >> 10) & 1]++;
+						MMU.paletteGeneration[((lcdc + chunk - 1) >> 10) & 1]++;
+					}
+
+#ifdef HAVE_JIT
+					if (JIT_MAPPED(lcdc, ARMCPU_ARM9))
+					{
+						for (u32 i = 0; i < chunk; i += 2)
+							JIT_COMPILED_FUNC_PREMASKED(lcdc + i, ARMCPU_ARM9, 0) = 0;
+					}
+#endif
+					dstPtr = MMU.MMU_MEM[ARMCPU_ARM9][lcdc >> 20] + (lcdc & mask);
+				}
+
+				if (srcinc != 0)
+					memcpy(dstPtr, srcPtr + done, chunk);
+				else
+					for (u32 i = 0; i < chunk; i += sz)
+						memcpy(dstPtr + i, srcPtr, sz);
+				done += chunk;
+			}
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
 template<int PROCNUM>
 void DmaController::doCopy()
 {
@@ -2332,7 +2513,17 @@ void DmaController::doCopy()
 	//we might make another function to do just the raw copy op which can use them with checks
 	//outside the loop
 	int time_elapsed = 0;
-	if(sz==4) {
+	if(DMA_CopyBulk<PROCNUM>(src, dst, todo, sz, srcinc, dstinc))
+	{
+		//neither end crosses a timing region, so every word costs the same
+		if(sz==4)
+			time_elapsed = todo * (_MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_READ,TRUE>(src,true) + _MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_WRITE,TRUE>(dst,true));
+		else
+			time_elapsed = todo * (_MMU_accesstime<PROCNUM,MMU_AT_DMA,16,MMU_AD_READ,TRUE>(src,true) + _MMU_accesstime<PROCNUM,MMU_AT_DMA,16,MMU_AD_WRITE,TRUE>(dst,true));
+		dst += dstinc * todo;
+		src += srcinc * todo;
+	}
+	else if(sz==4) {
 		for(s32 i=(s32)todo; i>0; i--)
 		{
 			time_elapsed += _MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_READ,TRUE>(src,true);
@@ -3328,6 +3519,107 @@ template bool MMU_WriteFromExternal<u32, 2>(const int targetProc, const u32 targ
 template bool MMU_WriteFromExternal<u32, 3>(const int targetProc, const u32 targetAddress, u32 newValue);
 template bool MMU_WriteFromExternal<u32, 4>(const int targetProc, const u32 targetAddress, u32 newValue);
 
+//when the sub 2D engine renders its lines on a worker thread, any write that could change what it reads
+//(its registers, the VRAM mapping, POWCNT1, palette, OAM or VRAM) has to wait until its current line is done.
+//likewise, when 2D lines are queued up for deferred rendering, only the engine registers are recorded per line,
+//so anything else they read has to be rendered out before it changes.
+static FORCEINLINE void MMU_ARM9_SyncGPULineRender(const u32 adr)
+{
+	if (GPU->IsAsyncRenderLineEngineSubRunning())
+	{
+		bool needSync = false;
+		switch (adr >> 24)
+		{
+			case 0x04:
+				needSync = ((adr & 0x0FFFF000) == (0x04000000 | REG_DISPB)) ||
+				           ((adr >= REG_VRAMCNTA) && (adr <= REG_VRAMCNTI)) ||
+				           ((adr & 0x0FFFFFFC) == REG_POWCNT1);
+				break;
+
+			case 0x05: // Palette
+			case 0x07: // OAM
+				needSync = ((adr & 0x00000400) != 0);
+				break;
+
+			case 0x06: // Engine B BG/OBJ VRAM and LCDC
+				needSync = ((adr & 0x00A00000) != 0);
+				break;
+
+			default:
+				break;
+		}
+
+		if (needSync)
+			GPU->AsyncRenderLineEngineSubFinish();
+	}
+
+	if (GPU->IsDeferredRenderLinePending())
+	{
+		bool needFlush = false;
+		switch (adr >> 24)
+		{
+			case 0x04:
+			{
+				//the affine reference points are advanced by rendering, so a write to them can't be recorded per line
+				const u32 engineReg = (adr & 0x0FFFEFFF);
+				needFlush = ((engineReg >= REG_DISPA_BG2XL) && (engineReg < REG_DISPA_BG2XL + 8)) ||
+				            ((engineReg >= REG_DISPA_BG3XL) && (engineReg < REG_DISPA_BG3XL + 8)) ||
+				            ((adr & 0x0FFFFFFC) == REG_DISPA_DISPCAPCNT) ||
+				            ((adr >= REG_VRAMCNTA) && (adr <= REG_VRAMCNTI)) ||
+				            ((adr & 0x0FFFFFFC) == REG_POWCNT1);
+				break;
+			}
+
+			case 0x05: // Palette
+			case 0x06: // VRAM
+			case 0x07: // OAM
+				needFlush = true;
+				break;
+
+			default:
+				break;
+		}
+
+		if (needFlush)
+		{
+			NDSPerfScope perfScope(NDSPerfSection_2D);
+			GPU->DeferredRenderLinesFlush();
+		}
+	}
+}
+
+//the core SPU mixes lazily, so anything written here that it could still read before catching up
+//(sample data in main memory or WRAM, the WRAM mapping, or the speaker enable) has to catch it up first.
+//main memory writes that take the inline fast path are checked in _MMU_write08/16/32() instead.
+template<int PROCNUM>
+static FORCEINLINE void MMU_SyncSPUMix(const u32 adr)
+{
+	if (spu_core_owed == 0)
+		return;
+
+	switch (adr >> 24)
+	{
+		case 0x02:
+			SPU_WatchMainWrite(adr & MMU.MMU_MASK[PROCNUM][adr >> 20]);
+			break;
+
+		case 0x03:
+			SPU_WatchWramWrite(adr);
+			break;
+
+		case 0x04:
+			if ( (PROCNUM == ARMCPU_ARM9 && (adr & 0x0FFFFFFC) == (REG_WRAMCNT & ~3)) ||
+			     (PROCNUM == ARMCPU_ARM7 && (adr & 0x0FFFFFFC) == REG_POWCNT2) )
+			{
+				SPU_MixOwed();
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
 //================================================================================================== ARM9 *
 //=========================================================================================================
 //=========================================================================================================
@@ -3348,6 +3640,9 @@ void DESMUME_FASTCALL _MMU_ARM9_write08(u32 adr, u8 val)
 		return;
 	}
 
+	MMU_ARM9_SyncGPULineRender(adr);
+	MMU_SyncSPUMix<ARMCPU_ARM9>(adr);
+
 	if (slot2_write<ARMCPU_ARM9, u8>(adr, val))
 		return;
 
@@ -3870,6 +4165,7 @@ void DESMUME_FASTCALL _MMU_ARM9_write08(u32 adr, u8 val)
 			
 		case 0x07: // OAM attributes
 			T1WriteByte(MMU.ARM9_OAM, adr & 0x07FF, val);
+			MMU.oamGeneration[(adr >> 10) & 1]++;
 			return;
 	}
 	
@@ -3877,6 +4173,8 @@ void DESMUME_FASTCALL _MMU_ARM9_write08(u32 adr, u8 val)
 	adr = MMU_LCDmap<ARMCPU_ARM9>(adr, unmapped, restricted);
 	if(unmapped) return;
 	if(restricted) return; //block 8bit vram writes
+	MMU_VRAMMarkWrittenLCDC(adr);
+	MMU_PaletteMarkWritten(adr);
 
 #ifdef HAVE_JIT
 	if (JIT_MAPPED(adr, ARMCPU_ARM9))
@@ -3904,6 +4202,9 @@ void DESMUME_FASTCALL _MMU_ARM9_write16(u32 adr, u16 val)
 		return;
 	}
 
+	MMU_ARM9_SyncGPULineRender(adr);
+	MMU_SyncSPUMix<ARMCPU_ARM9>(adr);
+
 	if (slot2_write<ARMCPU_ARM9, u16>(adr, val))
 		return;
 	
@@ -4587,12 +4888,15 @@ void DESMUME_FASTCALL _MMU_ARM9_write16(u32 adr, u16 val)
 			
 		case 0x07: // OAM attributes
 			T1WriteWord(MMU.ARM9_OAM, adr & 0x07FF, val);
+			MMU.oamGeneration[(adr >> 10) & 1]++;
 			return;
 	}
 	
 	bool unmapped, restricted;
 	adr = MMU_LCDmap<ARMCPU_ARM9>(adr, unmapped, restricted);
 	if(unmapped) return;
+	MMU_VRAMMarkWrittenLCDC(adr);
+	MMU_PaletteMarkWritten(adr);
 
 #ifdef HAVE_JIT
 	if (JIT_MAPPED(adr, ARMCPU_ARM9))
@@ -4621,6 +4925,9 @@ void DESMUME_FASTCALL _MMU_ARM9_write32(u32 adr, u32 val)
 		return ;
 	}
 
+	MMU_ARM9_SyncGPULineRender(adr);
+	MMU_SyncSPUMix<ARMCPU_ARM9>(adr);
+
 	if (slot2_write<ARMCPU_ARM9, u32>(adr, val))
 		return;
 
@@ -5127,12 +5434,15 @@ void DESMUME_FASTCALL _MMU_ARM9_write32(u32 adr, u32 val)
 			
 		case 0x07: // OAM attributes
 			T1WriteLong(MMU.ARM9_OAM, adr & 0x07FF, val);
+			MMU.oamGeneration[(adr >> 10) & 1]++;
 			return;
 	}
 
 	bool unmapped, restricted;
 	adr = MMU_LCDmap<ARMCPU_ARM9>(adr, unmapped, restricted);
 	if(unmapped) return;
+	MMU_VRAMMarkWrittenLCDC(adr);
+	MMU_PaletteMarkWritten(adr);
 
 #ifdef HAVE_JIT
 	if (JIT_MAPPED(adr, ARMCPU_ARM9))
@@ -5538,6 +5848,8 @@ void DESMUME_FASTCALL _MMU_ARM7_write08(u32 adr, u8 val)
 
 	if (adr < 0x02000000) return; //can't write to bios or entire area below main memory
 
+	MMU_SyncSPUMix<ARMCPU_ARM7>(adr);
+
 	if (slot2_write<ARMCPU_ARM7, u8>(adr, val))
 		return;
 
@@ -5647,6 +5959,7 @@ void DESMUME_FASTCALL _MMU_ARM7_write08(u32 adr, u8 val)
 	bool unmapped, restricted;
 	adr = MMU_LCDmap<ARMCPU_ARM7>(adr,unmapped, restricted);
 	if(unmapped) return;
+	MMU_VRAMMarkWrittenLCDC(adr);
 
 #ifdef HAVE_JIT
 	if (JIT_MAPPED(adr, ARMCPU_ARM7))
@@ -5666,6 +5979,8 @@ void DESMUME_FASTCALL _MMU_ARM7_write16(u32 adr, u16 val)
 
 	if (adr < 0x02000000) return; //can't write to bios or entire area below main memory
 
+	MMU_SyncSPUMix<ARMCPU_ARM7>(adr);
+
 	if (slot2_write<ARMCPU_ARM7, u16>(adr, val))
 		return;
 
@@ -5833,6 +6148,7 @@ void DESMUME_FASTCALL _MMU_ARM7_write16(u32 adr, u16 val)
 	bool unmapped, restricted;
 	adr = MMU_LCDmap<ARMCPU_ARM7>(adr,unmapped, restricted);
 	if(unmapped) return;
+	MMU_VRAMMarkWrittenLCDC(adr);
 
 #ifdef HAVE_JIT
 	if (JIT_MAPPED(adr, ARMCPU_ARM7))
@@ -5851,6 +6167,8 @@ void DESMUME_FASTCALL _MMU_ARM7_write32(u32 adr, u32 val)
 
 	if (adr < 0x02000000) return; //can't write to bios or entire area below main memory
 
+	MMU_SyncSPUMix<ARMCPU_ARM7>(adr);
+
 	if (slot2_write<ARMCPU_ARM7, u32>(adr, val))
 		return;
 
@@ -5932,6 +6250,7 @@ void DESMUME_FASTCALL _MMU_ARM7_write32(u32 adr, u32 val)
 	bool unmapped, restricted;
 	adr = MMU_LCDmap<ARMCPU_ARM7>(adr,unmapped, restricted);
 	if(unmapped) return;
+	MMU_VRAMMarkWrittenLCDC(adr);
 
 #ifdef HAVE_JIT
 	if (JIT_MAPPED(adr, ARMCPU_ARM7))
@@ -6254,18 +6573,121 @@ void DESMUME_FASTCALL MMU_write8(u32 proc, u32 adr, u8 val)
 		_MMU_ARM7_write08(adr,val);
 }
 
+//true if something watches the individual reads (or writes) of the range: a breakpoint, a debug
+//event or a Lua memory hook. those only see accesses that go through the regular path.
+static bool MMU_MemBlockWatched(u32 address, u32 size, bool write)
+{
+	const std::vector<u32> &breakPoints = (write) ? memWriteBreakPoints : memReadBreakPoints;
+	for (size_t i = 0; i < breakPoints.size(); i++)
+	{
+		if ((breakPoints[i] - address) < size) return true;
+	}
+
+	if (CheckDebugEvent((write) ? DEBUG_EVENT_WRITE : DEBUG_EVENT_READ)) return true;
+#ifdef HAVE_LUA
+	if (hookedRegions[(write) ? LUAMEMHOOK_WRITE : LUAMEMHOOK_READ].Contains(address, size)) return true;
+#endif
+#ifdef TARGET_INTERFACE
+	return true;
+#endif
+	return false;
+}
+
+//returns how many bytes starting at address can be copied straight out of (or into) main memory.
+//runs stop at the end of the main memory mirror and at every 16KB boundary, so that the ARM9's
+//DTCM, which may be mapped over main memory, still goes through the regular path, and so does
+//any run that is being watched.
+static u32 MMU_MainMemBlockRun(u8 proc, u32 address, u32 size, bool write)
+{
+	if ((address & 0x0F000000) != 0x02000000)
+		return 0;
+	if (proc == ARMCPU_ARM9 && (address & ~0x3FFF) == MMU.DTCMRegion)
+		return 0;
+
+	const u32 ofs = address & _MMU_MAIN_MEM_MASK;
+	u32 run = std::min<u32>(size, _MMU_MAIN_MEM_MASK + 1 - ofs);
+	run = std::min<u32>(run, 0x4000 - (address & 0x3FFF));
+	if (MMU_MemBlockWatched(address, run, write))
+		return 0;
+
+	return run;
+}
+
 void DESMUME_FASTCALL MMU_DumpMemBlock(u8 proc, u32 address, u32 size, u8 *buffer)
 {
-	u32 i;
-	u32 curaddr;
+	while (size > 0)
+	{
+		const u32 run = MMU_MainMemBlockRun(proc, address, size, false);
+		if (run > 0)
+		{
+			memcpy(buffer, MMU.MAIN_MEM + (address & _MMU_MAIN_MEM_MASK), run);
+			buffer += run;
+			address += run;
+			size -= run;
+			continue;
+		}
 
-	for(i = 0, curaddr = address; i < size; i++, curaddr++)
+		*buffer++ = _MMU_read08(proc,MMU_AT_DEBUG,address++);
+		size--;
+	}
+}
+
+void DESMUME_FASTCALL MMU_LoadMemBlock(u8 proc, u32 address, u32 size, const u8 *buffer)
+{
+	while (size > 0)
 	{
-		buffer[i] = _MMU_read08(proc,MMU_AT_DEBUG,curaddr);
+		const u32 run = MMU_MainMemBlockRun(proc, address, size, true);
+		if (run > 0)
+		{
+			const u32 ofs = address & _MMU_MAIN_MEM_MASK;
+#ifdef HAVE_JIT
+			arm_jit_invalidate(0x02000000 | ofs, run);
+#endif
+			SPU_WatchMainWriteRange(ofs, run);
+			memcpy(MMU.MAIN_MEM + ofs, buffer, run);
+			buffer += run;
+			address += run;
+			size -= run;
+			continue;
+		}
+
+		_MMU_write08(proc,MMU_AT_DEBUG,address++,*buffer++);
+		size--;
 	}
 }
 
 
+u8* MMU_GetARM7ReadSpan(u32 address, u32 size)
+{
+	if (size == 0)
+		return NULL;
+
+	address &= 0x0FFFFFFF;
+	const u32 last = address + size - 1;
+
+	if ( ((address >> 24) == 0x02) && ((last >> 24) == 0x02) )
+	{
+		const u32 ofs = address & _MMU_MAIN_MEM_MASK;
+		if ((size > _MMU_MAIN_MEM_MASK) || (ofs + size > _MMU_MAIN_MEM_MASK + 1))
+			return NULL;
+
+		return MMU.MAIN_MEM + ofs;
+	}
+
+	//WRAM is mapped in 16KB blocks, so the range has to stay inside one of them
+	if ( ((address >> 24) == 0x03) && ((address >> 14) == (last >> 14)) )
+	{
+		bool unmapped, restricted;
+		const u32 mapped = MMU_LCDmap<ARMCPU_ARM7>(address, unmapped, restricted);
+		if (unmapped)
+			return NULL;
+
+		return MMU.MMU_MEM[ARMCPU_ARM7][mapped >> 20] + (mapped & MMU.MMU_MASK[ARMCPU_ARM7][mapped >> 20]);
+	}
+
+	return NULL;
+}
+
 //these templates needed to be instantiated manually
 template u32 MMU_struct::gen_IF<ARMCPU_ARM9>();
 template u32 MMU_struct::gen_IF<ARMCPU_ARM7>();
@@ -373,6 +373,9 @@ typedef union
 #define DUP8(x)  x, x, x, x,  x, x, x, x
 #define DUP16(x) x, x, x, x,  x, x, x, x,  x, x, x, x,  x, x, x, x
 
+#define VRAM_GENERATION_PAGE_SHIFT 12
+#define VRAM_GENERATION_PAGE_SIZE (1 << VRAM_GENERATION_PAGE_SHIFT)
+
 struct MMU_struct 
 {
 	//ARM9 mem
@@ -401,6 +404,18 @@ struct MMU_struct
 		u8* texPalSlot[6];
 		u8* textureSlotAddr[4];
 	} texInfo;
+	
+	//generation counters for VRAM, used by the texture cache to skip rechecking VRAM that hasn't changed.
+	//vramPageGeneration is incremented whenever a VRAM_GENERATION_PAGE_SIZE page of ARM9_LCD is written to,
+	//and the slot generations are incremented whenever a texture or texture palette slot is remapped.
+	u32 vramPageGeneration[sizeof(ARM9_LCD) >> VRAM_GENERATION_PAGE_SHIFT];
+	u32 texPalSlotGeneration[6];
+	u32 textureSlotGeneration[4];
+	
+	//likewise for the palette and OAM of each 2D engine (indexed by GPUEngineID), used by the 2D engines
+	//to tell whether a line needs to be rendered again. incremented whenever the engine's 1KB block is written to.
+	u32 paletteGeneration[2];
+	u32 oamGeneration[2];
 
 	//ARM7 mem
 	u8 ARM7_BIOS[0x4000];
@@ -636,6 +651,21 @@ FORCEINLINE void* MMU_gpu_map(const u32 vram_addr)
 	return MMU.ARM9_LCD + (vram_page << 14) + ofs;
 }
 
+//marks a range of host VRAM memory (somewhere within MMU.ARM9_LCD) as written to
+FORCEINLINE void MMU_VRAMMarkWritten(const void *hostPtr, const size_t len)
+{
+	const size_t ofs = (const u8 *)hostPtr - MMU.ARM9_LCD;
+	const size_t lastPage = (ofs + len - 1) >> VRAM_GENERATION_PAGE_SHIFT;
+	
+	for (size_t page = ofs >> VRAM_GENERATION_PAGE_SHIFT; page <= lastPage; page++)
+	{
+		MMU.vramPageGeneration[page]++;
+	}
+}
+
+//marks all of VRAM, all texture slots, the palettes and OAM as changed, for when they are replaced wholesale, such as when loading a savestate
+void MMU_VRAMMarkAllWritten();
+
 // Call MMU_WriteFromExternal() when modifying memory outside of the normal execution process, such
 // as when using cheats or when the client wants to write to memory directly. This function returns
 // true if memory is modified in such a way that requires the JIT execution be reset.
@@ -676,6 +706,16 @@ extern u32 _MMU_MAIN_MEM_MASK16;
 extern u32 _MMU_MAIN_MEM_MASK32;
 void SetupMMU(bool debugConsole, bool dsi);
 
+//memory that a playing sound channel reads from. writes to it have to let the core spu
+//mix what it owes first (see SPU_CatchUp() in SPU.h), so that it still reads the old data.
+extern u32 spu_watch_main_begin, spu_watch_main_size;
+extern bool spu_watch_wram;
+void SPU_MixOwed();
+//ofs is an offset already masked into main memory
+static FORCEINLINE void SPU_WatchMainWrite(u32 ofs) { if ((u32)(ofs - spu_watch_main_begin) < spu_watch_main_size) SPU_MixOwed(); }
+static FORCEINLINE void SPU_WatchMainWriteRange(u32 ofs, u32 size) { if (ofs < spu_watch_main_begin + spu_watch_main_size && ofs + size > spu_watch_main_begin) SPU_MixOwed(); }
+static FORCEINLINE void SPU_WatchWramWrite(u32 adr) { if (spu_watch_wram && (adr & 0x0F000000) == 0x03000000) SPU_MixOwed(); }
+
 FORCEINLINE void CheckMemoryDebugEvent(EDEBUG_EVENT event, const MMU_ACCESS_TYPE type, const u32 procnum, const u32 addr, const u32 size, const u32 val)
 {
 	//TODO - ugh work out a better prefetch event system
@@ -921,6 +961,7 @@ FORCEINLINE void _MMU_write08(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 #ifdef HAVE_JIT
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK, 0) = 0;
 #endif
+		SPU_WatchMainWrite(addr & _MMU_MAIN_MEM_MASK);
 		T1WriteByte( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 1, val, LUAMEMHOOK_WRITE);
@@ -979,6 +1020,7 @@ FORCEINLINE void _MMU_write16(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 #ifdef HAVE_JIT
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK16, 0) = 0;
 #endif
+		SPU_WatchMainWrite(addr & _MMU_MAIN_MEM_MASK16);
 		T1WriteWord( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK16, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 2, val, LUAMEMHOOK_WRITE);
@@ -1035,6 +1077,7 @@ FORCEINLINE void _MMU_write32(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK32, 0) = 0;
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK32, 1) = 0;
 #endif
+		SPU_WatchMainWrite(addr & _MMU_MAIN_MEM_MASK32);
 		T1WriteLong( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK32, val);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 4, val, LUAMEMHOOK_WRITE);
@@ -1107,6 +1150,13 @@ FORCEINLINE void _MMU_write16(u32 addr, u16 val) { _MMU_write16(PROCNUM, AT, add
 template<int PROCNUM, MMU_ACCESS_TYPE AT>
 FORCEINLINE void _MMU_write32(u32 addr, u32 val) { _MMU_write32(PROCNUM, AT, addr, val); }
 
+//reads and writes a block of memory the way a debugger sees it. main memory is copied in bulk,
+//everything else goes through the MMU_AT_DEBUG accessors one byte at a time.
 void DESMUME_FASTCALL MMU_DumpMemBlock(u8 proc, u32 address, u32 size, u8 *buffer);
+void DESMUME_FASTCALL MMU_LoadMemBlock(u8 proc, u32 address, u32 size, const u8 *buffer);
+
+//returns a host pointer to [address, address+size) as the ARM7 would read it, or NULL if that range
+//isn't one contiguous stretch of main memory or WRAM. only valid until the WRAM mapping changes.
+u8* MMU_GetARM7ReadSpan(u32 address, u32 size);
 
 #endif
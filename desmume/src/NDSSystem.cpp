@@ -20,6 +20,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <chrono>
 #include <math.h>
 #include <zlib.h>
 
@@ -58,8 +59,13 @@
 #include "SPU.h"
 #include "wifi.h"
 #include "Database.h"
+#include "rewind.h"
 #include "frontend/modules/Disassembler.h"
 
+#ifdef HAVE_JIT
+#include "arm_jit.h"
+#endif
+
 #if defined(HOST_WINDOWS) && !defined(TARGET_INTERFACE)
 #include "display.h"
 extern HWND DisViewWnd[2];
@@ -157,8 +163,21 @@ void NDS_RunAdvansceneAutoImport()
 	}
 }
 
+//hands the task pool settings to the shared task pool. the pool copes with changes while it's running.
+static void NDS_ApplyTaskPoolSettings()
+{
+	TaskPool_SetThreadCount((CommonSettings.task_pool_threads > 0) ? CommonSettings.task_pool_threads : CommonSettings.num_cores);
+	
+	for (size_t i = 0; i < TaskGroupCount; i++)
+	{
+		TaskPool_SetGroupLimit((TaskGroup)i, CommonSettings.task_group_limit[i].maxThreads, CommonSettings.task_group_limit[i].threadMask);
+	}
+}
+
 int NDS_Init()
 {
+	NDS_ApplyTaskPoolSettings();
+	
 	nds.idleFrameCounter = 0;
 	memset(nds.runCycleCollector,0,sizeof(nds.runCycleCollector));
 	MMU_Init();
@@ -221,6 +240,8 @@ void NDS_DeInit(void)
 	delete cheatSearch;
 	cheatSearch = NULL;
 
+	TaskPool_Shutdown();
+
 #ifdef HAVE_JIT
 	arm_jit_close();
 #endif
@@ -451,6 +472,12 @@ bool GameInfo::loadROM(std::string fname, u32 type)
 	char *noext = strdup(fname.c_str());
 	reader = ROMReaderInit(&noext); free(noext);
 	fROM = reader->Init(fname.c_str());
+	if (!fROM && reader == &MMAPROMReader)
+	{
+		//some files can't be mapped (empty ones, pipes, certain network shares), but can still be read normally
+		reader = &STDROMReader;
+		fROM = reader->Init(fname.c_str());
+	}
 	if (!fROM) return false;
 
 	headerOffset = (type == ROM_DSGBA)?DSGBA_LOADER_SIZE:0;
@@ -636,23 +663,21 @@ void GameInfo::closeROM()
 
 u32 GameInfo::readROM(u32 pos)
 {
-	u32 num;
 	u32 data;
+	readROMBlock(pos, &data, 4);
+	return LE_TO_LOCAL_32(data);
+}
 
+void GameInfo::readROMBlock(u32 pos, void *dst, u32 len)
+{
 	//reader must try to be efficient and not do unneeded seeks
 	reader->Seek(fROM, pos, SEEK_SET);
-	num = reader->Read(fROM, &data, 4);
+	int num = reader->Read(fROM, dst, len);
+	if (num < 0) num = 0;
 
 	//in case we didn't read enough data, pad the remainder with 0xFF
-	u32 pad = 0;
-	while(num<4)
-	{
-		pad >>= 8;
-		pad |= 0xFF000000;
-		num++;
-	}
-
-	return (LE_TO_LOCAL_32(data) & ~pad) | pad;
+	if ((u32)num < len)
+		memset((u8 *)dst + num, 0xFF, len - num);
 }
 
 bool GameInfo::isDSiEnhanced()
@@ -831,6 +856,9 @@ int NDS_LoadROM(const char *filename, const char *physicalName, const char *logi
 		cheats->init(buf);
 	}
 
+	//the rewind history belongs to whatever ran before
+	Rewind_Reset();
+
 	//UnloadMovieEmulationSettings(); called in NDS_Reset()
 	NDS_Reset();
 
@@ -842,6 +870,7 @@ void NDS_FreeROM(void)
 	FCEUI_StopMovie();
 	gameInfo.closeROM();
 	UnloadMovieEmulationSettings();
+	Rewind_Reset();
 }
 
 void NDS_Sleep() { nds.sleeping = TRUE; }
@@ -1243,10 +1272,35 @@ struct TSequenceItem_sqrtunit : public TSequenceItem
 
 };
 
+//the items are grouped by how they get rescheduled; each group caches its earliest deadline
+enum ESequenceGroup
+{
+	ESG_DISPCNT,
+	ESG_WIFI,
+	ESG_DIVIDER,
+	ESG_SQRTUNIT,
+	ESG_GXFIFO,
+	ESG_READSLOT1,
+	ESG_DMA,
+	ESG_TIMER,
+
+	ESG_COUNT
+};
+
+#define ESG_BIT(G) (1<<(G))
+#define ESG_ALL ((1<<ESG_COUNT)-1)
+
 struct Sequencer
 {
 	bool nds_vblankEnded;
 	bool reschedule;
+
+	//earliest deadline of each group and of all of them. a group is only rescanned after it was marked dirty,
+	//which happens when it gets rescheduled or when execHardware looked at it.
+	u64 groupNext[ESG_COUNT];
+	u64 nextCache;
+	u32 dirtyMask;
+
 	TSequenceItem dispcnt;
 	TSequenceItem wifi;
 	TSequenceItem_divider divider;
@@ -1266,6 +1320,12 @@ struct Sequencer
 
 	void execHardware();
 	u64 findNext();
+	void refresh();
+
+	FORCEINLINE void markDirty(u32 groups)
+	{
+		dirtyMask |= groups;
+	}
 
 	void save(EMUFILE &os)
 	{
@@ -1304,6 +1364,7 @@ struct Sequencer
 		LOAD(dma,1,0); LOAD(dma,1,1); LOAD(dma,1,2); LOAD(dma,1,3); 
 #undef LOAD
 
+		markDirty(ESG_ALL);
 		return true;
 	}
 
@@ -1316,6 +1377,7 @@ void NDS_RescheduleGXFIFO(u32 cost)
 		sequencer.gxfifo.enabled = true;
 	}
 	MMU.gfx3dCycles += cost;
+	sequencer.markDirty(ESG_BIT(ESG_GXFIFO));
 	NDS_Reschedule();
 }
 
@@ -1326,6 +1388,7 @@ void NDS_RescheduleTimers()
 	check(1,0); check(1,1); check(1,2); check(1,3);
 #undef check
 
+	sequencer.markDirty(ESG_BIT(ESG_TIMER));
 	NDS_Reschedule();
 }
 
@@ -1349,14 +1412,32 @@ void NDS_RescheduleReadSlot1(int procnum, int size)
 	sequencer.readslot1.timestamp = nds_timer + delay;
 	sequencer.readslot1.enabled = true;
 
+	sequencer.markDirty(ESG_BIT(ESG_READSLOT1));
 	NDS_Reschedule();
 }
 
 void NDS_RescheduleDMA()
 {
-	//TBD
+	sequencer.markDirty(ESG_BIT(ESG_DMA));
+	NDS_Reschedule();
+}
+
+void NDS_RescheduleDivider()
+{
+	sequencer.markDirty(ESG_BIT(ESG_DIVIDER));
+	NDS_Reschedule();
+}
+
+void NDS_RescheduleSqrt()
+{
+	sequencer.markDirty(ESG_BIT(ESG_SQRTUNIT));
 	NDS_Reschedule();
+}
 
+void NDS_RescheduleAll()
+{
+	sequencer.markDirty(ESG_ALL);
+	NDS_Reschedule();
 }
 
 static void initSchedule()
@@ -1381,6 +1462,7 @@ const u64 kWifiCycles = 67;//34*2;
 
 void Sequencer::init()
 {
+	markDirty(ESG_ALL);
 	NDS_RescheduleTimers();
 	NDS_RescheduleDMA();
 
@@ -1429,7 +1511,10 @@ static void execHardware_hblank()
 			GPU->SetWillFrameSkip(frameSkipper.ShouldSkip2D());
 		}
 		
-		GPU->RenderLine(nds.VCount);
+		{
+			NDSPerfScope perfScope(NDSPerfSection_2D);
+			GPU->RenderLine(nds.VCount);
+		}
 		
 		//trigger hblank dmas
 		//but notice, we do that just after we finished drawing the line
@@ -1463,9 +1548,8 @@ static void execHardware_hblank()
 
 	//emulation housekeeping. for some reason we always do this at hblank,
 	//even though it sounds more reasonable to do it at hstart
+	NDSPerfScope perfScope(NDSPerfSection_SPU);
 	SPU_Emulate_core();
-	driver->AVI_SoundUpdate(SPU_core->outbuf,spu_core_samples);
-	WAV_WavSoundUpdate(SPU_core->outbuf,spu_core_samples);
 }
 
 static void execHardware_hstart_vblankEnd()
@@ -1686,6 +1770,9 @@ void NDS_Reschedule()
 {
 	IF_DEVELOPER(if(!sequencer.reschedule) DEBUG_statistics.sequencerExecutionCounters[0]++;);
 	sequencer.reschedule = true;
+#ifdef HAVE_JIT
+	arm_jit_break_link();
+#endif
 }
 
 FORCEINLINE u32 _fast_min32(u32 a, u32 b, u32 c, u32 d)
@@ -1718,33 +1805,64 @@ FORCEINLINE u64 _fast_min(u64 a, u64 b)
 
 
 
-u64 Sequencer::findNext()
+void Sequencer::refresh()
 {
 	//this one is always enabled so dont bother to check it
-	u64 next = dispcnt.next();
+	if(dirtyMask & ESG_BIT(ESG_DISPCNT)) groupNext[ESG_DISPCNT] = dispcnt.next();
 
-	if(divider.isEnabled()) next = _fast_min(next,divider.next());
-	if(sqrtunit.isEnabled()) next = _fast_min(next,sqrtunit.next());
-	if(gxfifo.enabled) next = _fast_min(next,gxfifo.next());
-	if(readslot1.isEnabled()) next = _fast_min(next,readslot1.next());
-	if (wifi.enabled) next = _fast_min(next,wifi.next());
+	if(dirtyMask & ESG_BIT(ESG_WIFI)) groupNext[ESG_WIFI] = wifi.enabled ? wifi.next() : kNever;
+	if(dirtyMask & ESG_BIT(ESG_DIVIDER)) groupNext[ESG_DIVIDER] = divider.isEnabled() ? divider.next() : kNever;
+	if(dirtyMask & ESG_BIT(ESG_SQRTUNIT)) groupNext[ESG_SQRTUNIT] = sqrtunit.isEnabled() ? sqrtunit.next() : kNever;
+	if(dirtyMask & ESG_BIT(ESG_GXFIFO)) groupNext[ESG_GXFIFO] = gxfifo.enabled ? gxfifo.next() : kNever;
+	if(dirtyMask & ESG_BIT(ESG_READSLOT1)) groupNext[ESG_READSLOT1] = readslot1.isEnabled() ? readslot1.next() : kNever;
 
+	if(dirtyMask & ESG_BIT(ESG_DMA))
+	{
+		u64 next = kNever;
 #define test(X,Y) if(dma_##X##_##Y .isEnabled()) next = _fast_min(next,dma_##X##_##Y .next());
-	test(0,0); test(0,1); test(0,2); test(0,3);
-	test(1,0); test(1,1); test(1,2); test(1,3);
+		test(0,0); test(0,1); test(0,2); test(0,3);
+		test(1,0); test(1,1); test(1,2); test(1,3);
 #undef test
+		groupNext[ESG_DMA] = next;
+	}
+
+	if(dirtyMask & ESG_BIT(ESG_TIMER))
+	{
+		u64 next = kNever;
 #define test(X,Y) if(timer_##X##_##Y .enabled) next = _fast_min(next,timer_##X##_##Y .next());
-	test(0,0); test(0,1); test(0,2); test(0,3);
-	test(1,0); test(1,1); test(1,2); test(1,3);
+		test(0,0); test(0,1); test(0,2); test(0,3);
+		test(1,0); test(1,1); test(1,2); test(1,3);
 #undef test
+		groupNext[ESG_TIMER] = next;
+	}
+
+	u64 next = groupNext[0];
+	for(int i=1;i<ESG_COUNT;i++)
+		next = _fast_min(next,groupNext[i]);
+	nextCache = next;
 
-	return next;
+	dirtyMask = 0;
+}
+
+u64 Sequencer::findNext()
+{
+	if(dirtyMask) refresh();
+	return nextCache;
 }
 
 void Sequencer::execHardware()
 {
-	if(dispcnt.isTriggered())
+	//nothing can be due before the cached deadline, as long as nothing was rescheduled since it was taken
+	if(dirtyMask) refresh();
+	if(nds_timer < nextCache) return;
+
+	//a group gets looked at if it is due, or if something earlier in this pass rescheduled it (e.g. hstart dmas).
+	//either way its cached deadline is stale afterwards.
+#define DUE(G) ((dirtyMask & ESG_BIT(G)) || nds_timer >= groupNext[G])
+
+	if(DUE(ESG_DISPCNT) && dispcnt.isTriggered())
 	{
+		markDirty(ESG_BIT(ESG_DISPCNT));
 
 		IF_DEVELOPER(DEBUG_statistics.sequencerExecutionCounters[1]++);
 
@@ -1785,27 +1903,37 @@ void Sequencer::execHardware()
 
 	if (wifiHandler->GetCurrentEmulationLevel() != WifiEmulationLevel_Off)
 	{
-		if (wifi.isTriggered())
+		if (DUE(ESG_WIFI) && wifi.isTriggered())
 		{
+			markDirty(ESG_BIT(ESG_WIFI));
 			wifiHandler->CommTrigger();
 			wifi.timestamp += kWifiCycles;
 		}
 	}
 	
-	if(divider.isTriggered()) divider.exec();
-	if(sqrtunit.isTriggered()) sqrtunit.exec();
-	if(gxfifo.isTriggered()) gxfifo.exec();
-	if(readslot1.isTriggered()) readslot1.exec();
-
+	if(DUE(ESG_DIVIDER) && divider.isTriggered()) { markDirty(ESG_BIT(ESG_DIVIDER)); divider.exec(); }
+	if(DUE(ESG_SQRTUNIT) && sqrtunit.isTriggered()) { markDirty(ESG_BIT(ESG_SQRTUNIT)); sqrtunit.exec(); }
+	if(DUE(ESG_GXFIFO) && gxfifo.isTriggered()) { markDirty(ESG_BIT(ESG_GXFIFO)); gxfifo.exec(); }
+	if(DUE(ESG_READSLOT1) && readslot1.isTriggered()) { markDirty(ESG_BIT(ESG_READSLOT1)); readslot1.exec(); }
 
+	if(DUE(ESG_DMA))
+	{
+		markDirty(ESG_BIT(ESG_DMA));
 #define test(X,Y) if(dma_##X##_##Y .isTriggered()) dma_##X##_##Y .exec();
-	test(0,0); test(0,1); test(0,2); test(0,3);
-	test(1,0); test(1,1); test(1,2); test(1,3);
+		test(0,0); test(0,1); test(0,2); test(0,3);
+		test(1,0); test(1,1); test(1,2); test(1,3);
 #undef test
+	}
+	if(DUE(ESG_TIMER))
+	{
+		markDirty(ESG_BIT(ESG_TIMER));
 #define test(X,Y) if(timer_##X##_##Y .enabled) if(timer_##X##_##Y .isTriggered()) timer_##X##_##Y .exec();
-	test(0,0); test(0,1); test(0,2); test(0,3);
-	test(1,0); test(1,1); test(1,2); test(1,3);
+		test(0,0); test(0,1); test(0,2); test(0,3);
+		test(1,0); test(1,1); test(1,2); test(1,3);
 #undef test
+	}
+
+#undef DUE
 }
 
 void execHardware_interrupts();
@@ -1947,6 +2075,27 @@ static FORCEINLINE s32 minarmtime(s32 arm9, s32 arm7)
 		return arm7;
 }
 
+#ifdef HAVE_JIT
+//how many cycles linked JIT blocks may run for on a CPU whose time is cpuTime, such that the loop
+//below would have dispatched the same CPU again after every one of them. it must stay strictly
+//behind the other CPU and s32next. ARM7 cycles count twice, hence the shift.
+template<int PROCNUM, bool otherRunning>
+static FORCEINLINE s32 jitLinkBudget(const s32 cpuTime, const s32 otherTime, const s32 s32next)
+{
+	const armcpu_t &cpu = (PROCNUM == ARMCPU_ARM9) ? NDS_ARM9 : NDS_ARM7;
+	if (cpu.debugStep || cpu.stepOverBreak != 0 || cpu.runToRetTmp != 0)
+		return 0;
+	#if defined(HOST_WINDOWS) && !defined(TARGET_INTERFACE)
+	if (!cpu.breakPoints->empty())
+		return 0;
+	#endif
+
+	const s32 limit = otherRunning ? std::min(otherTime, s32next) : s32next;
+	const s32 shift = (PROCNUM == ARMCPU_ARM9) ? 0 : 1;
+	return (limit - cpuTime + (1 << shift) - 1) >> shift;
+}
+#endif
+
 #ifdef HAVE_JIT
 template<bool doarm9, bool doarm7, bool jit>
 #else
@@ -1993,7 +2142,7 @@ static /*donotinline*/ std::pair<s32,s32> armInnerLoop(
 				arm9log();
 				debug();
 #ifdef HAVE_JIT
-				arm9 += armcpu_exec<ARMCPU_ARM9,jit>();
+				arm9 += armcpu_exec<ARMCPU_ARM9,jit>(jit ? jitLinkBudget<ARMCPU_ARM9,doarm7>(arm9, arm7, s32next) : 0);
 #else
 				arm9 += armcpu_exec<ARMCPU_ARM9>();
 #endif
@@ -2034,7 +2183,7 @@ static /*donotinline*/ std::pair<s32,s32> armInnerLoop(
 			{
 				arm7log();
 #ifdef HAVE_JIT
-				arm7 += (armcpu_exec<ARMCPU_ARM7,jit>()<<1);
+				arm7 += (armcpu_exec<ARMCPU_ARM7,jit>(jit ? jitLinkBudget<ARMCPU_ARM7,doarm9>(arm7, arm9, s32next) : 0)<<1);
 #else
 				arm7 += (armcpu_exec<ARMCPU_ARM7>()<<1);
 #endif
@@ -2106,6 +2255,8 @@ void NDS_debug_step()
 template<bool FORCE>
 void NDS_exec(s32 nb)
 {
+	NDSPerfScope perfScope(NDSPerfSection_CPU);
+
 	GDBSTUB_MUTEX_LOCK();
 
 	LagFrameFlag=1;
@@ -2228,6 +2379,12 @@ void NDS_exec(s32 nb)
 	//DEBUG_statistics.printSequencerExecutionCounters();
 	//DEBUG_statistics.print();
 
+	//the frontend takes the frame's sound from here, so whatever the spu still owes has to be mixed now
+	{
+		NDSPerfScope spuPerfScope(NDSPerfSection_SPU);
+		SPU_CatchUp();
+	}
+
 	//end of frame emulation housekeeping
 	if(LagFrameFlag)
 	{
@@ -2690,6 +2847,7 @@ void NDS_Reset()
 		return;
 
 	UnloadMovieEmulationSettings();
+	NDS_ApplyTaskPoolSettings();
 
 	//reload last paths if needed
 	if(!gameInfo.reader)
@@ -3335,6 +3493,56 @@ void NDS_GetCPULoadAverage(u32 &outLoadAvgARM9, u32 &outLoadAvgARM7)
 	outLoadAvgARM7 = std::min<u32>( 100, std::max<u32>(0, (u32)(calcLoad*100/1120380)) );
 }
 
+static struct
+{
+	bool enabled;
+	NDSPerfSection current;
+	u64 stamp;
+	u64 total[NDSPerfSection_Count];
+} perf = { false, NDSPerfSection_None, 0, {} };
+
+static u64 perf_now()
+{
+	return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void NDS_PerfEnable(bool enable)
+{
+	perf.enabled = enable;
+	perf.current = NDSPerfSection_None;
+	memset(perf.total, 0, sizeof(perf.total));
+}
+
+void NDS_PerfGetTimes(u64 (&outNanoseconds)[NDSPerfSection_Count])
+{
+	memcpy(outNanoseconds, perf.total, sizeof(perf.total));
+}
+
+NDSPerfSection NDS_PerfEnter(NDSPerfSection section)
+{
+	const NDSPerfSection previous = perf.current;
+	if (!perf.enabled)
+		return previous;
+
+	const u64 now = perf_now();
+	if (previous != NDSPerfSection_None)
+		perf.total[previous] += now - perf.stamp;
+	perf.stamp = now;
+	perf.current = section;
+	return previous;
+}
+
+void NDS_PerfLeave(NDSPerfSection previous)
+{
+	if (!perf.enabled || perf.current == NDSPerfSection_None)
+		return;
+
+	const u64 now = perf_now();
+	perf.total[perf.current] += now - perf.stamp;
+	perf.stamp = now;
+	perf.current = previous;
+}
+
 //these templates needed to be instantiated manually
 template void NDS_exec<FALSE>(s32 nb);
 template void NDS_exec<TRUE>(s32 nb);
@@ -3380,6 +3588,12 @@ TCommonSettings::TCommonSettings()
 	
 	num_cores = NDS_GetCPUCoreCount();
 	rigorous_timing = false;
+	gpu_async_sub_engine = false;
+	gpu_deferred_2d = false;
+	gpu_line_reuse = false;
+	
+	task_pool_threads = 0;
+	memset(task_group_limit, 0, sizeof(task_group_limit));
 	
 	gamehacks.en = true;
 	gamehacks.clear();
@@ -3408,6 +3622,10 @@ TCommonSettings::TCommonSettings()
 	use_jit = false;
 #endif
 	jit_max_block_size = 12;
+	jit_cache_size = 32;
+
+	rewind_interval = 0;
+	rewind_buffer_size = 128;
 	
 	WifiBridgeDeviceID = 0;
 	
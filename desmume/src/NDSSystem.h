@@ -26,6 +26,7 @@
 #include "types.h"
 #include "ROMReader.h"
 #include "firmware.h"
+#include "utils/task.h"
 
 class CFIRMWARE;
 class EMUFILE;
@@ -198,6 +199,9 @@ void NDS_RescheduleGXFIFO(u32 cost);
 void NDS_RescheduleDMA();
 void NDS_RescheduleReadSlot1(int procnum, int size);
 void NDS_RescheduleTimers();
+void NDS_RescheduleDivider();
+void NDS_RescheduleSqrt();
+void NDS_RescheduleAll();
 
 enum ENSATA_HANDSHAKE
 {
@@ -357,6 +361,7 @@ struct GameInfo
 	bool loadROM(std::string fname, u32 type = ROM_NDS);
 	void closeROM();
 	u32 readROM(u32 pos);
+	void readROMBlock(u32 pos, void *dst, u32 len);
 	bool ValidateHeader();
 	void populate();
 	bool isDSiEnhanced();
@@ -477,6 +482,36 @@ void NDS_SetupDefaultFirmware();
 
 template<bool FORCE> void NDS_exec(s32 nb = 560190<<1);
 
+//host time spent in each part of the emulator, for benchmarking. it is only gathered while enabled,
+//and only on the emulation thread; work that a helper thread does in parallel only shows up as the
+//time spent waiting for it.
+enum NDSPerfSection
+{
+	NDSPerfSection_CPU = 0, //everything NDS_exec() does that isn't one of the others
+	NDSPerfSection_2D,
+	NDSPerfSection_3D,
+	NDSPerfSection_SPU,
+
+	NDSPerfSection_Count,
+	NDSPerfSection_None = NDSPerfSection_Count
+};
+
+void NDS_PerfEnable(bool enable); //also clears the totals
+void NDS_PerfGetTimes(u64 (&outNanoseconds)[NDSPerfSection_Count]);
+NDSPerfSection NDS_PerfEnter(NDSPerfSection section);
+void NDS_PerfLeave(NDSPerfSection previous);
+
+//charges the time until the end of the scope to a section. nested scopes take their time away from the outer one.
+class NDSPerfScope
+{
+private:
+	NDSPerfSection _previous;
+
+public:
+	NDSPerfScope(NDSPerfSection section) { _previous = NDS_PerfEnter(section); }
+	~NDSPerfScope() { NDS_PerfLeave(_previous); }
+};
+
 extern int lagframecounter;
 
 enum MicMode
@@ -529,6 +564,16 @@ extern struct TCommonSettings
 
 	int num_cores;
 	bool rigorous_timing;
+	bool gpu_async_sub_engine;
+	bool gpu_deferred_2d;
+	bool gpu_line_reuse; //reuse 2D lines whose inputs haven't changed since the last time they were rendered
+
+	int task_pool_threads; //threads in the shared task pool, 0 uses num_cores
+	struct
+	{
+		u32 maxThreads; //most pool threads the group may use at once, 0 for no limit
+		u32 threadMask; //pool threads the group may run on, 0 for any
+	} task_group_limit[TaskGroupCount];
 
 	struct GameHacks
 	{
@@ -552,6 +597,10 @@ extern struct TCommonSettings
 
 	bool use_jit;
 	u32	jit_max_block_size;
+	u32	jit_cache_size; //in MB
+
+	u32 rewind_interval; //frames between rewind snapshots, 0 disables rewind
+	u32 rewind_buffer_size; //in MB
 	
 	int WifiBridgeDeviceID;
 
@@ -24,6 +24,13 @@
 #ifdef HAVE_LIBZZIP
 #include <zzip/zzip.h>
 #endif
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "utils/xstring.h"
 
@@ -49,7 +56,7 @@ ROMReader_struct * ROMReaderInit(char ** filename)
 		return &ZIPROMReader;
 	}
 #endif
-	return &STDROMReader;
+	return &MMAPROMReader;
 }
 
 void * STDROMReaderInit(const char * filename);
@@ -150,6 +157,269 @@ int STDROMReaderWrite(void *, void *, u32)
 	return 0;
 }
 
+void * MMAPROMReaderInit(const char * filename);
+void MMAPROMReaderDeInit(void *);
+u32 MMAPROMReaderSize(void *);
+int MMAPROMReaderSeek(void *, int, int);
+int MMAPROMReaderRead(void *, void *, u32);
+int MMAPROMReaderWrite(void *, void *, u32);
+
+//maps the whole file instead of going through stdio, so that streamed card reads are plain memory copies.
+//only the pages that actually get read are brought in, and they are shared between instances running the same rom
+ROMReader_struct MMAPROMReader =
+{
+	ROMREADER_MMAP,
+	"Memory-Mapped ROM Reader",
+	MMAPROMReaderInit,
+	MMAPROMReaderDeInit,
+	MMAPROMReaderSize,
+	MMAPROMReaderSeek,
+	MMAPROMReaderRead,
+	MMAPROMReaderWrite
+};
+
+struct MMAPROMReaderData
+{
+	u8* data;
+	u32 size;
+	long pos;
+#ifdef WIN32
+	HANDLE mapping;
+#endif
+};
+
+void* MMAPROMReaderInit(const char* filename)
+{
+#ifdef WIN32
+	HANDLE inf = CreateFileW(mbstowcs((std::string)filename).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (inf == INVALID_HANDLE_VALUE) return NULL;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(inf, &size) || size.QuadPart == 0 || size.QuadPart > 0xFFFFFFFF)
+	{
+		CloseHandle(inf);
+		return NULL;
+	}
+
+	//the mapping keeps the file open by itself
+	HANDLE mapping = CreateFileMappingW(inf, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(inf);
+	if (mapping == NULL) return NULL;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+	{
+		CloseHandle(mapping);
+		return NULL;
+	}
+
+	MMAPROMReaderData* ret = new MMAPROMReaderData();
+	ret->mapping = mapping;
+	const u64 fileSize = size.QuadPart;
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) return NULL;
+
+	struct stat sb;
+	if (fstat(fd, &sb) == -1 || (sb.st_mode & S_IFMT) != S_IFREG || sb.st_size == 0 || (u64)sb.st_size > 0xFFFFFFFF)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	//the mapping keeps the file open by itself
+	void* data = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return NULL;
+
+	MMAPROMReaderData* ret = new MMAPROMReaderData();
+	const u64 fileSize = sb.st_size;
+#endif
+
+	ret->data = (u8*)data;
+	ret->size = (u32)fileSize;
+	ret->pos = 0;
+	return (void*)ret;
+}
+
+void MMAPROMReaderDeInit(void * file)
+{
+	if (!file) return;
+	MMAPROMReaderData* data = (MMAPROMReaderData*)file;
+#ifdef WIN32
+	UnmapViewOfFile(data->data);
+	CloseHandle(data->mapping);
+#else
+	munmap(data->data, data->size);
+#endif
+	delete data;
+}
+
+u32 MMAPROMReaderSize(void * file)
+{
+	if (!file) return 0;
+	return ((MMAPROMReaderData*)file)->size;
+}
+
+int MMAPROMReaderSeek(void * file, int offset, int whence)
+{
+	//same return value as the standard reader
+	if (!file) return 0;
+	MMAPROMReaderData* data = (MMAPROMReaderData*)file;
+	switch (whence)
+	{
+		case SEEK_SET: data->pos = offset; break;
+		case SEEK_CUR: data->pos += offset; break;
+		case SEEK_END: data->pos = (long)data->size + offset; break;
+	}
+	if (data->pos < 0) data->pos = 0;
+	return 1;
+}
+
+int MMAPROMReaderRead(void * file, void * buffer, u32 size)
+{
+	if (!file) return 0;
+	MMAPROMReaderData* data = (MMAPROMReaderData*)file;
+	if ((u32)data->pos >= data->size) return 0;
+
+	u32 todo = data->size - (u32)data->pos;
+	if (size < todo) todo = size;
+
+	memcpy(buffer, data->data + data->pos, todo);
+	data->pos += todo;
+	return (int)todo;
+}
+
+int MMAPROMReaderWrite(void *, void *, u32)
+{
+	//the file is mapped read-only
+	return 0;
+}
+
+const u8 * MMAPROMReaderGetData(void * file)
+{
+	if (!file) return NULL;
+	return ((MMAPROMReaderData*)file)->data;
+}
+
+#if defined(HAVE_LIBZ) || defined(HAVE_LIBZZIP)
+//the compressed readers can't seek backwards without decompressing from the start of the stream again,
+//so they keep the most recently used decompressed blocks around and serve reads out of those.
+#define ROMREADER_CACHE_BLOCK_BITS 16
+#define ROMREADER_CACHE_BLOCK_SIZE (1 << ROMREADER_CACHE_BLOCK_BITS)
+#define ROMREADER_CACHE_BLOCKS 16
+
+struct ROMReaderBlockCache
+{
+	struct Block
+	{
+		u32 index;
+		u32 length;
+		u32 lastUse;
+		u8 *data;
+	};
+
+	void *file;
+	int (*rawSeek)(void *file, int offset, int whence);
+	int (*rawRead)(void *file, void *buffer, u32 size);
+	u32 size;
+	u32 pos;
+	u32 rawPos;
+	u32 useCount;
+	Block blocks[ROMREADER_CACHE_BLOCKS];
+};
+
+static void ROMReaderBlockCacheInit(ROMReaderBlockCache &cache, void *file, int (*rawSeek)(void *, int, int), int (*rawRead)(void *, void *, u32), u32 size)
+{
+	cache.file = file;
+	cache.rawSeek = rawSeek;
+	cache.rawRead = rawRead;
+	cache.size = size;
+	cache.pos = 0;
+	cache.rawPos = 0;
+	cache.useCount = 0;
+	for (int i = 0; i < ROMREADER_CACHE_BLOCKS; i++)
+	{
+		cache.blocks[i].index = 0xFFFFFFFF;
+		cache.blocks[i].length = 0;
+		cache.blocks[i].lastUse = 0;
+		cache.blocks[i].data = NULL;
+	}
+}
+
+static void ROMReaderBlockCacheDeInit(ROMReaderBlockCache &cache)
+{
+	for (int i = 0; i < ROMREADER_CACHE_BLOCKS; i++)
+		delete [] cache.blocks[i].data;
+}
+
+static const ROMReaderBlockCache::Block& ROMReaderBlockCacheFetch(ROMReaderBlockCache &cache, u32 index)
+{
+	int victim = 0;
+	for (int i = 0; i < ROMREADER_CACHE_BLOCKS; i++)
+	{
+		if (cache.blocks[i].index == index)
+		{
+			cache.blocks[i].lastUse = ++cache.useCount;
+			return cache.blocks[i];
+		}
+		if (cache.blocks[i].lastUse < cache.blocks[victim].lastUse)
+			victim = i;
+	}
+
+	ROMReaderBlockCache::Block &block = cache.blocks[victim];
+	if (block.data == NULL)
+		block.data = new u8[ROMREADER_CACHE_BLOCK_SIZE];
+
+	const u32 start = index << ROMREADER_CACHE_BLOCK_BITS;
+	if (cache.rawPos != start)
+		cache.rawSeek(cache.file, start, SEEK_SET);
+
+	int read = cache.rawRead(cache.file, block.data, ROMREADER_CACHE_BLOCK_SIZE);
+	if (read < 0) read = 0;
+
+	block.index = index;
+	block.length = (u32)read;
+	block.lastUse = ++cache.useCount;
+	cache.rawPos = start + block.length;
+	return block;
+}
+
+static int ROMReaderBlockCacheSeek(ROMReaderBlockCache &cache, int offset, int whence)
+{
+	switch (whence)
+	{
+		case SEEK_SET: cache.pos = offset; break;
+		case SEEK_CUR: cache.pos += offset; break;
+		case SEEK_END: cache.pos = cache.size + offset; break;
+	}
+	return (int)cache.pos;
+}
+
+static int ROMReaderBlockCacheRead(ROMReaderBlockCache &cache, void *buffer, u32 size)
+{
+	u8 *dst = (u8 *)buffer;
+	u32 done = 0;
+
+	while (done < size)
+	{
+		const ROMReaderBlockCache::Block &block = ROMReaderBlockCacheFetch(cache, cache.pos >> ROMREADER_CACHE_BLOCK_BITS);
+		const u32 ofs = cache.pos & (ROMREADER_CACHE_BLOCK_SIZE - 1);
+		if (ofs >= block.length)
+			break;
+
+		u32 todo = block.length - ofs;
+		if (size - done < todo) todo = size - done;
+
+		memcpy(dst + done, block.data + ofs, todo);
+		done += todo;
+		cache.pos += todo;
+	}
+
+	return (int)done;
+}
+#endif
+
 #ifdef HAVE_LIBZ
 void * GZIPROMReaderInit(const char * filename);
 void GZIPROMReaderDeInit(void *);
@@ -170,39 +440,59 @@ ROMReader_struct GZIPROMReader =
 	GZIPROMReaderWrite
 };
 
-void * GZIPROMReaderInit(const char * filename)
+static int GZIPROMReaderRawSeek(void * file, int offset, int whence)
 {
-	return (void*)gzopen(filename, "rb");
+	return gzseek((gzFile)file, offset, whence);
 }
 
-void GZIPROMReaderDeInit(void * file)
+static int GZIPROMReaderRawRead(void * file, void * buffer, u32 size)
 {
-	gzclose((gzFile)file);
+	return gzread((gzFile)file, buffer, size);
 }
 
-u32 GZIPROMReaderSize(void * file)
+void * GZIPROMReaderInit(const char * filename)
 {
+	gzFile gz = gzopen(filename, "rb");
+	if (gz == NULL) return NULL;
+
+	//the size is needed for SEEK_END, and finding it means decompressing the whole stream once
 	char useless[1024];
 	u32 size = 0;
+	while (gzeof(gz) == 0)
+	{
+		int read = gzread(gz, useless, 1024);
+		if (read <= 0) break;
+		size += read;
+	}
+	gzrewind(gz);
 
-	/* FIXME this function should first save the current
-	 * position and restore it after size calculation */
-	gzrewind((gzFile)file);
-	while (gzeof ((gzFile)file) == 0)
-		size += gzread((gzFile)file, useless, 1024);
-	gzrewind((gzFile)file);
+	ROMReaderBlockCache* cache = new ROMReaderBlockCache();
+	ROMReaderBlockCacheInit(*cache, (void*)gz, GZIPROMReaderRawSeek, GZIPROMReaderRawRead, size);
+	return (void*)cache;
+}
 
-	return size;
+void GZIPROMReaderDeInit(void * file)
+{
+	if (!file) return;
+	ROMReaderBlockCache* cache = (ROMReaderBlockCache*)file;
+	gzclose((gzFile)cache->file);
+	ROMReaderBlockCacheDeInit(*cache);
+	delete cache;
+}
+
+u32 GZIPROMReaderSize(void * file)
+{
+	return ((ROMReaderBlockCache*)file)->size;
 }
 
 int GZIPROMReaderSeek(void * file, int offset, int whence)
 {
-	return gzseek((gzFile)file, offset, whence);
+	return ROMReaderBlockCacheSeek(*(ROMReaderBlockCache*)file, offset, whence);
 }
 
 int GZIPROMReaderRead(void * file, void * buffer, u32 size)
 {
-	return gzread((gzFile)file, buffer, size);
+	return ROMReaderBlockCacheRead(*(ROMReaderBlockCache*)file, buffer, size);
 }
 
 int GZIPROMReaderWrite(void *, void *, u32)
@@ -232,6 +522,20 @@ ROMReader_struct ZIPROMReader =
 	ZIPROMReaderWrite
 };
 
+static int ZIPROMReaderRawSeek(void * file, int offset, int whence)
+{
+	return zzip_seek((ZZIP_FILE*)file, offset, whence);
+}
+
+static int ZIPROMReaderRawRead(void * file, void * buffer, u32 size)
+{
+#ifdef ZZIP_OLD_READ
+	return zzip_read((ZZIP_FILE*)file, (char *) buffer, size);
+#else
+	return zzip_read((ZZIP_FILE*)file, buffer, size);
+#endif
+}
+
 void * ZIPROMReaderInit(const char * filename)
 {
 	ZZIP_DIR * dir = zzip_opendir(filename);
@@ -245,39 +549,43 @@ void * ZIPROMReaderInit(const char * filename)
 		tmp1 = strndup(filename, strlen(filename) - 4);
 		sprintf(tmp2, "%s/%s", tmp1, dirent->d_name);
 		free(tmp1);
-		return zzip_fopen(tmp2, "rb");
+
+		ZZIP_FILE* zf = zzip_fopen(tmp2, "rb");
+		if (zf == NULL) return NULL;
+
+		zzip_seek(zf, 0, SEEK_END);
+		u32 size = zzip_tell(zf);
+		zzip_seek(zf, 0, SEEK_SET);
+
+		ROMReaderBlockCache* cache = new ROMReaderBlockCache();
+		ROMReaderBlockCacheInit(*cache, (void*)zf, ZIPROMReaderRawSeek, ZIPROMReaderRawRead, size);
+		return (void*)cache;
 	}
 	return NULL;
 }
 
 void ZIPROMReaderDeInit(void * file)
 {
-	zzip_close((ZZIP_FILE*)file);
+	if (!file) return;
+	ROMReaderBlockCache* cache = (ROMReaderBlockCache*)file;
+	zzip_close((ZZIP_FILE*)cache->file);
+	ROMReaderBlockCacheDeInit(*cache);
+	delete cache;
 }
 
 u32 ZIPROMReaderSize(void * file)
 {
-	u32 size;
-
-	zzip_seek((ZZIP_FILE*)file, 0, SEEK_END);
-	size = zzip_tell((ZZIP_FILE*)file);
-	zzip_seek((ZZIP_FILE*)file, 0, SEEK_SET);
-
-	return size;
+	return ((ROMReaderBlockCache*)file)->size;
 }
 
 int ZIPROMReaderSeek(void * file, int offset, int whence)
 {
-	return zzip_seek((ZZIP_FILE*)file, offset, whence);
+	return ROMReaderBlockCacheSeek(*(ROMReaderBlockCache*)file, offset, whence);
 }
 
 int ZIPROMReaderRead(void * file, void * buffer, u32 size)
 {
-#ifdef ZZIP_OLD_READ
-	return zzip_read((ZZIP_FILE*)file, (char *) buffer, size);
-#else
-	return zzip_read((ZZIP_FILE*)file, buffer, size);
-#endif
+	return ROMReaderBlockCacheRead(*(ROMReaderBlockCache*)file, buffer, size);
 }
 
 int ZIPROMReaderWrite(void *, void *, u32)
@@ -31,6 +31,7 @@
 #define ROMREADER_GZIP	1
 #define ROMREADER_ZIP	2
 #define ROMREADER_MEM	3
+#define ROMREADER_MMAP	4
 
 typedef struct
 {
@@ -45,6 +46,7 @@ typedef struct
 } ROMReader_struct;
 
 extern ROMReader_struct STDROMReader;
+extern ROMReader_struct MMAPROMReader;
 #ifdef HAVE_LIBZ
 extern ROMReader_struct GZIPROMReader;
 #endif
@@ -55,4 +57,8 @@ extern ROMReader_struct ZIPROMReader;
 ROMReader_struct * ROMReaderInit(char ** filename);
 ROMReader_struct * MemROMReaderRead_TrueInit(void* buf, int length);
 
+//the whole file as mapped by MMAPROMReader.Init(). other read-only data files (e.g. the game databases)
+//use this too, so that they can be searched in place without reading them in
+const u8 * MMAPROMReaderGetData(void * file);
+
 #endif // _ROMREADER_H_
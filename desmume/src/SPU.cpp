@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <queue>
+#include <algorithm>
 #include <vector>
 
 #include "debug.h"
@@ -43,6 +44,10 @@
 #include "matrix.h"
 #include "utils/bits.h"
 
+// SPU_Operations.cpp is included directly so that the block kernels can inline
+// into the channel update loops.
+#include "SPU_Operations.cpp"
+
 
 static inline s16 read16(u32 addr) { return (s16)_MMU_read16<ARMCPU_ARM7,MMU_AT_DEBUG>(addr); }
 static inline u8 read08(u32 addr) { return _MMU_read08<ARMCPU_ARM7,MMU_AT_DEBUG>(addr); }
@@ -115,6 +120,20 @@ static const double samples_per_hline = (DESMUME_SAMPLE_RATE / 59.8261f) / 263.0
 static double _samples = 0;
 int spu_core_samples = 0;
 
+//the core spu is mixed lazily: each hline only records how many samples it owes, and the owed
+//lines are mixed together the next time anything could observe the spu or change what it would read.
+//the lines are remembered individually since a one-shot channel that ends partway through a line
+//still fills out the rest of that line with its interpolation tail.
+#define SPU_CORE_MAX_OWED_LINES 512
+#define SPU_CORE_BUFFER_SAMPLES 1024
+u32 spu_core_owed = 0;
+static u8 _owedLines[SPU_CORE_MAX_OWED_LINES];
+static int _owedLineCount = 0;
+static bool _owedNeedToMix = false;
+u32 spu_watch_main_begin = 0;
+u32 spu_watch_main_size = 0;
+bool spu_watch_wram = false;
+
 template<typename T>
 static FORCEINLINE T MinMax(T val, T min, T max)
 {
@@ -223,7 +242,7 @@ int SPU_Init(int coreid, int newBufferSizeBytes)
 	for (size_t i = 0; i < COSINE_INTERPOLATION_RESOLUTION; i++)
 		cos_lut[i] = (u16)floor((1u<<16) * ((1.0 - cos(((double)i/(double)COSINE_INTERPOLATION_RESOLUTION) * M_PI)) * 0.5));
 
-	SPU_core = new SPU_struct((int)ceil(samples_per_hline));
+	SPU_core = new SPU_struct(SPU_CORE_BUFFER_SAMPLES);
 	SPU_Reset();
 
 	//create adpcm decode accelerator lookups
@@ -261,6 +280,7 @@ void SPU_Pause(int pause)
 
 void SPU_CloneUser()
 {
+	SPU_CatchUp();
 	if(SPU_user) {
 		memcpy(SPU_user->channels,SPU_core->channels,sizeof(SPU_core->channels));
 		SPU_user->regs = SPU_core->regs;
@@ -328,6 +348,10 @@ void SPU_Reset(void)
 		T1WriteByte(MMU.ARM7_REG, i, 0);
 
 	_samples = 0;
+	spu_core_owed = 0;
+	_owedLineCount = 0;
+	spu_watch_main_size = 0;
+	spu_watch_wram = false;
 }
 
 //------------------------------------------
@@ -1092,6 +1116,9 @@ static FORCEINLINE s32 Fetch8BitData(channel_struct *chan, s32 pos)
 {
 	if(pos < 0) return 0;
 
+	if(chan->srcptr != NULL && pos < chan->totlength_shifted)
+		return (s8)chan->srcptr[pos] << 8;
+
 	return read_s8(chan->addr + pos*1) << 8;
 }
 
@@ -1099,6 +1126,9 @@ static FORCEINLINE s32 Fetch16BitData(channel_struct *chan, s32 pos)
 {
 	if(pos < 0) return 0;
 
+	if(chan->srcptr != NULL && pos < chan->totlength_shifted)
+		return (s16)T1ReadWord(chan->srcptr, pos*2);
+
 	return read16(chan->addr + pos*2);
 }
 
@@ -1115,7 +1145,7 @@ static FORCEINLINE s32 FetchADPCMData(channel_struct *chan, s32 pos)
 	}
 	
 	const u32 shift    = (pos&1) * 4;
-	const u32 data4bit = ((u32)read08(chan->addr + (pos>>1))) >> shift;
+	const u32 data4bit = ((chan->srcptr != NULL && pos < chan->totlength_shifted) ? (u32)chan->srcptr[pos>>1] : (u32)read08(chan->addr + (pos>>1))) >> shift;
 	const s32 diff = precalcdifftbl [chan->index][data4bit & 0xF];
 	chan->index    = precalcindextbl[chan->index][data4bit & 0x7];
 
@@ -1221,37 +1251,109 @@ template<int CHANNELS> FORCEINLINE static void SPU_Mix(SPU_struct* SPU, channel_
 	SPU->lastdata = data;
 }
 
+template<int FORMAT> FORCEINLINE static void SPU_ChanAdvance(SPU_struct* const SPU, channel_struct* const chan)
+{
+	// Advance sampcnt one sample at a time. This is
+	// needed to keep pcm16b[] filled for interpolation.
+	u32 nSamplesToSkip = chan->sampincInt + AddAndReturnCarry(&chan->sampcntFrac, chan->sampincFrac);
+	while(nSamplesToSkip--)
+	{
+		s16 data = 0;
+		s32 pos = chan->sampcntInt;
+		if(chan->status != CHANSTAT_STOPPED)
+		{
+			switch(FORMAT)
+			{
+				case 0: data = Fetch8BitData (chan, pos); break;
+				case 1: data = Fetch16BitData(chan, pos); break;
+				case 2: data = FetchADPCMData(chan, pos); break;
+				case 3: data = FetchPSGData  (chan, pos); break;
+				default: break;
+			}
+		}
+		chan->pcm16bOffs++;
+		chan->pcm16b[SPUCHAN_PCM16B_AT(chan->pcm16bOffs)] = data;
+
+		chan->sampcntInt++;
+		if (FORMAT != 3) TestForLoop<FORMAT>(SPU, chan);
+	}
+}
+
+//records what Interpolate() would read for the current position, for the block kernels to use later
+template<SPUInterpolationMode INTERPOLATE_MODE> FORCEINLINE static void SPU_GatherTaps(SPUMixBlock &block, const size_t i, const channel_struct* const chan)
+{
+	const s16 *pcm16b = chan->pcm16b;
+	const u8 pcm16bOffs = chan->pcm16bOffs;
+
+	switch (INTERPOLATE_MODE)
+	{
+		case SPUInterpolation_CatmullRom:
+		{
+			const u16 *w = catmullrom_lut[chan->sampcntFrac >> (32 - CATMULLROM_INTERPOLATION_RESOLUTION_BITS)];
+			block.tap[0][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 3)];
+			block.tap[1][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 2)];
+			block.tap[2][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 1)];
+			block.tap[3][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 0)];
+			block.weight[0][i] = w[0];
+			block.weight[1][i] = w[1];
+			block.weight[2][i] = w[2];
+			block.weight[3][i] = w[3];
+			break;
+		}
+
+		case SPUInterpolation_Cosine:
+			block.tap[0][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 1)];
+			block.tap[1][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 0)];
+			block.weight[0][i] = cos_lut[chan->sampcntFrac >> (32 - COSINE_INTERPOLATION_RESOLUTION_BITS)];
+			break;
+
+		case SPUInterpolation_Linear:
+			block.tap[0][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 1)];
+			block.tap[1][i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs - 0)];
+			block.weight[0][i] = chan->sampcntFrac >> (32 - 16);
+			break;
+
+		default:
+			block.data[i] = pcm16b[SPUCHAN_PCM16B_AT(pcm16bOffs)];
+			break;
+	}
+}
+
 //WORK
 template<int FORMAT, SPUInterpolationMode INTERPOLATE_MODE, int CHANNELS> 
 	FORCEINLINE static void ____SPU_ChanUpdate(SPU_struct* const SPU, channel_struct* const chan)
 {
-	for (; SPU->bufpos < SPU->buflength; SPU->bufpos++)
+	if (CHANNELS != -1 && (SPU->buflength - SPU->bufpos) >= SPU_MIXBLOCK_MINIMUM)
 	{
-		// Advance sampcnt one sample at a time. This is
-		// needed to keep pcm16b[] filled for interpolation.
-		u32 nSamplesToSkip = chan->sampincInt + AddAndReturnCarry(&chan->sampcntFrac, chan->sampincFrac);
-		while(nSamplesToSkip--)
+		//fetching has to stay serial, but everything after it can be done a block at a time.
+		//the volume and pan can't change partway through, since nothing writes the registers while we mix.
+		SPUMixBlock block;
+		const u8 volShift = volume_shift[chan->volumeDiv];
+
+		while (SPU->bufpos < SPU->buflength)
 		{
-			s16 data = 0;
-			s32 pos = chan->sampcntInt;
-			if(chan->status != CHANSTAT_STOPPED)
+			const size_t count = std::min<u32>(SPU->buflength - SPU->bufpos, SPU_MIXBLOCK_SAMPLES);
+
+			for (size_t i = 0; i < count; i++)
 			{
-				switch(FORMAT)
-				{
-					case 0: data = Fetch8BitData (chan, pos); break;
-					case 1: data = Fetch16BitData(chan, pos); break;
-					case 2: data = FetchADPCMData(chan, pos); break;
-					case 3: data = FetchPSGData  (chan, pos); break;
-					default: break;
-				}
+				SPU_ChanAdvance<FORMAT>(SPU, chan);
+				SPU_GatherTaps<INTERPOLATE_MODE>(block, i, chan);
 			}
-			chan->pcm16bOffs++;
-			chan->pcm16b[SPUCHAN_PCM16B_AT(chan->pcm16bOffs)] = data;
 
-			chan->sampcntInt++;
-			if (FORMAT != 3) TestForLoop<FORMAT>(SPU, chan);
+			SPU_InterpolateBlock<INTERPOLATE_MODE>(block, count);
+			SPU_MixBlock<CHANNELS>(SPU->sndbuf + (SPU->bufpos << 1), block.data, count, chan->vol, volShift, chan->pan);
+
+			SPU->lastdata = block.data[count - 1];
+			SPU->bufpos += count;
 		}
 
+		return;
+	}
+
+	for (; SPU->bufpos < SPU->buflength; SPU->bufpos++)
+	{
+		SPU_ChanAdvance<FORMAT>(SPU, chan);
+
 		if(CHANNELS != -1)
 		{
 			s32 data = Interpolate<INTERPOLATE_MODE>(chan->pcm16b, chan->pcm16bOffs, chan->sampcntFrac);
@@ -1300,19 +1402,230 @@ FORCEINLINE static void _SPU_ChanUpdate(const bool actuallyMix, SPU_struct* cons
 	}
 }
 
-//ENTERNEW
-static void SPU_MixAudio_Advanced(bool actuallyMix, SPU_struct *SPU, int length)
+//advanced mixer: mixes up to length samples of one channel into its own interleaved stereo buffer,
+//also keeping the unpanned output for the capture units.
+//like the per-sample mixer, the channel goes quiet right after the sample where it keys off.
+template<int FORMAT, SPUInterpolationMode INTERPOLATE_MODE, int CHANNELS> 
+	FORCEINLINE static void ____SPU_ChanSpan(SPU_struct* const SPU, channel_struct* const chan, s32 *__restrict submix, s32 *__restrict chanout, const int length)
 {
-	//the advanced spu function correctly handles all sound control mixing options, as well as capture
-	//this code is not entirely optimal, as it relies on sort of manhandling the core mixing functions
-	//in order to get the results it needs.
+	SPUMixBlock block;
+	const u8 volShift = volume_shift[chan->volumeDiv];
+	int done = 0;
 
-	//THIS IS MAX HACKS!!!!
-	//AND NEEDS TO BE REWRITTEN ALONG WITH THE DEEPEST PARTS OF THE SPU
-	//ONCE WE KNOW THAT IT WORKS
-	
-	//BIAS gets ignored since our spu is still not bit perfect,
-	//and it doesnt matter for purposes of capture
+	while (done < length && chan->status == CHANSTAT_PLAY)
+	{
+		const size_t count = std::min<int>(length - done, SPU_MIXBLOCK_SAMPLES);
+		size_t i = 0;
+
+		while (i < count)
+		{
+			SPU_ChanAdvance<FORMAT>(SPU, chan);
+			SPU_GatherTaps<INTERPOLATE_MODE>(block, i++, chan);
+			if (chan->status != CHANSTAT_PLAY) break;
+		}
+
+		SPU_InterpolateBlock<INTERPOLATE_MODE>(block, i);
+		SPU_MixBlock<CHANNELS>(submix + (done * 2), block.data, i, chan->vol, volShift, chan->pan);
+
+		for (size_t j = 0; j < i; j++)
+			chanout[done + j] = block.data[j] >> volShift;
+
+		SPU->lastdata = block.data[i - 1];
+		done += i;
+	}
+}
+
+template<int FORMAT, SPUInterpolationMode INTERPOLATE_MODE> 
+	FORCEINLINE static void ___SPU_ChanSpan(SPU_struct* const SPU, channel_struct* const chan, s32 *__restrict submix, s32 *__restrict chanout, const int length)
+{
+	if (chan->pan == 0)
+		____SPU_ChanSpan<FORMAT,INTERPOLATE_MODE,0>(SPU, chan, submix, chanout, length);
+	else if (chan->pan == 127)
+		____SPU_ChanSpan<FORMAT,INTERPOLATE_MODE,2>(SPU, chan, submix, chanout, length);
+	else
+		____SPU_ChanSpan<FORMAT,INTERPOLATE_MODE,1>(SPU, chan, submix, chanout, length);
+}
+
+template<SPUInterpolationMode INTERPOLATE_MODE> 
+	FORCEINLINE static void __SPU_ChanSpan(SPU_struct* const SPU, channel_struct* const chan, s32 *__restrict submix, s32 *__restrict chanout, const int length)
+{
+	switch(chan->format)
+	{
+		case 0: ___SPU_ChanSpan<0,INTERPOLATE_MODE>(SPU, chan, submix, chanout, length); break;
+		case 1: ___SPU_ChanSpan<1,INTERPOLATE_MODE>(SPU, chan, submix, chanout, length); break;
+		case 2: ___SPU_ChanSpan<2,INTERPOLATE_MODE>(SPU, chan, submix, chanout, length); break;
+		case 3: ___SPU_ChanSpan<3,SPUInterpolation_None>(SPU, chan, submix, chanout, length); break;
+		default: assert(false);
+	}
+}
+
+static void _SPU_ChanSpan(SPU_struct* const SPU, channel_struct* const chan, s32 *__restrict submix, s32 *__restrict chanout, const int length)
+{
+	switch(CommonSettings.spuInterpolationMode)
+	{
+	case SPUInterpolation_None:       __SPU_ChanSpan<SPUInterpolation_None>(SPU, chan, submix, chanout, length); break;
+	case SPUInterpolation_Linear:     __SPU_ChanSpan<SPUInterpolation_Linear>(SPU, chan, submix, chanout, length); break;
+	case SPUInterpolation_Cosine:     __SPU_ChanSpan<SPUInterpolation_Cosine>(SPU, chan, submix, chanout, length); break;
+	case SPUInterpolation_CatmullRom: __SPU_ChanSpan<SPUInterpolation_CatmullRom>(SPU, chan, submix, chanout, length); break;
+	default: assert(false);
+	}
+}
+
+//creates the speaker output and capture input for one sample.
+//sub1 and sub3 are the panned outputs of channels 1 and 3, chanout holds the unpanned outputs of channels 0-3
+static FORCEINLINE void SPU_RouteSample(const SPU_struct *SPU, const s32 *mix, const s32 *capmix, const s32 *sub1, const s32 *sub3, const s32 *chanout, s32 *sndout, s32 *capout)
+{
+	//create SPU output
+	switch (SPU->regs.ctl_left)
+	{
+		case SPU_struct::REGS::LOM_LEFT_MIXER: sndout[0] = mix[0]; break;
+		case SPU_struct::REGS::LOM_CH1: sndout[0] = sub1[0]; break;
+		case SPU_struct::REGS::LOM_CH3: sndout[0] = sub3[0]; break;
+		case SPU_struct::REGS::LOM_CH1_PLUS_CH3: sndout[0] = sub1[0] + sub3[0]; break;
+		default: break;
+	}
+	switch (SPU->regs.ctl_right)
+	{
+		case SPU_struct::REGS::ROM_RIGHT_MIXER: sndout[1] = mix[1]; break;
+		case SPU_struct::REGS::ROM_CH1: sndout[1] = sub1[1]; break;
+		case SPU_struct::REGS::ROM_CH3: sndout[1] = sub3[1]; break;
+		case SPU_struct::REGS::ROM_CH1_PLUS_CH3: sndout[1] = sub1[1] + sub3[1]; break;
+		default: break;
+	}
+
+
+	//generate capture output ("capture bugs" from gbatek are not emulated)
+	if (SPU->regs.cap[0].source == 0)
+		capout[0] = capmix[0]; //cap0 = L-mix
+	else if (SPU->regs.cap[0].add)
+		capout[0] = chanout[0] + chanout[1]; //cap0 = ch0+ch1
+	else capout[0] = chanout[0]; //cap0 = ch0
+
+	if (SPU->regs.cap[1].source == 0)
+		capout[1] = capmix[1]; //cap1 = R-mix
+	else if (SPU->regs.cap[1].add)
+		capout[1] = chanout[2] + chanout[3]; //cap1 = ch2+ch3
+	else capout[1] = chanout[2]; //cap1 = ch2
+
+	capout[0] = MinMax(capout[0],-0x8000,0x7FFF);
+	capout[1] = MinMax(capout[1],-0x8000,0x7FFF);
+}
+
+//feeds one sample to each running capture unit
+static FORCEINLINE void SPU_CaptureSample(SPU_struct *SPU, const s32 *capout, const bool skipcap)
+{
+	for (int capchan = 0; capchan < 2; capchan++)
+	{
+		SPU_struct::REGS::CAP& cap = SPU->regs.cap[capchan];
+		channel_struct& srcChan = SPU->channels[1 + 2 * capchan];
+		if (SPU->regs.cap[capchan].runtime.running)
+		{
+			u32 nSamplesToProcess = srcChan.sampincInt + AddAndReturnCarry(&cap.runtime.sampcntFrac, srcChan.sampincFrac);
+			cap.runtime.sampcntInt += nSamplesToProcess;
+			while(nSamplesToProcess--)
+			{
+				//so, this is a little strange. why go through a fifo?
+				//it seems that some games will set up a reverb effect by capturing
+				//to the nearly same address as playback, but ahead by a couple.
+				//So, playback will always end up being what was captured a couple of samples ago.
+				//This system counts on playback always having read ahead 16 samples.
+				//In that case, playback will end up being what was processed at one entire buffer length ago,
+				//since the 16 samples would have read ahead before they got captured over
+
+				//It's actually the source channels which should have a fifo, but we are
+				//not going to take the hit in speed and complexity. Save it for a future rewrite.
+				//Instead, what we do here is delay the capture by 16 samples to create a similar effect.
+				//Subjectively, it seems to be working.
+
+				//Don't do anything until the fifo is filled, so as to delay it
+				if (cap.runtime.fifo.size < 16)
+				{
+					cap.runtime.fifo.enqueue(capout[capchan]);
+					continue;
+				}
+
+				//(actually capture sample from fifo instead of most recently generated)
+				u32 multiplier;
+				s32 sample = cap.runtime.fifo.dequeue();
+				cap.runtime.fifo.enqueue(capout[capchan]);
+
+				//static FILE* fp = NULL;
+				//if(!fp) fp = fopen("d:\\capout.raw","wb");
+				//fwrite(&sample,2,1,fp);
+				
+				if (cap.bits8)
+				{
+					s8 sample8 = sample >> 8;
+					if (skipcap) _MMU_write08<1,MMU_AT_DMA>(cap.runtime.curdad,0);
+					else _MMU_write08<1,MMU_AT_DMA>(cap.runtime.curdad,sample8);
+					cap.runtime.curdad++;
+					multiplier = 4;
+				}
+				else
+				{
+					s16 sample16 = sample;
+					if (skipcap) _MMU_write16<1,MMU_AT_DMA>(cap.runtime.curdad,0);
+					else _MMU_write16<1,MMU_AT_DMA>(cap.runtime.curdad,sample16);
+					cap.runtime.curdad+=2;
+					multiplier = 2;
+				}
+
+				if (cap.runtime.curdad >= cap.runtime.maxdad)
+				{
+					cap.runtime.curdad = cap.dad;
+					cap.runtime.sampcntInt -= cap.len*multiplier;
+				}
+			} //sampinc loop
+		} //if capchan running
+	} //capchan loop
+}
+
+//the block mixer runs every channel over a whole span before doing the capture for that span.
+//that is only the same as going one sample at a time when a capture can't write over
+//sample data that a playing channel is about to read, and when every channel gets mixed
+//(a muted channel leaves a stale lastdata behind for the capture units, which we don't try to reproduce)
+static bool SPU_AdvancedNeedsSampleStep(SPU_struct *SPU)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		if (SPU->channels[i].status == CHANSTAT_PLAY && CommonSettings.spu_muteChannels[i])
+			return true;
+	}
+
+	for (int capchan = 0; capchan < 2; capchan++)
+	{
+		const SPU_struct::REGS::CAP &cap = SPU->regs.cap[capchan];
+		if (!cap.runtime.running)
+			continue;
+
+		//compare host pointers so that mirrors and wram mappings are taken into account
+		const u8 *capBegin = MMU_GetARM7ReadSpan(cap.dad, cap.runtime.maxdad - cap.dad);
+		if (capBegin == NULL)
+			return true;
+		const u8 *capEnd = capBegin + (cap.runtime.maxdad - cap.dad);
+
+		for (int i = 0; i < 16; i++)
+		{
+			const channel_struct &chan = SPU->channels[i];
+			if (chan.status != CHANSTAT_PLAY || chan.format == 3)
+				continue;
+
+			if (chan.srcptr == NULL)
+				return true;
+
+			const u8 *srcEnd = chan.srcptr + (chan.totlength * 4);
+			if (chan.srcptr < capEnd && capBegin < srcEnd)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static void SPU_MixAudio_AdvancedPerSample(SPU_struct *SPU, int length)
+{
+	//this is the original advanced mixer, which steps every channel and the capture units
+	//together one sample at a time. it is kept for the cases the block mixer can't reproduce.
 
 	//-----------DEBUG CODE
 	bool skipcap = false;
@@ -1320,8 +1633,6 @@ static void SPU_MixAudio_Advanced(bool actuallyMix, SPU_struct *SPU, int length)
 
 	s32 samp0[2] = {0,0};
 	
-	//believe it or not, we are going to do this one sample at a time.
-	//like i said, it is slower.
 	for (int samp = 0; samp < length; samp++)
 	{
 		SPU->sndbuf[0] = 0;
@@ -1392,45 +1703,9 @@ static void SPU_MixAudio_Advanced(bool actuallyMix, SPU_struct *SPU, int length)
 			}
 		} //foreach channel
 
-		s32 mixout[2] = {mix[0],mix[1]};
-		s32 capmixout[2] = {capmix[0],capmix[1]};
 		s32 sndout[2];
 		s32 capout[2];
-
-		//create SPU output
-		switch (SPU->regs.ctl_left)
-		{
-			case SPU_struct::REGS::LOM_LEFT_MIXER: sndout[0] = mixout[0]; break;
-			case SPU_struct::REGS::LOM_CH1: sndout[0] = submix[1*2+0]; break;
-			case SPU_struct::REGS::LOM_CH3: sndout[0] = submix[3*2+0]; break;
-			case SPU_struct::REGS::LOM_CH1_PLUS_CH3: sndout[0] = submix[1*2+0] + submix[3*2+0]; break;
-			default: break;
-		}
-		switch (SPU->regs.ctl_right)
-		{
-			case SPU_struct::REGS::ROM_RIGHT_MIXER: sndout[1] = mixout[1]; break;
-			case SPU_struct::REGS::ROM_CH1: sndout[1] = submix[1*2+1]; break;
-			case SPU_struct::REGS::ROM_CH3: sndout[1] = submix[3*2+1]; break;
-			case SPU_struct::REGS::ROM_CH1_PLUS_CH3: sndout[1] = submix[1*2+1] + submix[3*2+1]; break;
-			default: break;
-		}
-
-
-		//generate capture output ("capture bugs" from gbatek are not emulated)
-		if (SPU->regs.cap[0].source == 0)
-			capout[0] = capmixout[0]; //cap0 = L-mix
-		else if (SPU->regs.cap[0].add)
-			capout[0] = chanout[0] + chanout[1]; //cap0 = ch0+ch1
-		else capout[0] = chanout[0]; //cap0 = ch0
-
-		if (SPU->regs.cap[1].source == 0)
-			capout[1] = capmixout[1]; //cap1 = R-mix
-		else if (SPU->regs.cap[1].add)
-			capout[1] = chanout[2] + chanout[3]; //cap1 = ch2+ch3
-		else capout[1] = chanout[2]; //cap1 = ch2
-
-		capout[0] = MinMax(capout[0],-0x8000,0x7FFF);
-		capout[1] = MinMax(capout[1],-0x8000,0x7FFF);
+		SPU_RouteSample(SPU, mix, capmix, &submix[1*2], &submix[3*2], chanout, sndout, capout);
 
 		//write the output sample where it is supposed to go
 		if (samp == 0)
@@ -1444,78 +1719,90 @@ static void SPU_MixAudio_Advanced(bool actuallyMix, SPU_struct *SPU, int length)
 			SPU->sndbuf[samp*2+1] = sndout[1];
 		}
 
-		for (int capchan = 0; capchan < 2; capchan++)
+		SPU_CaptureSample(SPU, capout, skipcap);
+	} //main sample loop
+
+	SPU->sndbuf[0] = samp0[0];
+	SPU->sndbuf[1] = samp0[1];
+}
+
+//ENTERNEW
+static void SPU_MixAudio_Advanced(bool actuallyMix, SPU_struct *SPU, int length)
+{
+	//the advanced spu function correctly handles all sound control mixing options, as well as capture.
+	//BIAS gets ignored since our spu is still not bit perfect,
+	//and it doesnt matter for purposes of capture
+
+	if (SPU_AdvancedNeedsSampleStep(SPU))
+	{
+		SPU_MixAudio_AdvancedPerSample(SPU, length);
+		return;
+	}
+
+	//-----------DEBUG CODE
+	bool skipcap = false;
+	//-----------------
+
+	//nothing is muted here, so every playing channel reaches both the mixer and the capture mix
+	//unless it is bypassed, and the capture mix is the same as the main mix.
+	CACHE_ALIGN s32 mix[SPU_MIXBLOCK_SAMPLES*2];
+	CACHE_ALIGN s32 submix[SPU_MIXBLOCK_SAMPLES*2];
+	CACHE_ALIGN s32 sub1[SPU_MIXBLOCK_SAMPLES*2];
+	CACHE_ALIGN s32 sub3[SPU_MIXBLOCK_SAMPLES*2];
+	CACHE_ALIGN s32 chanout[SPU_MIXBLOCK_SAMPLES*4];
+	CACHE_ALIGN s32 chanspan[SPU_MIXBLOCK_SAMPLES];
+
+	for (int base = 0; base < length; base += SPU_MIXBLOCK_SAMPLES)
+	{
+		const int count = std::min<int>(length - base, SPU_MIXBLOCK_SAMPLES);
+
+		memset(mix, 0, sizeof(mix));
+		memset(sub1, 0, sizeof(sub1));
+		memset(sub3, 0, sizeof(sub3));
+		memset(chanout, 0, sizeof(chanout));
+
+		for (int i = 0; i < 16; i++)
 		{
-			SPU_struct::REGS::CAP& cap = SPU->regs.cap[capchan];
-			channel_struct& srcChan = SPU->channels[1 + 2 * capchan];
-			if (SPU->regs.cap[capchan].runtime.running)
-			{
-				u32 nSamplesToProcess = srcChan.sampincInt + AddAndReturnCarry(&cap.runtime.sampcntFrac, srcChan.sampincFrac);
-				cap.runtime.sampcntInt += nSamplesToProcess;
-				while(nSamplesToProcess--)
-				{
-					//so, this is a little strange. why go through a fifo?
-					//it seems that some games will set up a reverb effect by capturing
-					//to the nearly same address as playback, but ahead by a couple.
-					//So, playback will always end up being what was captured a couple of samples ago.
-					//This system counts on playback always having read ahead 16 samples.
-					//In that case, playback will end up being what was processed at one entire buffer length ago,
-					//since the 16 samples would have read ahead before they got captured over
-
-					//It's actually the source channels which should have a fifo, but we are
-					//not going to take the hit in speed and complexity. Save it for a future rewrite.
-					//Instead, what we do here is delay the capture by 16 samples to create a similar effect.
-					//Subjectively, it seems to be working.
-
-					//Don't do anything until the fifo is filled, so as to delay it
-					if (cap.runtime.fifo.size < 16)
-					{
-						cap.runtime.fifo.enqueue(capout[capchan]);
-						continue;
-					}
+			channel_struct *chan = &SPU->channels[i];
+			if (chan->status != CHANSTAT_PLAY)
+				continue;
 
-					//(actually capture sample from fifo instead of most recently generated)
-					u32 multiplier;
-					s32 sample = cap.runtime.fifo.dequeue();
-					cap.runtime.fifo.enqueue(capout[capchan]);
+			bool bypass = false;
+			if (i==1 && SPU->regs.ctl_ch1bypass) bypass=true;
+			if (i==3 && SPU->regs.ctl_ch3bypass) bypass=true;
 
-					//static FILE* fp = NULL;
-					//if(!fp) fp = fopen("d:\\capout.raw","wb");
-					//fwrite(&sample,2,1,fp);
-					
-					if (cap.bits8)
-					{
-						s8 sample8 = sample >> 8;
-						if (skipcap) _MMU_write08<1,MMU_AT_DMA>(cap.runtime.curdad,0);
-						else _MMU_write08<1,MMU_AT_DMA>(cap.runtime.curdad,sample8);
-						cap.runtime.curdad++;
-						multiplier = 4;
-					}
-					else
-					{
-						s16 sample16 = sample;
-						if (skipcap) _MMU_write16<1,MMU_AT_DMA>(cap.runtime.curdad,0);
-						else _MMU_write16<1,MMU_AT_DMA>(cap.runtime.curdad,sample16);
-						cap.runtime.curdad+=2;
-						multiplier = 2;
-					}
+			//anything past the point where the channel stops stays silent
+			memset(submix, 0, sizeof(s32) * count * 2);
+			memset(chanspan, 0, sizeof(s32) * count);
+			_SPU_ChanSpan(SPU, chan, submix, chanspan, count);
 
-					if (cap.runtime.curdad >= cap.runtime.maxdad)
-					{
-						cap.runtime.curdad = cap.dad;
-						cap.runtime.sampcntInt -= cap.len*multiplier;
-					}
-				} //sampinc loop
-			} //if capchan running
-		} //capchan loop
-	} //main sample loop
+			if (!bypass)
+			{
+				for (int j = 0; j < count*2; j++)
+					mix[j] += submix[j];
+			}
 
-	SPU->sndbuf[0] = samp0[0];
-	SPU->sndbuf[1] = samp0[1];
+			if (i == 1) memcpy(sub1, submix, sizeof(s32) * count * 2);
+			if (i == 3) memcpy(sub3, submix, sizeof(s32) * count * 2);
+
+			if (i < 4)
+			{
+				for (int j = 0; j < count; j++)
+					chanout[j*4 + i] = chanspan[j];
+			}
+		}
+
+		for (int j = 0; j < count; j++)
+		{
+			s32 capout[2];
+			SPU_RouteSample(SPU, &mix[j*2], &mix[j*2], &sub1[j*2], &sub3[j*2], &chanout[j*4], &SPU->sndbuf[(base + j)*2], capout);
+			SPU_CaptureSample(SPU, capout, skipcap);
+		}
+	}
 }
 
 //ENTER
-static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
+static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length, const u8 *lines = NULL, int lineCount = 0)
 {
 	if (actuallyMix)
 	{
@@ -1529,6 +1816,14 @@ static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
 	//is this still a good idea? zeroing the capture buffers is important...
 	if(!SPU->regs.masteren) return;
 
+	//point each playing channel straight at its sample data when that lies in plain ram.
+	//this is redone for every mix, so new source addresses, WRAM remaps and loaded states are all picked up
+	for (int i = 0; i < 16; i++)
+	{
+		channel_struct &chan = SPU->channels[i];
+		chan.srcptr = (chan.status == CHANSTAT_PLAY && chan.format != 3) ? MMU_GetARM7ReadSpan(chan.addr, chan.totlength * 4) : NULL;
+	}
+
 	bool advanced = CommonSettings.spu_advanced;
 
 	//branch here so that slow computers don't have to take the advanced (slower) codepath.
@@ -1549,6 +1844,18 @@ static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
 				continue;
 
 			SPU->bufpos = 0;
+
+			//a one-shot channel may end partway through, so keep to the original line boundaries for it
+			if (lines != NULL && chan->repeat != 1 && chan->format != 3)
+			{
+				for (int line = 0; line < lineCount && chan->status == CHANSTAT_PLAY; line++)
+				{
+					SPU->buflength = SPU->bufpos + lines[line];
+					_SPU_ChanUpdate(!CommonSettings.spu_muteChannels[i] && actuallyMix, SPU, chan);
+				}
+				continue;
+			}
+
 			SPU->buflength = length;
 
 			// Mix audio
@@ -1605,19 +1912,117 @@ static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
 
 	// convert from 32-bit->16-bit
 	if (actuallyMix && speakers)
-		for (int i = 0; i < length*2; i++)
+		SPU_MasterVolumeBlock(SPU->sndbuf, SPU->outbuf, length*2, vol);
+
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+
+//decides whether the core spu can put off mixing: every playing channel has to be reading
+//from main memory or wram (whose writes are watched) and nothing may be capturing back into memory.
+static bool SPU_SetupWatch()
+{
+	SPU_struct *SPU = SPU_core;
+
+	spu_watch_main_size = 0;
+	spu_watch_wram = false;
+
+	//mixing reads nothing at all while master enable is off
+	if (!SPU->regs.masteren)
+		return true;
+
+	if (SPU->regs.cap[0].runtime.running || SPU->regs.cap[1].runtime.running)
+		return false;
+
+	const u32 mainSize = _MMU_MAIN_MEM_MASK + 1;
+	u32 lo = 0xFFFFFFFF;
+	u32 hi = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		const channel_struct &chan = SPU->channels[i];
+		if (chan.status != CHANSTAT_PLAY || chan.format == 3)
+			continue;
+
+		//a looping adpcm channel this short never wraps, and would read off the end
+		if (chan.format == 2 && chan.repeat == 1 && chan.totlength < 4)
+			return false;
+
+		const u32 begin = chan.addr;
+		const u32 size = chan.totlength * 4;
+		const u32 last = begin + size - 1;
+
+		if ((begin >> 24) == 3 && (last >> 24) == 3)
 		{
-			// Apply Master Volume
-			SPU->sndbuf[i] = spumuldiv7(SPU->sndbuf[i], vol);
-			s16 outsample = MinMax(SPU->sndbuf[i],-0x8000,0x7FFF);
-			SPU->outbuf[i] = outsample;
+			spu_watch_wram = true;
+			continue;
 		}
 
+		if ((begin >> 24) != 2 || (last >> 24) != 2)
+			return false;
 
+		const u32 ofs = begin & _MMU_MAIN_MEM_MASK;
+		if (size >= mainSize || ofs + size > mainSize)
+		{
+			lo = 0;
+			hi = mainSize;
+		}
+		else
+		{
+			lo = std::min(lo, ofs);
+			hi = std::max(hi, ofs + size);
+		}
+	}
+
+	if (hi > lo)
+	{
+		spu_watch_main_begin = lo;
+		spu_watch_main_size = hi - lo;
+	}
+
+	return true;
 }
 
-//////////////////////////////////////////////////////////////////////////////
+void SPU_MixOwed()
+{
+	SoundInterface_struct *soundProcessor = SPU_SoundCore();
+	const bool needToMix = _owedNeedToMix;
+	const int lineCount = _owedLineCount;
+
+	//drop the watch before mixing, since the mix itself may write captured samples
+	spu_core_owed = 0;
+	_owedLineCount = 0;
+	spu_watch_main_size = 0;
+	spu_watch_wram = false;
+
+	for (int line = 0; line < lineCount; )
+	{
+		//mix as many whole lines as fit in the buffer
+		int firstLine = line;
+		spu_core_samples = 0;
+		while (line < lineCount && spu_core_samples + _owedLines[line] <= SPU_core->bufsize)
+			spu_core_samples += _owedLines[line++];
 
+		SPU_MixAudio(needToMix, SPU_core, spu_core_samples, _owedLines + firstLine, line - firstLine);
+
+		if (soundProcessor != NULL)
+		{
+			if (soundProcessor->FetchSamples != NULL)
+			{
+				soundProcessor->FetchSamples(SPU_core->outbuf, spu_core_samples, _currentSynchMode, _currentSynchronizer);
+			}
+			else
+			{
+				SPU_DefaultFetchSamples(SPU_core->outbuf, spu_core_samples, _currentSynchMode, _currentSynchronizer);
+			}
+		}
+
+		driver->AVI_SoundUpdate(SPU_core->outbuf, spu_core_samples);
+		WAV_WavSoundUpdate(SPU_core->outbuf, spu_core_samples);
+	}
+}
 
 //emulates one hline of the cpu core.
 //this will produce a variable number of samples, calculated to keep a 44100hz output
@@ -1625,11 +2030,10 @@ static void SPU_MixAudio(bool actuallyMix, SPU_struct *SPU, int length)
 void SPU_Emulate_core()
 {
 	bool needToMix = true;
-	SoundInterface_struct *soundProcessor = SPU_SoundCore();
 	
 	_samples += samples_per_hline;
-	spu_core_samples = (int)(_samples);
-	_samples -= spu_core_samples;
+	const int samples = (int)(_samples);
+	_samples -= samples;
 	
 	// We don't need to mix audio for Dual Synch/Asynch mode since we do this
 	// later in SPU_Emulate_user(). Disable mixing here to speed up processing.
@@ -1641,21 +2045,18 @@ void SPU_Emulate_core()
 		needToMix = false;
 	}
 	
-	SPU_MixAudio(needToMix, SPU_core, spu_core_samples);
+	if (spu_core_owed != 0 && (needToMix != _owedNeedToMix || _owedLineCount == SPU_CORE_MAX_OWED_LINES))
+		SPU_MixOwed();
 	
-	if (soundProcessor == NULL)
-	{
-		return;
-	}
+	const bool startingBatch = (_owedLineCount == 0);
+	if (startingBatch)
+		_owedNeedToMix = needToMix;
 	
-	if (soundProcessor->FetchSamples != NULL)
-	{
-		soundProcessor->FetchSamples(SPU_core->outbuf, spu_core_samples, _currentSynchMode, _currentSynchronizer);
-	}
-	else
-	{
-		SPU_DefaultFetchSamples(SPU_core->outbuf, spu_core_samples, _currentSynchMode, _currentSynchronizer);
-	}
+	_owedLines[_owedLineCount++] = (u8)samples;
+	spu_core_owed += samples;
+	
+	if (startingBatch && !SPU_SetupWatch())
+		SPU_MixOwed();
 }
 
 void SPU_Emulate_user(bool mix)
@@ -1914,6 +2315,8 @@ void WAV_WavSoundUpdate(void* soundData, int numSamples, WAVMode mode)
 
 void spu_savestate(EMUFILE &os)
 {
+	SPU_CatchUp();
+
 	//version
 	os.write_32LE(7);
 
@@ -1987,6 +2390,12 @@ bool spu_loadstate(EMUFILE &is, int size)
 	u32 version;
 	if (is.read_32LE(version) != 1) return false;
 
+	//whatever was still owed belongs to the state being replaced
+	spu_core_owed = 0;
+	_owedLineCount = 0;
+	spu_watch_main_size = 0;
+	spu_watch_wram = false;
+
 	SPU_struct *spu = SPU_core;
 	reconstruct(&SPU_core->regs);
 
@@ -98,7 +98,8 @@ struct channel_struct
 						loop_pcm16b(0),
 						index(0),
 						loop_index(0),
-						x(0)
+						x(0),
+						srcptr(NULL)
 	{}
 	u32 num;
    u8 vol;
@@ -128,6 +129,8 @@ struct channel_struct
    int loop_index;
    // PSG noise
    u16 x;
+   // sample data as a host pointer, or NULL to fetch through the MMU. refreshed by every mix
+   u8 *srcptr;
 };
 
 class SPUFifo
@@ -237,8 +240,17 @@ void SPU_ClearOutputBuffer(void);
 void SPU_Reset(void);
 void SPU_DeInit(void);
 void SPU_KeyOn(int channel);
+
+//the core spu only mixes when something could notice; see SPU_Emulate_core().
+//SPU_CatchUp() has to run before anything that reads its output or changes its inputs,
+//and writes to memory that a playing channel reads from go through the watch checks in MMU.h.
+extern u32 spu_core_owed;
+void SPU_MixOwed();
+static FORCEINLINE void SPU_CatchUp() { if (spu_core_owed) SPU_MixOwed(); }
+
 static FORCEINLINE void SPU_WriteByte(u32 addr, u8 val)
 {
+	SPU_CatchUp();
 	addr &= 0xFFF;
 
 	SPU_core->WriteByte(addr,val);
@@ -247,6 +259,7 @@ static FORCEINLINE void SPU_WriteByte(u32 addr, u8 val)
 }
 static FORCEINLINE void SPU_WriteWord(u32 addr, u16 val)
 {
+	SPU_CatchUp();
 	addr &= 0xFFF;
 
 	SPU_core->WriteWord(addr,val);
@@ -255,15 +268,16 @@ static FORCEINLINE void SPU_WriteWord(u32 addr, u16 val)
 }
 static FORCEINLINE void SPU_WriteLong(u32 addr, u32 val)
 {
+	SPU_CatchUp();
 	addr &= 0xFFF;
 
 	SPU_core->WriteLong(addr,val);
 	if(SPU_user) 
 		SPU_user->WriteLong(addr,val);
 }
-static FORCEINLINE u8 SPU_ReadByte(u32 addr) { return SPU_core->ReadByte(addr & 0x0FFF); }
-static FORCEINLINE u16 SPU_ReadWord(u32 addr) { return SPU_core->ReadWord(addr & 0x0FFF); }
-static FORCEINLINE u32 SPU_ReadLong(u32 addr) { return SPU_core->ReadLong(addr & 0x0FFF); }
+static FORCEINLINE u8 SPU_ReadByte(u32 addr) { SPU_CatchUp(); return SPU_core->ReadByte(addr & 0x0FFF); }
+static FORCEINLINE u16 SPU_ReadWord(u32 addr) { SPU_CatchUp(); return SPU_core->ReadWord(addr & 0x0FFF); }
+static FORCEINLINE u32 SPU_ReadLong(u32 addr) { SPU_CatchUp(); return SPU_core->ReadLong(addr & 0x0FFF); }
 void SPU_Emulate_core(void);
 void SPU_Emulate_user(bool mix = true);
 void SPU_DefaultFetchSamples(s16 *sampleBuffer, size_t sampleCount, ESynchMode synchMode, ISynchronizingAudioBuffer *theSynchronizer);
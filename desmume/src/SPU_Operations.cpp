@@ -0,0 +1,120 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SPU_Operations.h"
+
+// The scalar versions of the kernels below are the reference: every vector
+// implementation must produce exactly the same sndbuf contents. They are also
+// used by the vector implementations to finish off any leftover samples.
+
+template<SPUInterpolationMode INTERPOLATE_MODE>
+static FORCEINLINE s32 SPU_InterpolateSample(const SPUMixBlock &block, const size_t i)
+{
+	switch (INTERPOLATE_MODE)
+	{
+		case SPUInterpolation_CatmullRom:
+			return (-block.tap[0][i]*block.weight[0][i] + block.tap[1][i]*block.weight[1][i] + block.tap[2][i]*block.weight[2][i] - block.tap[3][i]*block.weight[3][i]) >> 15;
+
+		case SPUInterpolation_Cosine:
+		case SPUInterpolation_Linear:
+			return block.tap[0][i] + ((block.tap[1][i] - block.tap[0][i])*block.weight[0][i] >> 16);
+
+		default:
+			return block.data[i];
+	}
+}
+
+template<int CHANNELS>
+static FORCEINLINE void SPU_MixSample(s32 *__restrict sndbuf, const s32 data, const u8 vol, const u8 volShift, const u8 pan)
+{
+	const s32 scaled = spumuldiv7(data, vol) >> volShift;
+
+	switch (CHANNELS)
+	{
+		case 0:
+			sndbuf[0] += scaled;
+			break;
+
+		case 1:
+			sndbuf[0] += spumuldiv7(scaled, 127 - pan);
+			sndbuf[1] += spumuldiv7(scaled, pan);
+			break;
+
+		case 2:
+			sndbuf[1] += scaled;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static FORCEINLINE void SPU_MasterVolumeSample(s32 *__restrict sndbuf, s16 *__restrict outbuf, const u8 vol)
+{
+	*sndbuf = spumuldiv7(*sndbuf, vol);
+	*outbuf = (s16)std::min<s32>(std::max<s32>(*sndbuf, -0x8000), 0x7FFF);
+}
+
+#if defined(ENABLE_AVX2)
+	#include "SPU_Operations_AVX2.cpp"
+#elif defined(ENABLE_SSE2)
+	#include "SPU_Operations_SSE2.cpp"
+#elif defined(ENABLE_NEON_A64)
+	#include "SPU_Operations_NEON.cpp"
+#else
+
+template<SPUInterpolationMode INTERPOLATE_MODE>
+void SPU_InterpolateBlock(SPUMixBlock &block, const size_t count)
+{
+	if (INTERPOLATE_MODE == SPUInterpolation_None)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		block.data[i] = SPU_InterpolateSample<INTERPOLATE_MODE>(block, i);
+	}
+}
+
+template<int CHANNELS>
+void SPU_MixBlock(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		SPU_MixSample<CHANNELS>(sndbuf + (i * 2), data[i], vol, volShift, pan);
+	}
+}
+
+void SPU_MasterVolumeBlock(s32 *__restrict sndbuf, s16 *__restrict outbuf, const size_t count, const u8 vol)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		SPU_MasterVolumeSample(sndbuf + i, outbuf + i, vol);
+	}
+}
+
+#endif
+
+template void SPU_InterpolateBlock<SPUInterpolation_None>(SPUMixBlock &block, const size_t count);
+template void SPU_InterpolateBlock<SPUInterpolation_Linear>(SPUMixBlock &block, const size_t count);
+template void SPU_InterpolateBlock<SPUInterpolation_Cosine>(SPUMixBlock &block, const size_t count);
+template void SPU_InterpolateBlock<SPUInterpolation_CatmullRom>(SPUMixBlock &block, const size_t count);
+
+template void SPU_MixBlock<0>(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan);
+template void SPU_MixBlock<1>(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan);
+template void SPU_MixBlock<2>(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan);
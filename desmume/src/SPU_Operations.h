@@ -0,0 +1,59 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPU_OPERATIONS_H
+#define SPU_OPERATIONS_H
+
+#include "types.h"
+#include "SPU.h"
+
+// Number of output samples that a channel gathers before the block kernels run.
+// Must be a multiple of 8 so that every vector width divides it evenly.
+#define SPU_MIXBLOCK_SAMPLES 64
+
+// Runs shorter than this are mixed one sample at a time, since setting up a
+// block costs more than it saves. (The advanced mixer asks for single samples.)
+#define SPU_MIXBLOCK_MINIMUM 8
+
+// One block of a channel's output. The sample fetch loop is inherently serial
+// (ADPCM decoding, looping, PSG noise), so it stays scalar and only records the
+// interpolation taps and weights for each output sample. The interpolation,
+// volume, panning and accumulation into sndbuf are then done in bulk.
+//
+// Everything is stored as 32-bit lanes so that the vector kernels reproduce the
+// scalar s32 arithmetic exactly, including its wraparound.
+struct SPUMixBlock
+{
+	// Taps are in chronological order. Catmull-Rom uses all four, linear and
+	// cosine use the first two, and no interpolation writes straight to data[].
+	CACHE_ALIGN s32 tap[SPUINTERPOLATION_TAPS][SPU_MIXBLOCK_SAMPLES];
+	CACHE_ALIGN s32 weight[SPUINTERPOLATION_TAPS][SPU_MIXBLOCK_SAMPLES];
+	CACHE_ALIGN s32 data[SPU_MIXBLOCK_SAMPLES];
+};
+
+// Computes block.data[] from the taps and weights.
+template<SPUInterpolationMode INTERPOLATE_MODE> void SPU_InterpolateBlock(SPUMixBlock &block, const size_t count);
+
+// Applies the channel volume, divider and panning to data[] and accumulates the
+// result into the interleaved stereo sndbuf. CHANNELS matches SPU_Mix(): 0 is
+// hard left, 1 is panned and 2 is hard right.
+template<int CHANNELS> void SPU_MixBlock(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan);
+
+// Applies the master volume to sndbuf and saturates the result into outbuf.
+void SPU_MasterVolumeBlock(s32 *__restrict sndbuf, s16 *__restrict outbuf, const size_t count, const u8 vol);
+
+#endif // SPU_OPERATIONS_H
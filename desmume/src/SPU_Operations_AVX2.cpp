@@ -0,0 +1,147 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENABLE_AVX2
+	#error This code requires AVX2 support.
+	#warning This error might occur if this file is compiled directly. Do not compile this file directly, as it is already included in SPU_Operations.cpp.
+#else
+
+#include "SPU_Operations_AVX2.h"
+
+
+static const SPUMixOperation_AVX2 spumixop_vec;
+
+FORCEINLINE v256s32 SPUMixOperation_AVX2::mul32(const v256s32 &a, const v256s32 &b) const
+{
+	return _mm256_mullo_epi32(a, b);
+}
+
+FORCEINLINE v256s32 SPUMixOperation_AVX2::muldiv7(const v256s32 &val, const u8 multiplier) const
+{
+	return (multiplier == 127) ? val : _mm256_srai_epi32( this->mul32(val, _mm256_set1_epi32(multiplier)), 7 );
+}
+
+FORCEINLINE v256s32 SPUMixOperation_AVX2::shiftRight(const v256s32 &val, const u8 shift) const
+{
+	return _mm256_sra_epi32( val, _mm_cvtsi32_si128(shift) );
+}
+
+FORCEINLINE void SPUMixOperation_AVX2::accumulateStereo(s32 *__restrict sndbuf, const v256s32 &left, const v256s32 &right) const
+{
+	// The unpacks work within each 128-bit lane, so put the halves back in order afterwards.
+	const v256s32 mixLo = _mm256_unpacklo_epi32(left, right);
+	const v256s32 mixHi = _mm256_unpackhi_epi32(left, right);
+	v256s32 *sndbufVec = (v256s32 *)sndbuf;
+	
+	_mm256_storeu_si256( sndbufVec + 0, _mm256_add_epi32(_mm256_loadu_si256(sndbufVec + 0), _mm256_permute2x128_si256(mixLo, mixHi, 0x20)) );
+	_mm256_storeu_si256( sndbufVec + 1, _mm256_add_epi32(_mm256_loadu_si256(sndbufVec + 1), _mm256_permute2x128_si256(mixLo, mixHi, 0x31)) );
+}
+
+FORCEINLINE void SPUMixOperation_AVX2::saturate(s16 *__restrict outbuf, const v256s32 &val) const
+{
+	const v256s16 packed = _mm256_permute4x64_epi64( _mm256_packs_epi32(val, val), 0x08 );
+	_mm_storeu_si128( (v128s16 *)outbuf, _mm256_castsi256_si128(packed) );
+}
+
+template<SPUInterpolationMode INTERPOLATE_MODE>
+void SPU_InterpolateBlock(SPUMixBlock &block, const size_t count)
+{
+	if (INTERPOLATE_MODE == SPUInterpolation_None)
+	{
+		return;
+	}
+
+	const size_t vecCount = count & ~(size_t)(sizeof(v256s32) / sizeof(s32) - 1);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v256s32) / sizeof(s32)))
+	{
+		const v256s32 a = _mm256_load_si256((v256s32 *)(block.tap[0] + i));
+		const v256s32 b = _mm256_load_si256((v256s32 *)(block.tap[1] + i));
+		v256s32 result;
+
+		if (INTERPOLATE_MODE == SPUInterpolation_CatmullRom)
+		{
+			const v256s32 c = _mm256_load_si256((v256s32 *)(block.tap[2] + i));
+			const v256s32 d = _mm256_load_si256((v256s32 *)(block.tap[3] + i));
+
+			result = _mm256_sub_epi32( spumixop_vec.mul32(b, _mm256_load_si256((v256s32 *)(block.weight[1] + i))),
+			                        spumixop_vec.mul32(a, _mm256_load_si256((v256s32 *)(block.weight[0] + i))) );
+			result = _mm256_add_epi32( result, spumixop_vec.mul32(c, _mm256_load_si256((v256s32 *)(block.weight[2] + i))) );
+			result = _mm256_sub_epi32( result, spumixop_vec.mul32(d, _mm256_load_si256((v256s32 *)(block.weight[3] + i))) );
+			result = _mm256_srai_epi32(result, 15);
+		}
+		else
+		{
+			result = spumixop_vec.mul32( _mm256_sub_epi32(b, a), _mm256_load_si256((v256s32 *)(block.weight[0] + i)) );
+			result = _mm256_add_epi32( a, _mm256_srai_epi32(result, 16) );
+		}
+
+		_mm256_store_si256((v256s32 *)(block.data + i), result);
+	}
+
+	for (; i < count; i++)
+	{
+		block.data[i] = SPU_InterpolateSample<INTERPOLATE_MODE>(block, i);
+	}
+}
+
+template<int CHANNELS>
+void SPU_MixBlock(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan)
+{
+	const size_t vecCount = count & ~(size_t)(sizeof(v256s32) / sizeof(s32) - 1);
+	const v256s32 zeroVec = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v256s32) / sizeof(s32)))
+	{
+		const v256s32 scaled = spumixop_vec.shiftRight( spumixop_vec.muldiv7(_mm256_loadu_si256((v256s32 *)(data + i)), vol), volShift );
+
+		switch (CHANNELS)
+		{
+			case 0: spumixop_vec.accumulateStereo(sndbuf + (i * 2), scaled, zeroVec); break;
+			case 1: spumixop_vec.accumulateStereo(sndbuf + (i * 2), spumixop_vec.muldiv7(scaled, 127 - pan), spumixop_vec.muldiv7(scaled, pan)); break;
+			case 2: spumixop_vec.accumulateStereo(sndbuf + (i * 2), zeroVec, scaled); break;
+			default: break;
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		SPU_MixSample<CHANNELS>(sndbuf + (i * 2), data[i], vol, volShift, pan);
+	}
+}
+
+void SPU_MasterVolumeBlock(s32 *__restrict sndbuf, s16 *__restrict outbuf, const size_t count, const u8 vol)
+{
+	const size_t vecCount = count & ~(size_t)(sizeof(v256s32) / sizeof(s32) - 1);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v256s32) / sizeof(s32)))
+	{
+		const v256s32 result = spumixop_vec.muldiv7( _mm256_loadu_si256((v256s32 *)(sndbuf + i)), vol );
+		_mm256_storeu_si256((v256s32 *)(sndbuf + i), result);
+		spumixop_vec.saturate(outbuf + i, result);
+	}
+
+	for (; i < count; i++)
+	{
+		SPU_MasterVolumeSample(sndbuf + i, outbuf + i, vol);
+	}
+}
+
+#endif // ENABLE_AVX2
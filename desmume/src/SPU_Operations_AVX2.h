@@ -0,0 +1,41 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPU_OPERATIONS_AVX2_H
+#define SPU_OPERATIONS_AVX2_H
+
+#include "SPU_Operations.h"
+
+#ifndef ENABLE_AVX2
+	#warning This header requires AVX2 support.
+#else
+
+class SPUMixOperation_AVX2
+{
+public:
+	SPUMixOperation_AVX2() {};
+	
+	FORCEINLINE v256s32 mul32(const v256s32 &a, const v256s32 &b) const;
+	FORCEINLINE v256s32 muldiv7(const v256s32 &val, const u8 multiplier) const;
+	FORCEINLINE v256s32 shiftRight(const v256s32 &val, const u8 shift) const;
+	FORCEINLINE void accumulateStereo(s32 *__restrict sndbuf, const v256s32 &left, const v256s32 &right) const;
+	FORCEINLINE void saturate(s16 *__restrict outbuf, const v256s32 &val) const;
+};
+
+#endif // ENABLE_AVX2
+
+#endif // SPU_OPERATIONS_AVX2_H
@@ -0,0 +1,141 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENABLE_NEON_A64
+	#error This code requires ARM64 NEON support.
+	#warning This error might occur if this file is compiled directly. Do not compile this file directly, as it is already included in SPU_Operations.cpp.
+#else
+
+#include "SPU_Operations_NEON.h"
+
+
+static const SPUMixOperation_NEON spumixop_vec;
+
+FORCEINLINE v128s32 SPUMixOperation_NEON::mul32(const v128s32 &a, const v128s32 &b) const
+{
+	return vmulq_s32(a, b);
+}
+
+FORCEINLINE v128s32 SPUMixOperation_NEON::muldiv7(const v128s32 &val, const u8 multiplier) const
+{
+	return (multiplier == 127) ? val : vshrq_n_s32( vmulq_n_s32(val, multiplier), 7 );
+}
+
+FORCEINLINE v128s32 SPUMixOperation_NEON::shiftRight(const v128s32 &val, const u8 shift) const
+{
+	return vshlq_s32( val, vdupq_n_s32(-(s32)shift) );
+}
+
+FORCEINLINE void SPUMixOperation_NEON::accumulateStereo(s32 *__restrict sndbuf, const v128s32 &left, const v128s32 &right) const
+{
+	vst1q_s32( sndbuf + 0, vaddq_s32(vld1q_s32(sndbuf + 0), vzip1q_s32(left, right)) );
+	vst1q_s32( sndbuf + 4, vaddq_s32(vld1q_s32(sndbuf + 4), vzip2q_s32(left, right)) );
+}
+
+FORCEINLINE void SPUMixOperation_NEON::saturate(s16 *__restrict outbuf, const v128s32 &val) const
+{
+	vst1_s16( outbuf, vqmovn_s32(val) );
+}
+
+template<SPUInterpolationMode INTERPOLATE_MODE>
+void SPU_InterpolateBlock(SPUMixBlock &block, const size_t count)
+{
+	if (INTERPOLATE_MODE == SPUInterpolation_None)
+	{
+		return;
+	}
+
+	const size_t vecCount = count & ~(size_t)(sizeof(v128s32) / sizeof(s32) - 1);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v128s32) / sizeof(s32)))
+	{
+		const v128s32 a = vld1q_s32(block.tap[0] + i);
+		const v128s32 b = vld1q_s32(block.tap[1] + i);
+		v128s32 result;
+
+		if (INTERPOLATE_MODE == SPUInterpolation_CatmullRom)
+		{
+			const v128s32 c = vld1q_s32(block.tap[2] + i);
+			const v128s32 d = vld1q_s32(block.tap[3] + i);
+
+			result = vsubq_s32( spumixop_vec.mul32(b, vld1q_s32(block.weight[1] + i)),
+			                        spumixop_vec.mul32(a, vld1q_s32(block.weight[0] + i)) );
+			result = vaddq_s32( result, spumixop_vec.mul32(c, vld1q_s32(block.weight[2] + i)) );
+			result = vsubq_s32( result, spumixop_vec.mul32(d, vld1q_s32(block.weight[3] + i)) );
+			result = vshrq_n_s32(result, 15);
+		}
+		else
+		{
+			result = spumixop_vec.mul32( vsubq_s32(b, a), vld1q_s32(block.weight[0] + i) );
+			result = vaddq_s32( a, vshrq_n_s32(result, 16) );
+		}
+
+		vst1q_s32(block.data + i, result);
+	}
+
+	for (; i < count; i++)
+	{
+		block.data[i] = SPU_InterpolateSample<INTERPOLATE_MODE>(block, i);
+	}
+}
+
+template<int CHANNELS>
+void SPU_MixBlock(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan)
+{
+	const size_t vecCount = count & ~(size_t)(sizeof(v128s32) / sizeof(s32) - 1);
+	const v128s32 zeroVec = vdupq_n_s32(0);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v128s32) / sizeof(s32)))
+	{
+		const v128s32 scaled = spumixop_vec.shiftRight( spumixop_vec.muldiv7(vld1q_s32(data + i), vol), volShift );
+
+		switch (CHANNELS)
+		{
+			case 0: spumixop_vec.accumulateStereo(sndbuf + (i * 2), scaled, zeroVec); break;
+			case 1: spumixop_vec.accumulateStereo(sndbuf + (i * 2), spumixop_vec.muldiv7(scaled, 127 - pan), spumixop_vec.muldiv7(scaled, pan)); break;
+			case 2: spumixop_vec.accumulateStereo(sndbuf + (i * 2), zeroVec, scaled); break;
+			default: break;
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		SPU_MixSample<CHANNELS>(sndbuf + (i * 2), data[i], vol, volShift, pan);
+	}
+}
+
+void SPU_MasterVolumeBlock(s32 *__restrict sndbuf, s16 *__restrict outbuf, const size_t count, const u8 vol)
+{
+	const size_t vecCount = count & ~(size_t)(sizeof(v128s32) / sizeof(s32) - 1);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v128s32) / sizeof(s32)))
+	{
+		const v128s32 result = spumixop_vec.muldiv7( vld1q_s32(sndbuf + i), vol );
+		vst1q_s32(sndbuf + i, result);
+		spumixop_vec.saturate(outbuf + i, result);
+	}
+
+	for (; i < count; i++)
+	{
+		SPU_MasterVolumeSample(sndbuf + i, outbuf + i, vol);
+	}
+}
+
+#endif // ENABLE_NEON_A64
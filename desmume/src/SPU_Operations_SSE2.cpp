@@ -0,0 +1,151 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENABLE_SSE2
+	#error This code requires SSE2 support.
+	#warning This error might occur if this file is compiled directly. Do not compile this file directly, as it is already included in SPU_Operations.cpp.
+#else
+
+#include "SPU_Operations_SSE2.h"
+
+
+static const SPUMixOperation_SSE2 spumixop_vec;
+
+FORCEINLINE v128s32 SPUMixOperation_SSE2::mul32(const v128s32 &a, const v128s32 &b) const
+{
+#ifdef ENABLE_SSE4_1
+	return _mm_mullo_epi32(a, b);
+#else
+	// SSE2 only multiplies the even lanes into 64-bit products, so do the odd lanes
+	// separately and keep the low halves. The low 32 bits are the same whether the
+	// multiply is signed or unsigned.
+	const v128u32 even = _mm_mul_epu32(a, b);
+	const v128u32 odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32(even, 0x08), _mm_shuffle_epi32(odd, 0x08) );
+#endif
+}
+
+FORCEINLINE v128s32 SPUMixOperation_SSE2::muldiv7(const v128s32 &val, const u8 multiplier) const
+{
+	return (multiplier == 127) ? val : _mm_srai_epi32( this->mul32(val, _mm_set1_epi32(multiplier)), 7 );
+}
+
+FORCEINLINE v128s32 SPUMixOperation_SSE2::shiftRight(const v128s32 &val, const u8 shift) const
+{
+	return _mm_sra_epi32( val, _mm_cvtsi32_si128(shift) );
+}
+
+FORCEINLINE void SPUMixOperation_SSE2::accumulateStereo(s32 *__restrict sndbuf, const v128s32 &left, const v128s32 &right) const
+{
+	v128s32 *sndbufVec = (v128s32 *)sndbuf;
+	_mm_storeu_si128( sndbufVec + 0, _mm_add_epi32(_mm_loadu_si128(sndbufVec + 0), _mm_unpacklo_epi32(left, right)) );
+	_mm_storeu_si128( sndbufVec + 1, _mm_add_epi32(_mm_loadu_si128(sndbufVec + 1), _mm_unpackhi_epi32(left, right)) );
+}
+
+FORCEINLINE void SPUMixOperation_SSE2::saturate(s16 *__restrict outbuf, const v128s32 &val) const
+{
+	_mm_storel_epi64( (v128s16 *)outbuf, _mm_packs_epi32(val, val) );
+}
+
+template<SPUInterpolationMode INTERPOLATE_MODE>
+void SPU_InterpolateBlock(SPUMixBlock &block, const size_t count)
+{
+	if (INTERPOLATE_MODE == SPUInterpolation_None)
+	{
+		return;
+	}
+
+	const size_t vecCount = count & ~(size_t)(sizeof(v128s32) / sizeof(s32) - 1);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v128s32) / sizeof(s32)))
+	{
+		const v128s32 a = _mm_load_si128((v128s32 *)(block.tap[0] + i));
+		const v128s32 b = _mm_load_si128((v128s32 *)(block.tap[1] + i));
+		v128s32 result;
+
+		if (INTERPOLATE_MODE == SPUInterpolation_CatmullRom)
+		{
+			const v128s32 c = _mm_load_si128((v128s32 *)(block.tap[2] + i));
+			const v128s32 d = _mm_load_si128((v128s32 *)(block.tap[3] + i));
+
+			result = _mm_sub_epi32( spumixop_vec.mul32(b, _mm_load_si128((v128s32 *)(block.weight[1] + i))),
+			                        spumixop_vec.mul32(a, _mm_load_si128((v128s32 *)(block.weight[0] + i))) );
+			result = _mm_add_epi32( result, spumixop_vec.mul32(c, _mm_load_si128((v128s32 *)(block.weight[2] + i))) );
+			result = _mm_sub_epi32( result, spumixop_vec.mul32(d, _mm_load_si128((v128s32 *)(block.weight[3] + i))) );
+			result = _mm_srai_epi32(result, 15);
+		}
+		else
+		{
+			result = spumixop_vec.mul32( _mm_sub_epi32(b, a), _mm_load_si128((v128s32 *)(block.weight[0] + i)) );
+			result = _mm_add_epi32( a, _mm_srai_epi32(result, 16) );
+		}
+
+		_mm_store_si128((v128s32 *)(block.data + i), result);
+	}
+
+	for (; i < count; i++)
+	{
+		block.data[i] = SPU_InterpolateSample<INTERPOLATE_MODE>(block, i);
+	}
+}
+
+template<int CHANNELS>
+void SPU_MixBlock(s32 *__restrict sndbuf, const s32 *__restrict data, const size_t count, const u8 vol, const u8 volShift, const u8 pan)
+{
+	const size_t vecCount = count & ~(size_t)(sizeof(v128s32) / sizeof(s32) - 1);
+	const v128s32 zeroVec = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v128s32) / sizeof(s32)))
+	{
+		const v128s32 scaled = spumixop_vec.shiftRight( spumixop_vec.muldiv7(_mm_loadu_si128((v128s32 *)(data + i)), vol), volShift );
+
+		switch (CHANNELS)
+		{
+			case 0: spumixop_vec.accumulateStereo(sndbuf + (i * 2), scaled, zeroVec); break;
+			case 1: spumixop_vec.accumulateStereo(sndbuf + (i * 2), spumixop_vec.muldiv7(scaled, 127 - pan), spumixop_vec.muldiv7(scaled, pan)); break;
+			case 2: spumixop_vec.accumulateStereo(sndbuf + (i * 2), zeroVec, scaled); break;
+			default: break;
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		SPU_MixSample<CHANNELS>(sndbuf + (i * 2), data[i], vol, volShift, pan);
+	}
+}
+
+void SPU_MasterVolumeBlock(s32 *__restrict sndbuf, s16 *__restrict outbuf, const size_t count, const u8 vol)
+{
+	const size_t vecCount = count & ~(size_t)(sizeof(v128s32) / sizeof(s32) - 1);
+	size_t i = 0;
+
+	for (; i < vecCount; i += (sizeof(v128s32) / sizeof(s32)))
+	{
+		const v128s32 result = spumixop_vec.muldiv7( _mm_loadu_si128((v128s32 *)(sndbuf + i)), vol );
+		_mm_storeu_si128((v128s32 *)(sndbuf + i), result);
+		spumixop_vec.saturate(outbuf + i, result);
+	}
+
+	for (; i < count; i++)
+	{
+		SPU_MasterVolumeSample(sndbuf + i, outbuf + i, vol);
+	}
+}
+
+#endif // ENABLE_SSE2
@@ -25,6 +25,24 @@ void Slot1Comp_Rom::start(eSlot1Operation operation, u32 addr)
 {
 	this->_operation = operation;
 	this->_address = addr;
+	this->_blockValid = false;
+}
+
+u32 Slot1Comp_Rom::_readROM(u32 addr)
+{
+	//unaligned reads could straddle two blocks, so leave those to the rom provider
+	if (addr & 3)
+		return gameInfo.readROM(addr);
+
+	const u32 blockAddress = addr & ~(sizeof(this->_block) - 1);
+	if (!this->_blockValid || (blockAddress != this->_blockAddress))
+	{
+		gameInfo.readROMBlock(blockAddress, this->_block, sizeof(this->_block));
+		this->_blockAddress = blockAddress;
+		this->_blockValid = true;
+	}
+
+	return LE_TO_LOCAL_32(*(u32*)(this->_block + (addr - blockAddress)));
 }
 
 u32 Slot1Comp_Rom::read()
@@ -33,7 +51,7 @@ u32 Slot1Comp_Rom::read()
 	{
 	case eSlot1Operation_00_ReadHeader_Unencrypted:
 		{
-			u32 ret = gameInfo.readROM(this->_address);
+			u32 ret = this->_readROM(this->_address);
 			this->_address = (this->_address + 4) & 0xFFF;
 			return ret;
 		}
@@ -79,7 +97,7 @@ u32 Slot1Comp_Rom::read()
 			}
 
 			//actually read from the ROM provider
-			u32 ret = gameInfo.readROM(this->_address);
+			u32 ret = this->_readROM(this->_address);
 
 			//"However, the datastream wraps to the begin of the current 4K block when address+length crosses a 4K boundary (1000h bytes)"
 			this->_address = (this->_address&~0xFFF) + ((this->_address+4)&0xFFF);
@@ -120,4 +138,5 @@ void Slot1Comp_Rom::loadstate(EMUFILE &is)
 	s32 version = is.read_s32LE();
 	this->_operation = (eSlot1Operation)is.read_s32LE();
 	this->_address = is.read_u32LE();
+	this->_blockValid = false;
 }
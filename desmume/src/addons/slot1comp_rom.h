@@ -29,6 +29,8 @@ class EMUFILE;
 class Slot1Comp_Rom
 {
 public:
+	Slot1Comp_Rom() : _address(0), _operation(eSlot1Operation_Unknown), _blockAddress(0), _blockValid(false) {}
+
 	void start(eSlot1Operation operation, u32 addr);
 	u32 read();
 	u32 getAddress();
@@ -38,8 +40,16 @@ public:
 	void loadstate(EMUFILE &is);
 
 private:
+	u32 _readROM(u32 addr);
+
 	u32 _address;
 	eSlot1Operation _operation;
+
+	//the card is read out a 0x200 byte transfer at a time, so fetch that much from the rom provider at once.
+	//this is only a cache and is thrown away whenever a new command starts
+	u8 _block[0x200];
+	u32 _blockAddress;
+	bool _blockValid;
 };
 
 #endif
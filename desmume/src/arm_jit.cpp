@@ -40,6 +40,9 @@
 #endif
 #endif
 
+#include <vector>
+#include <algorithm>
+
 #include "utils/bits.h"
 #include "utils/AsmJit/AsmJit.h"
 #include "armcpu.h"
@@ -88,6 +91,9 @@ using namespace AsmJit;
 
 u32 saveBlockSizeJIT = 0;
 
+JIT_LINK_struct JIT_LINK = {0, 0, 0, 0};
+static ArmOpCompiled link_enter = NULL;
+
 #ifdef MAPPED_JIT_FUNCS
 CACHE_ALIGN JIT_struct JIT;
 
@@ -200,6 +206,45 @@ DS_ALIGN(4096) uintptr_t compiled_funcs[1<<26] = {0};
 
 static u8 recompile_counts[(1<<26)/16];
 
+// Compiled code is owned by the 16KB guest page its block starts in, so that a page can be thrown
+// away on its own. Blocks that are recompiled after being invalidated leave their old code behind as
+// dead weight in the page; once enough of a page is dead, the whole page is dropped and its blocks are
+// recompiled on demand. When the code cache is full, the least recently dispatched page is evicted.
+#define JIT_PAGE_SHIFT 14
+#define JIT_PAGE_INDEX(adr) (((adr) & 0x0FFFFFFF) >> JIT_PAGE_SHIFT)
+// a page is dropped once this much of its code is dead and the dead code outweighs the live code
+#define JIT_PAGE_MIN_DEAD 0x2000
+
+struct JIT_CODE_BLOCK
+{
+	u32 adr;
+	u32 size;
+	void *code;
+};
+
+struct JIT_CODE_PAGE
+{
+	std::vector<JIT_CODE_BLOCK> blocks;
+	std::vector<JIT_CODE_BLOCK> deadBlocks; // replaced by a recompile, but linked blocks may still jump into them
+	u32 size;
+	u32 deadSize;
+	bool resident;
+#ifdef HAVE_STATIC_CODE_BUFFER
+	std::vector<u32> chunks; // the last one is the one being filled
+	u32 chunkUsed;
+#endif
+};
+
+u32 JIT_PAGE_USE[2][0x4000];
+u32 jit_use_clock = 0;
+static JIT_CODE_PAGE *jit_code_page[2][0x4000];
+static std::vector<u32> jit_resident_pages; // (PROCNUM << 14) | page
+static u32 jit_code_bytes = 0;
+static u32 jit_code_limit = 0;
+static JIT_CODE_PAGE *jit_cur_page = NULL;
+static u32 jit_cur_key = 0;
+static u32 jit_cur_adr = 0;
+
 #ifdef HAVE_STATIC_CODE_BUFFER
 // On x86_64, allocate jitted code from a static buffer to ensure that it's within 2GB of .text
 // Allows call instructions to use pcrel offsets, as opposed to slower indirect calls.
@@ -207,13 +252,206 @@ static u8 recompile_counts[(1<<26)/16];
 // FIXME win64 needs this too, x86_32 doesn't
 
 DS_ALIGN(4096) static u8 scratchpad[1<<25];
-static u8 *scratchptr;
 
-struct ASMJIT_API StaticCodeGenerator : public Context
+// the scratchpad is handed out to guest pages in chunks; blocks bigger than a chunk get a contiguous run
+#define JIT_CHUNK_SHIFT 14
+#define JIT_CHUNK_SIZE (1 << JIT_CHUNK_SHIFT)
+#define JIT_CHUNK_COUNT (sizeof(scratchpad) >> JIT_CHUNK_SHIFT)
+static u8 chunk_used[JIT_CHUNK_COUNT];
+static u32 chunk_limit = JIT_CHUNK_COUNT;
+#endif
+
+static void jit_page_release(u32 key)
+{
+	JIT_CODE_PAGE *page = jit_code_page[key >> 14][key & 0x3FFF];
+
+#ifdef HAVE_STATIC_CODE_BUFFER
+	for (size_t i = 0; i < page->chunks.size(); i++)
+		chunk_used[page->chunks[i]] = 0;
+	jit_code_bytes -= (u32)page->chunks.size() << JIT_CHUNK_SHIFT;
+	page->chunks.clear();
+	page->chunkUsed = 0;
+#else
+	for (size_t i = 0; i < page->blocks.size(); i++)
+		MemoryManager::getGlobal()->free(page->blocks[i].code);
+	for (size_t i = 0; i < page->deadBlocks.size(); i++)
+		MemoryManager::getGlobal()->free(page->deadBlocks[i].code);
+	jit_code_bytes -= page->size;
+#endif
+	page->blocks.clear();
+	page->deadBlocks.clear();
+	page->size = 0;
+	page->deadSize = 0;
+	page->resident = false;
+
+	for (size_t i = 0; i < jit_resident_pages.size(); i++)
+	{
+		if (jit_resident_pages[i] == key)
+		{
+			jit_resident_pages[i] = jit_resident_pages.back();
+			jit_resident_pages.pop_back();
+			break;
+		}
+	}
+}
+
+// drops all compiled code of a guest page. this also forgets how often the page was recompiled, so
+// code that got pinned to the interpreter (e.g. an overlay that was loaded over and over) gets
+// another chance to be compiled.
+static void jit_page_free(u32 key)
+{
+	const u32 adr = (key & 0x3FFF) << JIT_PAGE_SHIFT;
+
+	if ((key >> 14) == 0)
+		memset(&JIT_COMPILED_FUNC(adr, 0), 0, sizeof(uintptr_t) << (JIT_PAGE_SHIFT-1));
+	else
+		memset(&JIT_COMPILED_FUNC(adr, 1), 0, sizeof(uintptr_t) << (JIT_PAGE_SHIFT-1));
+	memset(&recompile_counts[(adr & 0x07FFFFFE) >> 5], 0, 1 << (JIT_PAGE_SHIFT-5));
+
+	jit_page_release(key);
+}
+
+static bool jit_evict_lru()
+{
+	int victim = -1;
+	u32 victimUse = 0;
+	for (size_t i = 0; i < jit_resident_pages.size(); i++)
+	{
+		const u32 key = jit_resident_pages[i];
+		const u32 use = JIT_PAGE_USE[key >> 14][key & 0x3FFF];
+		if (key == jit_cur_key)
+			continue;
+		if (victim < 0 || use < victimUse)
+		{
+			victim = (int)i;
+			victimUse = use;
+		}
+	}
+	if (victim < 0)
+		return false;
+
+	jit_page_free(jit_resident_pages[victim]);
+	return true;
+}
+
+// picks the page that the block about to be compiled belongs to
+template<int PROCNUM> static void jit_page_begin(u32 adr)
+{
+	const u32 index = JIT_PAGE_INDEX(adr);
+	JIT_CODE_PAGE *page = jit_code_page[PROCNUM][index];
+	if (page == NULL)
+	{
+		page = new JIT_CODE_PAGE();
+		page->size = page->deadSize = 0;
+		page->resident = false;
+#ifdef HAVE_STATIC_CODE_BUFFER
+		page->chunkUsed = 0;
+#endif
+		jit_code_page[PROCNUM][index] = page;
+	}
+
+	jit_cur_page = page;
+	jit_cur_key = (PROCNUM << 14) | index;
+	jit_cur_adr = adr;
+	JIT_PAGE_USE[PROCNUM][index] = ++jit_use_clock;
+
+	// we only get here when the block has no code, so whatever the page still holds for it is dead.
+	// it stays allocated until the whole page goes.
+	for (size_t i = 0; i < page->blocks.size(); i++)
+	{
+		if (page->blocks[i].adr == adr)
+		{
+			page->deadSize += page->blocks[i].size;
+			page->deadBlocks.push_back(page->blocks[i]);
+			page->blocks[i] = page->blocks.back();
+			page->blocks.pop_back();
+			break;
+		}
+	}
+	if (page->deadSize >= JIT_PAGE_MIN_DEAD && page->deadSize > page->size - page->deadSize)
+		jit_page_free(jit_cur_key);
+}
+
+static void* jit_code_alloc(u32 size)
+{
+	JIT_CODE_PAGE *page = jit_cur_page;
+
+#ifdef HAVE_STATIC_CODE_BUFFER
+	if (!page->chunks.empty() && page->chunkUsed + size <= JIT_CHUNK_SIZE)
+		return scratchpad + (page->chunks.back() << JIT_CHUNK_SHIFT) + page->chunkUsed;
+
+	const u32 count = (size + JIT_CHUNK_SIZE - 1) >> JIT_CHUNK_SHIFT;
+	for (;;)
+	{
+		u32 run = 0;
+		for (u32 i = 0; i < chunk_limit; i++)
+		{
+			run = chunk_used[i] ? 0 : run+1;
+			if (run == count)
+			{
+				const u32 first = i + 1 - count;
+				for (u32 j = first; j <= i; j++)
+				{
+					chunk_used[j] = 1;
+					page->chunks.push_back(j);
+				}
+				jit_code_bytes += count << JIT_CHUNK_SHIFT;
+				return scratchpad + (first << JIT_CHUNK_SHIFT);
+			}
+		}
+		if (!jit_evict_lru())
+			return NULL;
+	}
+#else
+	while (jit_code_bytes + size > jit_code_limit)
+	{
+		if (!jit_evict_lru())
+			break;
+	}
+	return MemoryManager::getGlobal()->alloc(size);
+#endif
+}
+
+static void jit_code_commit(void *code, u32 size)
+{
+	JIT_CODE_PAGE *page = jit_cur_page;
+
+#ifdef HAVE_STATIC_CODE_BUFFER
+	// a block that took a run of chunks only leaves the tail of the run's last chunk to fill
+	const u8 *fill = scratchpad + (page->chunks.back() << JIT_CHUNK_SHIFT);
+	page->chunkUsed = ((u8*)code + size > fill) ? (u32)((u8*)code + size - fill) : 0;
+#else
+	MemoryManager::getGlobal()->shrink(code, size);
+	jit_code_bytes += size;
+#endif
+
+	JIT_CODE_BLOCK block = { jit_cur_adr, size, code };
+	page->blocks.push_back(block);
+	page->size += size;
+	if (!page->resident)
+	{
+		page->resident = true;
+		jit_resident_pages.push_back(jit_cur_key);
+	}
+}
+
+static void jit_code_free_all()
 {
-	StaticCodeGenerator()
+	while (!jit_resident_pages.empty())
+		jit_page_release(jit_resident_pages.back());
+
+	jit_code_limit = std::max<u32>(CommonSettings.jit_cache_size, 1) << 20;
+#ifdef HAVE_STATIC_CODE_BUFFER
+	memset(chunk_used, 0, sizeof(chunk_used));
+	chunk_limit = std::min<u32>(jit_code_limit >> JIT_CHUNK_SHIFT, JIT_CHUNK_COUNT);
+#endif
+}
+
+struct ASMJIT_API CodeCacheGenerator : public Context
+{
+	CodeCacheGenerator()
 	{
-		scratchptr = scratchpad;
+#ifdef HAVE_STATIC_CODE_BUFFER
 		int align = (uintptr_t)scratchpad & (sysconf(_SC_PAGESIZE) - 1);
 		int err = mprotect(scratchpad-align, sizeof(scratchpad)+align, PROT_READ|PROT_WRITE|PROT_EXEC);
 		if(err)
@@ -221,6 +459,7 @@ struct ASMJIT_API StaticCodeGenerator : public Context
 			fprintf(stderr, "mprotect failed: %s\n", strerror(errno));
 			abort();
 		}
+#endif
 	}
 
 	uint32_t generate(void** dest, Assembler* assembler)
@@ -231,7 +470,8 @@ struct ASMJIT_API StaticCodeGenerator : public Context
 			*dest = NULL;
 			return kErrorNoFunction;
 		}
-		if(size > (uintptr_t)(scratchpad+sizeof(scratchpad)-scratchptr))
+		void *p = jit_code_alloc(size);
+		if(p == NULL)
 		{
 			fprintf(stderr, "Out of memory for asmjit. Clearing code cache.\n");
 			arm_jit_reset(1);
@@ -239,19 +479,15 @@ struct ASMJIT_API StaticCodeGenerator : public Context
 			*dest = NULL;
 			return kErrorOk;
 		}
-		void *p = scratchptr;
 		size = assembler->relocCode(p);
-		scratchptr += size;
+		jit_code_commit(p, size);
 		*dest = p;
 		return kErrorOk;
 	}
 };
 
-static StaticCodeGenerator codegen;
+static CodeCacheGenerator codegen;
 static X86Compiler c(&codegen);
-#else
-static X86Compiler c;
-#endif
 
 static void emit_branch(int cond, Label to);
 static void _armlog(u8 proc, u32 addr, u32 opcode);
@@ -2212,6 +2448,14 @@ static u32 DESMUME_FASTCALL OP_LDM_STM(u32 adr, u64 regs, int n)
 		// the memory region spans a page boundary, so we can't factor the address translation out of the loop
 		return OP_LDM_STM_generic<PROCNUM, store, dir>(adr, regs, n);
 	}
+#ifdef HAVE_LUA
+	// the direct paths below bypass the memory accessors, which are what report to the Lua hooks
+	else if(IsLuaMemHookPage(adr, store ? LUAMEMHOOK_WRITE : LUAMEMHOOK_READ) ||
+	        IsLuaMemHookPage(adr + (dir>0 ? (n-1)*4 : -(n-1)*4), store ? LUAMEMHOOK_WRITE : LUAMEMHOOK_READ))
+	{
+		return OP_LDM_STM_generic<PROCNUM, store, dir>(adr, regs, n);
+	}
+#endif
 	else if(PROCNUM==ARMCPU_ARM9 && (adr & ~0x3FFF) == MMU.DTCMRegion)
 	{
 		// don't special-case DTCM cycles, even though that would be both faster and more accurate,
@@ -2225,6 +2469,8 @@ static u32 DESMUME_FASTCALL OP_LDM_STM(u32 adr, u64 regs, int n)
 	{
 		ptr = MMU.MAIN_MEM + (adr & _MMU_MAIN_MEM_MASK32);
 		cycles = n * ((PROCNUM==ARMCPU_ARM9) ? 4 : 2);
+		if(store)
+			SPU_WatchMainWriteRange((adr & _MMU_MAIN_MEM_MASK32) - (dir>0 ? 0 : (n-1)*4), n*4);
 	}
 	else if(PROCNUM==ARMCPU_ARM7 && !store && (adr & 0xFF800000) == 0x03800000)
 	{
@@ -4054,6 +4300,204 @@ static void emit_armop_call(u32 opcode)
 	ctx->setReturn(bb_cycles);
 }
 
+#ifdef HAVE_LUA
+template<int SIZE>
+static void DESMUME_FASTCALL lua_exec_hook(u32 adr, u32 opcode)
+{
+	CallRegisteredLuaMemHook(adr, SIZE, opcode, LUAMEMHOOK_EXEC);
+}
+#endif
+
+// The interpreter reports every instruction it executes to the Lua exec hooks. A compiled block
+// only does so on the pages that have exec hooks when it is compiled; the hook code invalidates
+// the pages whose hooks change.
+static void emit_lua_exec_hook(u32 opcode)
+{
+#ifdef HAVE_LUA
+	if(!IsLuaMemHookPage(bb_adr, LUAMEMHOOK_EXEC))
+		return;
+
+	JIT_COMMENT("lua exec hook");
+	GpVar adr = c.newGpVar(kX86VarTypeGpd);
+	GpVar op = c.newGpVar(kX86VarTypeGpd);
+	c.mov(adr, bb_adr);
+	c.mov(op, opcode);
+	X86CompilerFuncCall *ctx = c.call(bb_thumb ? (void*)lua_exec_hook<2> : (void*)lua_exec_hook<4>);
+	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<void, u32, u32>());
+	ctx->setArgument(0, adr);
+	ctx->setArgument(1, op);
+#endif
+}
+
+// Finds the addresses that can follow a block ending with opcode without the block having to look
+// them up at runtime: the target of an immediate branch, and the next instruction if the last one
+// is conditional or isn't a branch at all. Branches that switch between ARM and THUMB aren't linked.
+static int instr_link_targets(u32 opcode, u32 prev_opcode, bool has_prev, u32 *targets)
+{
+	int count = 0;
+	bool conditional = instr_is_conditional(opcode);
+
+	if(bb_thumb)
+	{
+		if((opcode & 0xF000) == 0xD000 && (opcode & 0x0F00) < 0x0E00)
+		{
+			targets[count++] = bb_adr + 4 + ((u32)(s32)(s8)(opcode & 0xFF) << 1);
+			conditional = true;
+		}
+		else if((opcode & 0xF800) == 0xE000)
+			targets[count++] = bb_adr + 4 + ((u32)((s32)(opcode << 21) >> 20));
+		else if((opcode & 0xF800) == 0xF800 && has_prev && (prev_opcode & 0xF800) == 0xF000)
+			targets[count++] = bb_adr + 2 + ((u32)((s32)(prev_opcode << 21) >> 9)) + ((opcode & 0x7FF) << 1);
+	}
+	else
+	{
+		if((opcode & 0x0E000000) == 0x0A000000 && CONDITION(opcode) != 0xF)
+			targets[count++] = bb_adr + 8 + ((u32)((s32)(opcode << 8) >> 6));
+	}
+
+	if(!instr_is_branch(opcode) || conditional)
+		targets[count++] = bb_next_instruction;
+
+	// don't link to memory that the JIT doesn't cover
+	int mapped = 0;
+	for(int i = 0; i < count; i++)
+	{
+		if(JIT_MAPPED(targets[i] & 0x0FFFFFFF, PROCNUM))
+			targets[mapped++] = targets[i];
+	}
+	return mapped;
+}
+
+// Emits the end of a block that jumps straight into one of its successors, if it is compiled and the
+// CPU loop would have dispatched it next anyway, before returning to the CPU loop otherwise.
+static void emit_block_link(const u32 *targets, int count)
+{
+	JIT_COMMENT("block link");
+	Label unlinked = c.newLabel();
+	Label linked = c.newLabel();
+	GpVar link = c.newGpVar(kX86VarTypeGpz);
+	GpVar x = c.newGpVar(kX86VarTypeGpz);
+	GpVar f = c.newGpVar(kX86VarTypeGpz);
+
+	// the chain has to stop whenever the CPU loop would do anything but dispatch this CPU again
+	c.mov(link, (uintptr_t)&JIT_LINK);
+	c.cmp(dword_ptr(link, offsetof(JIT_LINK_struct, budget)), bb_total_cycles.r32());
+	c.jle(unlinked);
+	c.cmp(cpu_ptr(freeze), 0);
+	c.jnz(unlinked);
+	c.mov(x, (uintptr_t)&nds.freezeBus);
+	c.cmp(dword_ptr(x), 0);
+	c.jnz(unlinked);
+	c.mov(x, (uintptr_t)&execute);
+	c.cmp(byte_ptr(x), 0);
+	c.jz(unlinked);
+
+	c.mov(x.r32(), cpu_ptr(instruct_adr));
+	for(int i = 0; i < count; i++)
+	{
+		JIT_COMMENT("link to %08Xh", targets[i]);
+		c.mov(f, (uintptr_t)&JIT_COMPILED_FUNC(targets[i], PROCNUM));
+		c.cmp(x.r32(), targets[i]);
+		c.je(linked);
+	}
+	c.jmp(unlinked);
+
+	c.bind(linked);
+	c.mov(f, sysint_ptr(f));
+	c.test(f, f);
+	c.jz(unlinked);
+
+	// the CPU loop never sees the successor, so stamp its page here for the LRU
+	GpVar page = c.newGpVar(kX86VarTypeGpz);
+	GpVar use = c.newGpVar(kX86VarTypeGpd);
+	c.and_(x.r32(), 0x0FFFFFFF);
+	c.shr(x.r32(), 14);
+	c.mov(page, (uintptr_t)&jit_use_clock);
+	c.mov(use, dword_ptr(page));
+	c.mov(page, (uintptr_t)&JIT_PAGE_USE[PROCNUM][0]);
+	c.mov(dword_ptr(page, x, 2), use);
+	c.unuse(use);
+	c.unuse(page);
+
+	c.sub(dword_ptr(link, offsetof(JIT_LINK_struct, budget)), bb_total_cycles.r32());
+	c.add(dword_ptr(link, offsetof(JIT_LINK_struct, cycles)), bb_total_cycles.r32());
+
+	// the CPU loop keeps nds_timer at the time of the CPU that it dispatches next, which is this one.
+	// ARM7 cycles count twice.
+	c.mov(x, (uintptr_t)&nds_timer);
+	for(int i = 0; i <= PROCNUM; i++)
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		c.add(qword_ptr(x), bb_total_cycles);
+#else
+		c.add(dword_ptr(x), bb_total_cycles);
+		c.adc(dword_ptr(x, 4), 0);
+#endif
+	}
+
+	// drop this block's frame and enter the successor as if link_enter had called it
+	static const u8 jmp_eax[] = {0xFF, 0xE0};
+	c.mov(x, sysint_ptr(link, offsetof(JIT_LINK_struct, sp)));
+	c.alloc(f, kX86RegIndexEax);
+	c.alloc(x, kX86RegIndexEcx);
+	c.emit(kX86InstMov, zsp, x);
+	c.embed(jmp_eax, sizeof(jmp_eax));
+	c.unuse(f);
+	c.unuse(x);
+	c.unuse(link);
+
+	c.bind(unlinked);
+}
+
+// Builds the function that runs a chain of linked blocks. It saves every callee-saved register
+// itself, since a block that is left through a link never gets to restore the ones it used.
+static ArmOpCompiled build_link_enter()
+{
+	static const GpReg saved[] = {
+		zbx, zbp, zsi, zdi,
+#if defined(_M_X64) || defined(__x86_64__)
+		r12, r13, r14, r15,
+#endif
+	};
+	const int count = sizeof(saved) / sizeof(saved[0]);
+
+	// keep the stack aligned to 16 bytes at the call, and leave room for the win64 shadow space
+	int adjust = 16 - (((count + 1) * (int)sizeof(void *)) & 15);
+#if defined(_WIN64)
+	adjust += 32;
+#endif
+
+	X86Assembler a;
+	for(int i = 0; i < count; i++)
+		a.push(saved[i]);
+	a.sub(zsp, adjust);
+	a.mov(zcx, (sysint_t)&JIT_LINK);
+	a.lea(zax, ptr(zsp, -(sysint_t)sizeof(void *)));
+	a.mov(sysint_ptr(zcx, offsetof(JIT_LINK_struct, sp)), zax);
+	a.call(sysint_ptr(zcx, offsetof(JIT_LINK_struct, entry)));
+	a.add(zsp, adjust);
+	for(int i = count - 1; i >= 0; i--)
+		a.pop(saved[i]);
+	a.ret();
+
+	return (ArmOpCompiled)a.make();
+}
+
+u32 arm_jit_run_linked(ArmOpCompiled f, s32 linkBudget)
+{
+	if(link_enter == NULL)
+		return f();
+
+	JIT_LINK.entry = (uintptr_t)f;
+	JIT_LINK.budget = linkBudget;
+	JIT_LINK.cycles = 0;
+	const u32 cycles = link_enter();
+	// blocks called directly must never take a link
+	JIT_LINK.budget = 0;
+
+	return cycles + JIT_LINK.cycles;
+}
+
 static void _armlog(u8 proc, u32 addr, u32 opcode)
 {
 #if 0
@@ -4085,6 +4529,7 @@ static u32 compile_basicblock()
 	u32 interpreted_cycles = 0;
 	u32 start_adr = cpu->instruct_adr;
 	u32 opcode = 0;
+	u32 prev_opcode = 0;
 	
 	bb_thumb = cpu->CPSR.bits.T;
 	bb_opcodesize = bb_thumb ? 2 : 4;
@@ -4096,6 +4541,8 @@ static u32 compile_basicblock()
 		return 1;
 	}
 
+	jit_page_begin<PROCNUM>(start_adr);
+
 #if LOG_JIT
 	fprintf(stderr, "adr %08Xh %s%c\n", start_adr, ARMPROC.CPSR.bits.T ? "THUMB":"ARM", PROCNUM?'7':'9');
 #endif
@@ -4123,6 +4570,7 @@ static u32 compile_basicblock()
 	for(u32 i=0, bEndBlock = 0; bEndBlock == 0; i++)
 	{
 		bb_adr = start_adr + (i * bb_opcodesize);
+		prev_opcode = opcode;
 		if(bb_thumb)
 			opcode = _MMU_read16<PROCNUM, MMU_AT_CODE>(bb_adr);
 		else
@@ -4167,6 +4615,7 @@ static u32 compile_basicblock()
 			Label skip = c.newLabel();
 			emit_branch(CONDITION(opcode), skip);
 			if(!bEndBlock) sync_r15(opcode, 0, 0);
+			emit_lua_exec_hook(opcode);
 			emit_armop_call(opcode);
 			
 			if(cycles == 0)
@@ -4185,6 +4634,7 @@ static u32 compile_basicblock()
 		else
 		{
 			sync_r15(opcode, bEndBlock, 0);
+			emit_lua_exec_hook(opcode);
 			emit_armop_call(opcode);
 			if(cycles == 0)
 			{
@@ -4211,6 +4661,11 @@ static u32 compile_basicblock()
 	if (bb_constant_cycles > 0)
 		c.add(bb_total_cycles, bb_constant_cycles);
 
+	u32 link_targets[2];
+	const int link_count = instr_link_targets(opcode, prev_opcode, (u32)bb_adr != start_adr, link_targets);
+	if (link_count > 0)
+		emit_block_link(link_targets, link_count);
+
 #if (PROFILER_JIT_LEVEL > 1)
 	JIT_COMMENT("*** profiler - cycles");
 	u32 padr = ((start_adr & 0x07FFFFFE) >> 1);
@@ -4246,7 +4701,7 @@ template<int PROCNUM> u32 arm_jit_compile()
 {
 	*PROCNUM_ptr = PROCNUM;
 
-	// prevent endless recompilation of self-modifying code, which would be a memleak since we only free code all at once.
+	// prevent endless recompilation of self-modifying code. the counts are forgotten whenever a page's code is dropped.
 	// also allows us to clear compiled_funcs[] while leaving it sparsely allocated, if the OS does memory overcommit.
 	u32 adr = cpu->instruct_adr;
 	u32 mask_adr = (adr & 0x07FFFFFE) >> 4;
@@ -4264,37 +4719,59 @@ template<int PROCNUM> u32 arm_jit_compile()
 template u32 arm_jit_compile<0>();
 template u32 arm_jit_compile<1>();
 
+// Drops the compiled code that may cover the guest memory in [adr, adr+size), on both CPUs.
+// Blocks are only looked up by their first instruction, so the blocks that start up to one
+// maximum block length in front of the range and run into it have to go as well.
+void arm_jit_invalidate(u32 adr, u32 size)
+{
+	const u32 reach = std::max<u32>(CommonSettings.jit_max_block_size, saveBlockSizeJIT) * 4;
+	const u32 start = ((adr > reach) ? (adr - reach + 2) : 0) & ~1;
+	const u32 end = adr + size;
+
+	for (u32 a = start; a < end; a += 2)
+	{
+		if (JIT_MAPPED(a & 0x0FFFFFFF, 0))
+			JIT_COMPILED_FUNC(a, 0) = 0;
+		if (JIT_MAPPED(a & 0x0FFFFFFF, 1))
+			JIT_COMPILED_FUNC(a, 1) = 0;
+	}
+}
+
 void arm_jit_reset(bool enable, bool suppress_msg)
 {
 #if LOG_JIT
 	c.setLogger(&logger);
 	freopen("desmume_jit.log", "w", stderr);
 #endif
-#ifdef HAVE_STATIC_CODE_BUFFER
-	scratchptr = scratchpad;
-#endif
+	jit_code_free_all();
 	if (!suppress_msg)
 		printf("CPU mode: %s\n", enable?"JIT":"Interpreter");
 	saveBlockSizeJIT = CommonSettings.jit_max_block_size;
 
+	JIT_LINK.budget = 0;
+
 	if (enable)
 	{
 		printf("JIT: max block size %d instruction(s)\n", CommonSettings.jit_max_block_size);
+		printf("JIT: code cache %d MB\n", jit_code_limit >> 20);
+
+		if (link_enter == NULL)
+			link_enter = build_link_enter();
 
 #ifdef MAPPED_JIT_FUNCS
 
-		//these pointers are allocated by asmjit and need freeing
-		#define JITFREE(x)  for(int iii=0;iii<ARRAY_SIZE(x);iii++) if(x[iii]) AsmJit::MemoryManager::getGlobal()->free((void*)x[iii]);  memset(x,0,sizeof(x));
-			JITFREE(JIT.MAIN_MEM);
-			JITFREE(JIT.SWIRAM);
-			JITFREE(JIT.ARM9_ITCM);
-			JITFREE(JIT.ARM9_LCDC);
-			JITFREE(JIT.ARM9_BIOS);
-			JITFREE(JIT.ARM7_BIOS);
-			JITFREE(JIT.ARM7_ERAM);
-			JITFREE(JIT.ARM7_WIRAM);
-			JITFREE(JIT.ARM7_WRAM);
-		#undef JITFREE
+		//the code these pointers point to was freed along with its pages
+		#define JITCLEAR(x)  memset(x,0,sizeof(x));
+			JITCLEAR(JIT.MAIN_MEM);
+			JITCLEAR(JIT.SWIRAM);
+			JITCLEAR(JIT.ARM9_ITCM);
+			JITCLEAR(JIT.ARM9_LCDC);
+			JITCLEAR(JIT.ARM9_BIOS);
+			JITCLEAR(JIT.ARM7_BIOS);
+			JITCLEAR(JIT.ARM7_ERAM);
+			JITCLEAR(JIT.ARM7_WIRAM);
+			JITCLEAR(JIT.ARM7_WRAM);
+		#undef JITCLEAR
 
 		memset(recompile_counts, 0, sizeof(recompile_counts));
 		init_jit_mem();
@@ -26,10 +26,31 @@
 
 typedef u32 (DESMUME_FASTCALL* ArmOpCompiled)();
 
+// State shared by blocks that are linked to each other. A block whose successor is already
+// compiled jumps straight into it, as long as the chain still has budget left, instead of
+// returning to the CPU loop. The link always goes through the successor's JIT_COMPILED_FUNC
+// entry, so zeroing that entry is all it takes to unlink it.
+struct JIT_LINK_struct
+{
+	uintptr_t entry;	// block that starts the chain
+	uintptr_t sp;		// stack pointer that a linked successor is entered with
+	s32 budget;			// cycles the chain may still run for before returning to the CPU loop
+	u32 cycles;			// cycles spent in blocks that were left through a link
+};
+extern JIT_LINK_struct JIT_LINK;
+
 void arm_jit_reset(bool enable, bool suppress_msg = false);
+void arm_jit_invalidate(u32 adr, u32 size);
 void arm_jit_close();
 void arm_jit_sync();
 template<int PROCNUM> u32 arm_jit_compile();
+u32 arm_jit_run_linked(ArmOpCompiled f, s32 linkBudget);
+
+// Makes any running chain of linked blocks return to the CPU loop at its next link.
+FORCEINLINE void arm_jit_break_link()
+{
+	JIT_LINK.budget = 0;
+}
 
 //#define MAPPED_JIT_FUNCS: to define or not to define?
 //* x86 windows seems faster with NON-DEFINED
@@ -79,4 +100,10 @@ extern uintptr_t compiled_funcs[];
 
 extern u32 saveBlockSizeJIT;
 
+// LRU stamps of the 16KB guest pages that compiled blocks were last dispatched from,
+// used to pick which page's code to evict when the code cache is full
+extern u32 JIT_PAGE_USE[2][0x4000];
+extern u32 jit_use_clock;
+#define JIT_TOUCH_PAGE(adr, PROCNUM) JIT_PAGE_USE[PROCNUM][((adr)&0x0FFFFFFF)>>14] = jit_use_clock
+
 #endif
@@ -736,23 +736,28 @@ void arm_jit_sync()
 	armcpu_prefetch<1>();
 }
 
+//linkBudget is how many cycles compiled blocks may run for by jumping straight into each other
+//before they have to come back here. 0 runs a single block.
 template<int PROCNUM, bool jit>
-u32 armcpu_exec()
+u32 armcpu_exec(s32 linkBudget)
 {
 	if (jit)
 	{
 		ARMPROC.instruct_adr &= ARMPROC.CPSR.bits.T?0xFFFFFFFE:0xFFFFFFFC;
 		ArmOpCompiled f = (ArmOpCompiled)JIT_COMPILED_FUNC(ARMPROC.instruct_adr, PROCNUM);
-		return f ? f() : arm_jit_compile<PROCNUM>();
+		if (!f)
+			return arm_jit_compile<PROCNUM>();
+		JIT_TOUCH_PAGE(ARMPROC.instruct_adr, PROCNUM);
+		return (linkBudget > 0) ? arm_jit_run_linked(f, linkBudget) : f();
 	}
 
 	return armcpu_exec<PROCNUM>();
 }
 
-template u32 armcpu_exec<0,false>();
-template u32 armcpu_exec<0,true>();
-template u32 armcpu_exec<1,false>();
-template u32 armcpu_exec<1,true>();
+template u32 armcpu_exec<0,false>(s32 linkBudget);
+template u32 armcpu_exec<0,true>(s32 linkBudget);
+template u32 armcpu_exec<1,false>(s32 linkBudget);
+template u32 armcpu_exec<1,true>(s32 linkBudget);
 #endif
 
 void setIF(int PROCNUM, u32 flag)
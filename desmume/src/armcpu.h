@@ -353,7 +353,7 @@ extern const armcpu_ctrl_iface arm_default_ctrl_iface;
 
 template<int PROCNUM> u32 armcpu_exec();
 #ifdef HAVE_JIT
-template<int PROCNUM, bool jit> u32 armcpu_exec();
+template<int PROCNUM, bool jit> u32 armcpu_exec(s32 linkBudget);
 #endif
 
 void setIF(int PROCNUM, u32 flag);
@@ -23,6 +23,11 @@
 #include "MMU.h"
 #include "debug.h"
 #include "emufile.h"
+#include "utils/task.h"
+#include "ROMReader.h"
+
+#include <sys/stat.h>
+#include <algorithm>
 
 #ifndef _MSC_VER 
 #include <stdint.h>
@@ -35,6 +40,46 @@ CHEATSEARCH *cheatSearch = NULL;
 
 static bool cheatsResetJit = false;
 
+// Main memory ranges that cheat codes changed since the last ResetJitIfNeeded(). Only the
+// compiled code covering these gets dropped, unless there were too many of them to track.
+#define CHEATS_JIT_RANGES_MAX 64
+
+struct CHEATS_JIT_RANGE
+{
+	u32 address;
+	u32 length;
+};
+
+static CHEATS_JIT_RANGE cheatsJitRange[CHEATS_JIT_RANGES_MAX];
+static size_t cheatsJitRangeCount = 0;
+static bool cheatsJitRangeOverflow = false;
+
+static void CheatsRecordJitRange(const u32 address, const u32 length)
+{
+	// codes usually patch consecutive words, so try to grow the last range first
+	if (cheatsJitRangeCount > 0)
+	{
+		CHEATS_JIT_RANGE &last = cheatsJitRange[cheatsJitRangeCount - 1];
+		if ( (address <= last.address + last.length) && (address + length >= last.address) )
+		{
+			const u32 end = std::max<u32>(last.address + last.length, address + length);
+			last.address = std::min<u32>(last.address, address);
+			last.length = end - last.address;
+			return;
+		}
+	}
+
+	if (cheatsJitRangeCount >= CHEATS_JIT_RANGES_MAX)
+	{
+		cheatsJitRangeOverflow = true;
+		return;
+	}
+
+	cheatsJitRange[cheatsJitRangeCount].address = address;
+	cheatsJitRange[cheatsJitRangeCount].length = length;
+	cheatsJitRangeCount++;
+}
+
 void CHEATS::clear()
 {
 	this->_list.resize(0);
@@ -146,7 +191,13 @@ bool CHEATS::move(size_t srcPos, size_t dstPos)
 template <size_t LENGTH>
 bool CHEATS::DirectWrite(const int targetProc, const u32 targetAddress, u32 newValue)
 {
-	return MMU_WriteFromExternal<u32, LENGTH>(targetProc, targetAddress, newValue);
+	const bool needsJitReset = MMU_WriteFromExternal<u32, LENGTH>(targetProc, targetAddress, newValue);
+	if (needsJitReset)
+	{
+		CheatsRecordJitRange(targetAddress, (LENGTH == 3) ? 4 : LENGTH);
+	}
+	
+	return needsJitReset;
 }
 
 template bool CHEATS::DirectWrite<1>(const int targetProc, const u32 targetAddress, u32 newValue);
@@ -1220,8 +1271,16 @@ bool CHEATS::ResetJitIfNeeded()
 	{
 		if (CommonSettings.use_jit)
 		{
-			printf("Cheat code operation potentially not compatible with JIT operations. Resetting JIT...\n");
-			arm_jit_reset(true, true);
+			if ( (cheatsJitRangeCount > 0) && !cheatsJitRangeOverflow )
+			{
+				for (size_t i = 0; i < cheatsJitRangeCount; i++)
+					arm_jit_invalidate(cheatsJitRange[i].address, cheatsJitRange[i].length);
+			}
+			else
+			{
+				printf("Cheat code operation potentially not compatible with JIT operations. Resetting JIT...\n");
+				arm_jit_reset(true, true);
+			}
 		}
 		
 		cheatsResetJit = false;
@@ -1229,6 +1288,9 @@ bool CHEATS::ResetJitIfNeeded()
 	}
 #endif
 	
+	cheatsJitRangeCount = 0;
+	cheatsJitRangeOverflow = false;
+	
 	return didJitReset;
 }
 
@@ -1327,6 +1389,343 @@ bool CHEATS::XXCodeFromString(const char *codeString, CHEATS_LIST &outCheatItem)
 }
 
 // ========================================== search
+
+// The candidate bitmap (_statMem) holds one bit per byte of main memory, and a value of
+// N bytes owns N consecutive bits. A search pass is split into chunks of memory that run
+// on their own threads. Where the host has vectors, each chunk compares a whole vector of
+// values at once, producing the candidate bits 16 or 32 bytes at a time, and skips any
+// stretch of memory whose candidate bits were already cleared by an earlier pass.
+
+// Chunk boundaries have to line up with the 3 byte value stride, the candidate bitmap
+// bytes and the vector width.
+#define CHEATSEARCH_CHUNK_ALIGN 0x600
+
+struct CheatSearchParam
+{
+	const u8 *cur;
+	u8 *prev;
+	u8 *stat;
+	u32 begin;
+	u32 end;
+	u32 size;
+	CheatSearchCompare compare;
+	u32 valueA;
+	u32 valueB;
+	u32 valueMask;
+	u32 signBit;
+	u32 signedBias;
+	bool updateMem;
+	u32 amount;
+};
+
+static const u32 cheatSearchSignBit[4] = { 0x00000080, 0x00008000, 0x00800000, 0x80000000 };
+
+static FORCEINLINE u32 CheatSearch_ValueMask(const u32 size)
+{
+	return (cheatSearchSignBit[size & 3] << 1) - 1;
+}
+
+static FORCEINLINE u32 CheatSearch_ReadValue(const u8 *mem, const u32 i, const u32 size)
+{
+	switch (size)
+	{
+		case 0: return (u32)T1ReadByte((u8 *)mem, i);
+		case 1: return (u32)T1ReadWord((u8 *)mem, i);
+		case 2: return (u32)mem[i] | ((u32)mem[i+1] << 8) | ((u32)mem[i+2] << 16);
+		case 3: return (u32)T1ReadLong((u8 *)mem, i);
+		default: break;
+	}
+	
+	return 0;
+}
+
+static FORCEINLINE u32 CheatSearch_PopCount(u32 bits)
+{
+	bits = bits - ((bits >> 1) & 0x55555555);
+	bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+	return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+static FORCEINLINE bool CheatSearch_TestValue(const CheatSearchParam &param, const u32 cur, const u32 prev)
+{
+	switch (param.compare)
+	{
+		case CheatSearchCompare_Greater:  return (cur > prev);
+		case CheatSearchCompare_Lesser:   return (cur < prev);
+		case CheatSearchCompare_Equal:    return (cur == prev);
+		case CheatSearchCompare_NotEqual: return (cur != prev);
+		case CheatSearchCompare_Exact:    return (cur == param.valueA);
+		case CheatSearchCompare_Range:    return ( ((cur ^ param.signedBias) >= (param.valueA ^ param.signedBias)) && ((cur ^ param.signedBias) <= (param.valueB ^ param.signedBias)) );
+		case CheatSearchCompare_Delta:    return ( ((cur - prev) & param.valueMask) == param.valueA );
+		default: break;
+	}
+	
+	return false;
+}
+
+static void CheatSearch_ScanScalar(CheatSearchParam &param)
+{
+	const u32 step = param.size + 1;
+	const u32 stepBits = (1 << step) - 1;
+	u32 amount = 0;
+	
+	for (u32 i = param.begin; (i + step) <= param.end; i += step)
+	{
+		u8 &statByte = param.stat[i >> 3];
+		const u32 bits = stepBits << (i & 7);
+		
+		if ((statByte & bits) == 0)
+			continue;
+		
+		if (CheatSearch_TestValue(param, CheatSearch_ReadValue(param.cur, i, param.size), CheatSearch_ReadValue(param.prev, i, param.size)))
+		{
+			statByte |= bits;
+			amount++;
+		}
+		else
+		{
+			statByte &= ~bits;
+		}
+	}
+	
+	param.amount = amount;
+}
+
+#if defined(ENABLE_AVX2)
+
+struct CheatSearchOps
+{
+	typedef v256u8 Vector;
+	enum { BYTES = sizeof(v256u8) };
+	
+	static FORCEINLINE v256u8 Load(const u8 *src) { return _mm256_loadu_si256((const v256u8 *)src); }
+	static FORCEINLINE v256u8 Xor(const v256u8 &a, const v256u8 &b) { return _mm256_xor_si256(a, b); }
+	static FORCEINLINE v256u8 Or(const v256u8 &a, const v256u8 &b) { return _mm256_or_si256(a, b); }
+	static FORCEINLINE u32 MoveMask(const v256u8 &v) { return (u32)_mm256_movemask_epi8(v); }
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v256u8 Set1(const u32 v)
+	{
+		return (ELEMENTSIZE == 1) ? _mm256_set1_epi8((s8)v) : (ELEMENTSIZE == 2) ? _mm256_set1_epi16((s16)v) : _mm256_set1_epi32((s32)v);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v256u8 Equal(const v256u8 &a, const v256u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? _mm256_cmpeq_epi8(a, b) : (ELEMENTSIZE == 2) ? _mm256_cmpeq_epi16(a, b) : _mm256_cmpeq_epi32(a, b);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v256u8 Greater(const v256u8 &a, const v256u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? _mm256_cmpgt_epi8(a, b) : (ELEMENTSIZE == 2) ? _mm256_cmpgt_epi16(a, b) : _mm256_cmpgt_epi32(a, b);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v256u8 Sub(const v256u8 &a, const v256u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? _mm256_sub_epi8(a, b) : (ELEMENTSIZE == 2) ? _mm256_sub_epi16(a, b) : _mm256_sub_epi32(a, b);
+	}
+};
+
+#elif defined(ENABLE_SSE2)
+
+struct CheatSearchOps
+{
+	typedef v128u8 Vector;
+	enum { BYTES = sizeof(v128u8) };
+	
+	static FORCEINLINE v128u8 Load(const u8 *src) { return _mm_loadu_si128((const v128u8 *)src); }
+	static FORCEINLINE v128u8 Xor(const v128u8 &a, const v128u8 &b) { return _mm_xor_si128(a, b); }
+	static FORCEINLINE v128u8 Or(const v128u8 &a, const v128u8 &b) { return _mm_or_si128(a, b); }
+	static FORCEINLINE u32 MoveMask(const v128u8 &v) { return (u32)_mm_movemask_epi8(v); }
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Set1(const u32 v)
+	{
+		return (ELEMENTSIZE == 1) ? _mm_set1_epi8((s8)v) : (ELEMENTSIZE == 2) ? _mm_set1_epi16((s16)v) : _mm_set1_epi32((s32)v);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Equal(const v128u8 &a, const v128u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? _mm_cmpeq_epi8(a, b) : (ELEMENTSIZE == 2) ? _mm_cmpeq_epi16(a, b) : _mm_cmpeq_epi32(a, b);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Greater(const v128u8 &a, const v128u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? _mm_cmpgt_epi8(a, b) : (ELEMENTSIZE == 2) ? _mm_cmpgt_epi16(a, b) : _mm_cmpgt_epi32(a, b);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Sub(const v128u8 &a, const v128u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? _mm_sub_epi8(a, b) : (ELEMENTSIZE == 2) ? _mm_sub_epi16(a, b) : _mm_sub_epi32(a, b);
+	}
+};
+
+#elif defined(ENABLE_NEON_A64)
+
+struct CheatSearchOps
+{
+	typedef v128u8 Vector;
+	enum { BYTES = sizeof(v128u8) };
+	
+	static FORCEINLINE v128u8 Load(const u8 *src) { return vld1q_u8(src); }
+	static FORCEINLINE v128u8 Xor(const v128u8 &a, const v128u8 &b) { return veorq_u8(a, b); }
+	static FORCEINLINE v128u8 Or(const v128u8 &a, const v128u8 &b) { return vorrq_u8(a, b); }
+	
+	static FORCEINLINE u32 MoveMask(const v128u8 &v)
+	{
+		static const u8 bitWeight[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+		const v128u8 bits = vandq_u8(v, vld1q_u8(bitWeight));
+		return (u32)vaddv_u8(vget_low_u8(bits)) | ((u32)vaddv_u8(vget_high_u8(bits)) << 8);
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Set1(const u32 v)
+	{
+		return (ELEMENTSIZE == 1) ? vdupq_n_u8((u8)v) : (ELEMENTSIZE == 2) ? vreinterpretq_u8_u16(vdupq_n_u16((u16)v)) : vreinterpretq_u8_u32(vdupq_n_u32(v));
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Equal(const v128u8 &a, const v128u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? vceqq_u8(a, b) :
+		       (ELEMENTSIZE == 2) ? vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b))) :
+		                            vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Greater(const v128u8 &a, const v128u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? vcgtq_s8(vreinterpretq_s8_u8(a), vreinterpretq_s8_u8(b)) :
+		       (ELEMENTSIZE == 2) ? vreinterpretq_u8_u16(vcgtq_s16(vreinterpretq_s16_u8(a), vreinterpretq_s16_u8(b))) :
+		                            vreinterpretq_u8_u32(vcgtq_s32(vreinterpretq_s32_u8(a), vreinterpretq_s32_u8(b)));
+	}
+	
+	template <size_t ELEMENTSIZE>
+	static FORCEINLINE v128u8 Sub(const v128u8 &a, const v128u8 &b)
+	{
+		return (ELEMENTSIZE == 1) ? vsubq_u8(a, b) :
+		       (ELEMENTSIZE == 2) ? vreinterpretq_u8_u16(vsubq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b))) :
+		                            vreinterpretq_u8_u32(vsubq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+	}
+};
+
+#endif
+
+#if defined(ENABLE_AVX2) || defined(ENABLE_SSE2) || defined(ENABLE_NEON_A64)
+
+// Vector version of CheatSearch_ScanScalar() for 1, 2 and 4 byte values. The vectors only
+// have signed compares, so for ordered compares both sides get their sign bit flipped
+// unless the search is meant to be signed.
+template <size_t ELEMENTSIZE, CheatSearchCompare COMPARE>
+static void CheatSearch_ScanVector(CheatSearchParam &param)
+{
+	typedef CheatSearchOps::Vector V;
+	
+	const V flip = CheatSearchOps::Set1<ELEMENTSIZE>(param.signBit ^ param.signedBias);
+	const V valueA = CheatSearchOps::Set1<ELEMENTSIZE>(param.valueA);
+	const V keyA = CheatSearchOps::Xor(valueA, flip);
+	const V keyB = CheatSearchOps::Xor(CheatSearchOps::Set1<ELEMENTSIZE>(param.valueB), flip);
+	u32 bitCount = 0;
+	
+	for (u32 i = param.begin; i < param.end; i += CheatSearchOps::BYTES)
+	{
+		u32 statBits = 0;
+		memcpy(&statBits, param.stat + (i >> 3), CheatSearchOps::BYTES / 8);
+		if (statBits == 0)
+			continue;
+		
+		const V cur = CheatSearchOps::Load(param.cur + i);
+		u32 passBits = 0;
+		
+		switch (COMPARE)
+		{
+			case CheatSearchCompare_Greater:
+			case CheatSearchCompare_Lesser:
+			{
+				const V keyCur = CheatSearchOps::Xor(cur, flip);
+				const V keyPrev = CheatSearchOps::Xor(CheatSearchOps::Load(param.prev + i), flip);
+				passBits = (COMPARE == CheatSearchCompare_Greater) ? CheatSearchOps::MoveMask(CheatSearchOps::Greater<ELEMENTSIZE>(keyCur, keyPrev)) : CheatSearchOps::MoveMask(CheatSearchOps::Greater<ELEMENTSIZE>(keyPrev, keyCur));
+				break;
+			}
+				
+			case CheatSearchCompare_Equal:
+				passBits = CheatSearchOps::MoveMask(CheatSearchOps::Equal<ELEMENTSIZE>(cur, CheatSearchOps::Load(param.prev + i)));
+				break;
+				
+			case CheatSearchCompare_NotEqual:
+				passBits = ~CheatSearchOps::MoveMask(CheatSearchOps::Equal<ELEMENTSIZE>(cur, CheatSearchOps::Load(param.prev + i)));
+				break;
+				
+			case CheatSearchCompare_Exact:
+				passBits = CheatSearchOps::MoveMask(CheatSearchOps::Equal<ELEMENTSIZE>(cur, valueA));
+				break;
+				
+			case CheatSearchCompare_Range:
+			{
+				const V keyCur = CheatSearchOps::Xor(cur, flip);
+				passBits = ~CheatSearchOps::MoveMask(CheatSearchOps::Or(CheatSearchOps::Greater<ELEMENTSIZE>(keyA, keyCur), CheatSearchOps::Greater<ELEMENTSIZE>(keyCur, keyB)));
+				break;
+			}
+				
+			case CheatSearchCompare_Delta:
+				passBits = CheatSearchOps::MoveMask(CheatSearchOps::Equal<ELEMENTSIZE>(CheatSearchOps::Sub<ELEMENTSIZE>(cur, CheatSearchOps::Load(param.prev + i)), valueA));
+				break;
+				
+			default:
+				break;
+		}
+		
+		statBits &= passBits;
+		memcpy(param.stat + (i >> 3), &statBits, CheatSearchOps::BYTES / 8);
+		bitCount += CheatSearch_PopCount(statBits);
+	}
+	
+	param.amount = bitCount / ELEMENTSIZE;
+}
+
+template <size_t ELEMENTSIZE>
+static void CheatSearch_ScanVector(CheatSearchParam &param)
+{
+	switch (param.compare)
+	{
+		case CheatSearchCompare_Greater:  CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_Greater>(param); break;
+		case CheatSearchCompare_Lesser:   CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_Lesser>(param); break;
+		case CheatSearchCompare_Equal:    CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_Equal>(param); break;
+		case CheatSearchCompare_NotEqual: CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_NotEqual>(param); break;
+		case CheatSearchCompare_Exact:    CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_Exact>(param); break;
+		case CheatSearchCompare_Range:    CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_Range>(param); break;
+		case CheatSearchCompare_Delta:    CheatSearch_ScanVector<ELEMENTSIZE, CheatSearchCompare_Delta>(param); break;
+		default: break;
+	}
+}
+
+#endif
+
+static void CheatSearch_RunSearch(void *arg, size_t index)
+{
+	CheatSearchParam &param = ((CheatSearchParam *)arg)[index];
+	
+	switch (param.size)
+	{
+#if defined(ENABLE_AVX2) || defined(ENABLE_SSE2) || defined(ENABLE_NEON_A64)
+		case 0: CheatSearch_ScanVector<1>(param); break;
+		case 1: CheatSearch_ScanVector<2>(param); break;
+		case 3: CheatSearch_ScanVector<4>(param); break;
+#endif
+		default: CheatSearch_ScanScalar(param); break;
+	}
+	
+	if (param.updateMem)
+	{
+		memcpy(param.prev + param.begin, param.cur + param.begin, param.end - param.begin);
+	}
+}
+
 bool CHEATSEARCH::start(u8 type, u8 size, u8 sign)
 {
 	bool didStartSearch = false;
@@ -1339,19 +1738,25 @@ bool CHEATSEARCH::start(u8 type, u8 size, u8 sign)
 		return didStartSearch;
 	}
 
-	this->_statMem = new u8 [ ( 4 * 1024 * 1024 ) / 8 ];
-	memset(this->_statMem, 0xFF, ( 4 * 1024 * 1024 ) / 8);
+	// search all of the main memory that the emulated console has, not just the 4MB of a retail DS
+	this->_ramSize = _MMU_MAIN_MEM_MASK + 1;
+
+	this->_statMem = new u8 [this->_ramSize / 8];
+	memset(this->_statMem, 0xFF, this->_ramSize / 8);
 
-	// comparative search type (need 8Mb RAM !!! (4+4))
-	this->_mem = new u8 [ ( 4 * 1024 * 1024 ) ];
-	memcpy(this->_mem, MMU.MMU_MEM[0][0x20], ( 4 * 1024 * 1024 ) );
+	// comparative search type (needs twice the RAM size)
+	this->_mem = new u8 [this->_ramSize];
+	memcpy(this->_mem, MMU.MMU_MEM[ARMCPU_ARM9][0x20], this->_ramSize);
 
 	this->_type = type;
-	this->_size = size;
+	this->_size = size & 3;
 	this->_sign = sign;
 	this->_amount = 0;
 	this->_lastRecord = 0;
 	
+	// RAM is searched in one chunk per thread, which the shared task pool runs side by side
+	this->_threadCount = std::max<size_t>(std::min<size_t>(CommonSettings.num_cores, CHEATSEARCH_MAX_THREADS), 1);
+	
 	//INFO("Cheat search system is inited (type %s)\n", type?"comparative":"exact");
 	didStartSearch = true;
 	return didStartSearch;
@@ -1359,6 +1764,8 @@ bool CHEATSEARCH::start(u8 type, u8 size, u8 sign)
 
 void CHEATSEARCH::close()
 {
+	this->_threadCount = 0;
+
 	if (this->_statMem != NULL)
 	{
 		delete [] this->_statMem;
@@ -1376,204 +1783,80 @@ void CHEATSEARCH::close()
 	//INFO("Cheat search system is closed\n");
 }
 
-u32 CHEATSEARCH::search(u32 val)
+u32 CHEATSEARCH::_runSearch(CheatSearchCompare compare, u32 valueA, u32 valueB, bool updateMem)
 {
+	CheatSearchParam param[CHEATSEARCH_MAX_THREADS];
+	const size_t chunkCount = std::max<size_t>(this->_threadCount, 1);
+	const u32 chunkSize = ((this->_ramSize / (u32)chunkCount) / CHEATSEARCH_CHUNK_ALIGN) * CHEATSEARCH_CHUNK_ALIGN;
+	
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		param[i].cur = MMU.MMU_MEM[ARMCPU_ARM9][0x20];
+		param[i].prev = this->_mem;
+		param[i].stat = this->_statMem;
+		param[i].begin = (u32)i * chunkSize;
+		param[i].end = (i < chunkCount - 1) ? (u32)(i + 1) * chunkSize : this->_ramSize;
+		param[i].size = this->_size;
+		param[i].compare = compare;
+		param[i].valueA = valueA;
+		param[i].valueB = valueB;
+		param[i].valueMask = CheatSearch_ValueMask(this->_size);
+		param[i].signBit = cheatSearchSignBit[this->_size];
+		param[i].signedBias = ( (compare == CheatSearchCompare_Range) && (this->_sign != 0) ) ? cheatSearchSignBit[this->_size] : 0;
+		param[i].updateMem = updateMem;
+		param[i].amount = 0;
+	}
+	
+	TaskPool_ParallelFor(TaskGroup_CheatSearch, chunkCount, &CheatSearch_RunSearch, param);
+	
 	this->_amount = 0;
-
-	switch (this->_size)
+	for (size_t i = 0; i < chunkCount; i++)
 	{
-		case 0:		// 1 byte
-			for (u32 i = 0; i < (4 * 1024 * 1024); i++)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (1<<offs))
-				{
-					if ( T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) == val )
-					{
-						this->_statMem[addr] |= (1<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(1<<offs);
-				}
-			}
-		break;
-
-		case 1:		// 2 bytes
-			for (u32 i = 0; i < (4 * 1024 * 1024); i+=2)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (3<<offs))
-				{
-					if ( T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) == val )
-					{
-						this->_statMem[addr] |= (3<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(3<<offs);
-				}
-			}
-		break;
-
-		case 2:		// 3 bytes
-			for (u32 i = 0; i < (4 * 1024 * 1024); i+=3)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (0x7<<offs))
-				{
-					if ( (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) & 0x00FFFFFF) == val )
-					{
-						this->_statMem[addr] |= (0x7<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(0x7<<offs);
-				}
-			}
-		break;
-
-		case 3:		// 4 bytes
-			for (u32 i = 0; i < (4 * 1024 * 1024); i+=4)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (0xF<<offs))
-				{
-					if ( T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) == val )
-					{
-						this->_statMem[addr] |= (0xF<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(0xF<<offs);
-				}
-			}
-		break;
+		this->_amount += param[i].amount;
 	}
-
+	
 	return this->_amount;
 }
 
-u32 CHEATSEARCH::search(u8 comp)
+u32 CHEATSEARCH::search(u32 val)
 {
-	bool didComparePass = false;
-
-	this->_amount = 0;
-	
-	switch (this->_size)
+	if ((val & ~CheatSearch_ValueMask(this->_size)) != 0)
 	{
-		case 0:		// 1 byte
-			for (u32 i = 0; i < (4 * 1024 * 1024); i++)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (1<<offs))
-				{
-					switch (comp)
-					{
-						case 0: didComparePass = (T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) > T1ReadByte(this->_mem, i)); break;
-						case 1: didComparePass = (T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) < T1ReadByte(this->_mem, i)); break;
-						case 2: didComparePass = (T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) == T1ReadByte(this->_mem, i)); break;
-						case 3: didComparePass = (T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) != T1ReadByte(this->_mem, i)); break;
-						default: didComparePass = false; break;
-					}
-					if (didComparePass)
-					{
-						this->_statMem[addr] |= (1<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(1<<offs);
-				}
-			}
-		break;
-
-		case 1:		// 2 bytes
-			for (u32 i = 0; i < (4 * 1024 * 1024); i+=2)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (3<<offs))
-				{
-					switch (comp)
-					{
-						case 0: didComparePass = (T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) > T1ReadWord(this->_mem, i)); break;
-						case 1: didComparePass = (T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) < T1ReadWord(this->_mem, i)); break;
-						case 2: didComparePass = (T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) == T1ReadWord(this->_mem, i)); break;
-						case 3: didComparePass = (T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) != T1ReadWord(this->_mem, i)); break;
-						default: didComparePass = false; break;
-					}
-					if (didComparePass)
-					{
-						this->_statMem[addr] |= (3<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(3<<offs);
-				}
-			}
-		break;
-
-		case 2:		// 3 bytes
-			for (u32 i = 0; i < (4 * 1024 * 1024); i+=3)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (7<<offs))
-				{
-					switch (comp)
-					{
-						case 0: didComparePass = ((T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) & 0x00FFFFFF) > (T1ReadLong(this->_mem, i) & 0x00FFFFFF) ); break;
-						case 1: didComparePass = ((T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) & 0x00FFFFFF) < (T1ReadLong(this->_mem, i) & 0x00FFFFFF) ); break;
-						case 2: didComparePass = ((T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) & 0x00FFFFFF) == (T1ReadLong(this->_mem, i) & 0x00FFFFFF) ); break;
-						case 3: didComparePass = ((T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) & 0x00FFFFFF) != (T1ReadLong(this->_mem, i) & 0x00FFFFFF) ); break;
-						default: didComparePass = false; break;
-					}
-					if (didComparePass)
-					{
-						this->_statMem[addr] |= (7<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(7<<offs);
-				}
-			}
-		break;
+		// no value of the searched size can ever match
+		memset(this->_statMem, 0, this->_ramSize / 8);
+		this->_amount = 0;
+		return this->_amount;
+	}
+	
+	return this->_runSearch(CheatSearchCompare_Exact, val, 0, false);
+}
 
-		case 3:		// 4 bytes
-			for (u32 i = 0; i < (4 * 1024 * 1024); i+=4)
-			{
-				u32	addr = (i >> 3);
-				u32	offs = (i % 8);
-				if (this->_statMem[addr] & (0xF<<offs))
-				{
-					switch (comp)
-					{
-						case 0: didComparePass = (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) > T1ReadLong(this->_mem, i)); break;
-						case 1: didComparePass = (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) < T1ReadLong(this->_mem, i)); break;
-						case 2: didComparePass = (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) == T1ReadLong(this->_mem, i)); break;
-						case 3: didComparePass = (T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) != T1ReadLong(this->_mem, i)); break;
-						default: didComparePass = false; break;
-					}
-					if (didComparePass)
-					{
-						this->_statMem[addr] |= (0xF<<offs);
-						this->_amount++;
-						continue;
-					}
-					this->_statMem[addr] &= ~(0xF<<offs);
-				}
-			}
-		break;
+u32 CHEATSEARCH::search(u8 comp)
+{
+	if (comp > CheatSearchCompare_NotEqual)
+	{
+		memset(this->_statMem, 0, this->_ramSize / 8);
+		memcpy(this->_mem, MMU.MMU_MEM[ARMCPU_ARM9][0x20], this->_ramSize);
+		this->_amount = 0;
+		return this->_amount;
 	}
+	
+	return this->_runSearch((CheatSearchCompare)comp, 0, 0, true);
+}
 
-	memcpy(this->_mem, MMU.MMU_MEM[0][0x20], ( 4 * 1024 * 1024 ) );
+// Keeps the values that lie within [minVal, maxVal]. The bounds are compared as signed values
+// if the search was started as a signed one.
+u32 CHEATSEARCH::searchRange(u32 minVal, u32 maxVal)
+{
+	const u32 valueMask = CheatSearch_ValueMask(this->_size);
+	return this->_runSearch(CheatSearchCompare_Range, minVal & valueMask, maxVal & valueMask, false);
+}
 
-	return this->_amount;
+// Keeps the values that changed by exactly delta since the last comparative search. Pass a
+// negative delta as its two's complement, e.g. (u32)-1 for values that went down by one.
+u32 CHEATSEARCH::searchDelta(u32 delta)
+{
+	return this->_runSearch(CheatSearchCompare_Delta, delta & CheatSearch_ValueMask(this->_size), 0, true);
 }
 
 u32 CHEATSEARCH::getAmount()
@@ -1594,7 +1877,7 @@ bool CHEATSEARCH::getList(u32 *address, u32 *curVal)
 		case 3: stepMem = 0xF; break;
 	}
 
-	for (u32 i = this->_lastRecord; i < (4 * 1024 * 1024); i+=step)
+	for (u32 i = this->_lastRecord; (i + step) <= this->_ramSize; i+=step)
 	{
 		u32	addr = (i >> 3);
 		u32	offs = (i % 8);
@@ -1602,15 +1885,7 @@ bool CHEATSEARCH::getList(u32 *address, u32 *curVal)
 		{
 			*address = i;
 			this->_lastRecord = i+step;
-			
-			switch (this->_size)
-			{
-				case 0: *curVal = (u32)T1ReadByte(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i); break;
-				case 1: *curVal = (u32)T1ReadWord(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i); break;
-				case 2: *curVal = (u32)T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i) & 0x00FFFFFF; break;
-				case 3: *curVal = (u32)T1ReadLong(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i); break;
-				default: break;
-			}
+			*curVal = CheatSearch_ReadValue(MMU.MMU_MEM[ARMCPU_ARM9][0x20], i, this->_size);
 
 			didGetValue = true;
 			return didGetValue;
@@ -2139,6 +2414,11 @@ CheatDBFile::CheatDBFile()
 	_isEncrypted = false;
 	_size = 0;
 	_fp = NULL;
+	
+	_indexFile = NULL;
+	_index = NULL;
+	_indexCount = 0;
+	_indexChecked = false;
 }
 
 CheatDBFile::~CheatDBFile()
@@ -2249,6 +2529,8 @@ void CheatDBFile::CloseFile()
 		fclose(this->_fp);
 		this->_fp = NULL;
 	}
+	
+	this->_CloseIndex();
 }
 
 void CheatDBFile::R4Decrypt(u8 *buf, const size_t len, u64 n)
@@ -2327,28 +2609,22 @@ bool CheatDBFile::ReadToBuffer(FILE *fp, const size_t fileOffset,
 	return didReadSuccessfully;
 }
 
-CheatDBGame CheatDBFile::_ReadGame(const u32 encryptOffset, const FAT_R4 &fat, const u32 gameDataSize, u8 (&workingBuffer)[1024])
+CheatDBGame CheatDBFile::_ReadGame(const CheatDBIndexEntry &entry, u8 (&workingBuffer)[1024])
 {
-	return CheatDBGame(this->_fp, this->_isEncrypted, encryptOffset, fat, gameDataSize, workingBuffer);
+	FAT_R4 fat;
+	memcpy(fat.serial, entry.serial, sizeof(fat.serial));
+	fat.CRC = ((u32)entry.crcKey[0] << 24) | ((u32)entry.crcKey[1] << 16) | ((u32)entry.crcKey[2] << 8) | (u32)entry.crcKey[3];
+	fat.addr = LE_TO_LOCAL_32(entry.addr);
+	
+	const u32 encryptOffset = (this->_isEncrypted) ? (u32)(fat.addr % 512) : 0;
+	return CheatDBGame(this->_fp, this->_isEncrypted, encryptOffset, fat, LE_TO_LOCAL_32(entry.dataSize), workingBuffer);
 }
 
-u32 CheatDBFile::LoadGameList(const char *gameCode, const u32 gameDatabaseCRC, CheatDBGameList &outList)
+// Walks the FAT of the database, adding every game that has some data to the list in the
+// order that the games appear in the file.
+void CheatDBFile::_ReadFAT(std::vector<CheatDBIndexEntry> &outList)
 {
-	u32 entryCount = 0;
-	if (this->_fp == NULL)
-	{
-		return entryCount;
-	}
-	
-	// If gameCode is NULL, then we're going to assume that the entire
-	// game list will be rebuilt from scratch.
-	if (gameCode == NULL)
-	{
-		outList.resize(0);
-	}
-	
 	u8 fatBuffer[512] = {0};
-	u8 gameEntryBuffer[1024] = {0};
 	u32 pos = CHEATDB_FILEOFFSET_FIRST_FAT_ENTRY;
 	u64 t = 0;
 	FAT_R4 fatEntryCurrent = {0};
@@ -2394,7 +2670,6 @@ u32 CheatDBFile::LoadGameList(const char *gameCode, const u32 gameDatabaseCRC, C
 			fread(&fatEntryNext, sizeof(fatEntryNext), 1, this->_fp);
 		}
 		
-		u32 encryptOffset = 0;
 		u32 dataSize = 0;
 		
 		if (fatEntryNext.addr > 0)
@@ -2414,46 +2689,236 @@ u32 CheatDBFile::LoadGameList(const char *gameCode, const u32 gameDatabaseCRC, C
 			}
 		}
 		
-		if (this->_isEncrypted)
+		if (dataSize == 0)
 		{
-			encryptOffset = (u32)(fatEntryCurrent.addr % 512);
+			continue;
 		}
 		
-		if (dataSize == 0)
+		CheatDBIndexEntry entry;
+		memcpy(entry.serial, fatEntryCurrent.serial, sizeof(entry.serial));
+		entry.crcKey[0] = (u8)(fatEntryCurrent.CRC >> 24);
+		entry.crcKey[1] = (u8)(fatEntryCurrent.CRC >> 16);
+		entry.crcKey[2] = (u8)(fatEntryCurrent.CRC >>  8);
+		entry.crcKey[3] = (u8)(fatEntryCurrent.CRC >>  0);
+		entry.addr = LOCAL_TO_LE_32((u32)fatEntryCurrent.addr);
+		entry.dataSize = LOCAL_TO_LE_32(dataSize);
+		outList.push_back(entry);
+		
+	} while (fatEntryNext.addr > 0);
+}
+
+static int CheatDBIndexEntryKeyCompare(const CheatDBIndexEntry &a, const CheatDBIndexEntry &b)
+{
+	const int result = memcmp(a.serial, b.serial, sizeof(a.serial));
+	return (result != 0) ? result : memcmp(a.crcKey, b.crcKey, sizeof(a.crcKey));
+}
+
+static bool CheatDBIndexEntryKeyLess(const CheatDBIndexEntry &a, const CheatDBIndexEntry &b)
+{
+	return (CheatDBIndexEntryKeyCompare(a, b) < 0);
+}
+
+// The index lives next to the database as <database>.idx. Its header records the size and
+// modification time of the database that it was built from, so that a replaced database
+// gets a new index.
+#define CHEATDB_INDEX_ID "DeSmuME cheat database index\x1A"
+#define CHEATDB_INDEX_VERSION 1
+#define CHEATDB_INDEX_HEADER_SIZE (strlen(CHEATDB_INDEX_ID) + 4 + 8 + 8 + 4)
+
+bool CheatDBFile::_MapIndex(const std::string &indexPath, const u64 sourceSize, const u64 sourceTime)
+{
+	void *file = MMAPROMReader.Init(indexPath.c_str());
+	if (file == NULL)
+	{
+		return false;
+	}
+	
+	const u8 *data = MMAPROMReaderGetData(file);
+	const u32 size = MMAPROMReader.Size(file);
+	const size_t idLength = strlen(CHEATDB_INDEX_ID);
+	
+	if ( (size >= CHEATDB_INDEX_HEADER_SIZE) && (memcmp(data, CHEATDB_INDEX_ID, idLength) == 0) )
+	{
+		u32 version = 0;
+		u64 indexSourceSize = 0;
+		u64 indexSourceTime = 0;
+		u32 count = 0;
+		memcpy(&version, data + idLength, 4);
+		memcpy(&indexSourceSize, data + idLength + 4, 8);
+		memcpy(&indexSourceTime, data + idLength + 12, 8);
+		memcpy(&count, data + idLength + 20, 4);
+		count = LE_TO_LOCAL_32(count);
+		
+		if ( (LE_TO_LOCAL_32(version) == CHEATDB_INDEX_VERSION) &&
+			 (LE_TO_LOCAL_64(indexSourceSize) == sourceSize) &&
+			 (LE_TO_LOCAL_64(indexSourceTime) == sourceTime) &&
+			 (count <= (size - CHEATDB_INDEX_HEADER_SIZE) / sizeof(CheatDBIndexEntry)) )
 		{
-			continue;
+			this->_indexFile = file;
+			this->_index = (const CheatDBIndexEntry *)(data + CHEATDB_INDEX_HEADER_SIZE);
+			this->_indexCount = count;
+			return true;
+		}
+	}
+	
+	MMAPROMReader.DeInit(file);
+	return false;
+}
+
+bool CheatDBFile::_OpenIndex()
+{
+	this->_indexChecked = true;
+	
+	struct stat sb;
+	if (stat(this->_path.c_str(), &sb) != 0)
+	{
+		return false;
+	}
+	
+	const std::string indexPath = this->_path + ".idx";
+	const u64 sourceSize = (u64)sb.st_size;
+	const u64 sourceTime = (u64)sb.st_mtime;
+	
+	if (this->_MapIndex(indexPath, sourceSize, sourceTime))
+	{
+		return true;
+	}
+	
+	// The index is missing or was built from a different database, so build it again. Entries
+	// with the same serial and CRC stay in FAT order, so the first one is the game that a
+	// walk of the FAT would have found.
+	std::vector<CheatDBIndexEntry> list;
+	this->_ReadFAT(list);
+	std::stable_sort(list.begin(), list.end(), &CheatDBIndexEntryKeyLess);
+	
+	{
+		EMUFILE_FILE outf(indexPath, "wb");
+		if (!outf.is_open())
+		{
+			return false;
 		}
 		
-		// If gameCode is provided, then this method will search the file for the first matching
-		// serial and CRC, and then stop searching, adding only a single entry to the game list.
-		// If all you need is a limited number of games (or just one game), then using this
-		// method is a CPU and memory efficient means to get an entry from game list.
-		//
-		// If gameCode is NULL, then this method will add all game entries from the database file
-		// to the game list. This will consume more CPU cycles and memory, but having the entire
-		// game list in memory can be useful for clients that allow for database browsing.
-		if (gameCode != NULL)
+		outf.fwrite(CHEATDB_INDEX_ID, strlen(CHEATDB_INDEX_ID));
+		outf.write_32LE((u32)CHEATDB_INDEX_VERSION);
+		outf.write_64LE(sourceSize);
+		outf.write_64LE(sourceTime);
+		outf.write_32LE((u32)list.size());
+		if (list.size() > 0)
 		{
-			if ( (gameDatabaseCRC == fatEntryCurrent.CRC) && !memcmp(gameCode, fatEntryCurrent.serial, 4) )
-			{
-				CheatDBGame *foundGameEntry = GetCheatDBGameEntryFromList(outList, gameCode, gameDatabaseCRC);
-				if (foundGameEntry == NULL)
-				{
-					// Only add to the game list if the entry has not been added yet.
-					outList.push_back( this->_ReadGame(encryptOffset, fatEntryCurrent, dataSize, gameEntryBuffer) );
-				}
-				
-				entryCount = 1;
-				return entryCount;
-			}
+			outf.fwrite(&list[0], list.size() * sizeof(CheatDBIndexEntry));
 		}
-		else
+		
+		if (outf.fail())
 		{
-			outList.push_back( this->_ReadGame(encryptOffset, fatEntryCurrent, dataSize, gameEntryBuffer) );
-			entryCount++;
+			return false;
+		}
+	}
+	
+	return this->_MapIndex(indexPath, sourceSize, sourceTime);
+}
+
+void CheatDBFile::_CloseIndex()
+{
+	if (this->_indexFile != NULL)
+	{
+		MMAPROMReader.DeInit(this->_indexFile);
+		this->_indexFile = NULL;
+	}
+	
+	this->_index = NULL;
+	this->_indexCount = 0;
+	this->_indexChecked = false;
+}
+
+bool CheatDBFile::_FindGame(const char *gameCode, const u32 gameDatabaseCRC, CheatDBIndexEntry &outEntry)
+{
+	CheatDBIndexEntry key;
+	memcpy(key.serial, gameCode, sizeof(key.serial));
+	key.crcKey[0] = (u8)(gameDatabaseCRC >> 24);
+	key.crcKey[1] = (u8)(gameDatabaseCRC >> 16);
+	key.crcKey[2] = (u8)(gameDatabaseCRC >>  8);
+	key.crcKey[3] = (u8)(gameDatabaseCRC >>  0);
+	
+	if (!this->_indexChecked)
+	{
+		this->_OpenIndex();
+	}
+	
+	if (this->_index != NULL)
+	{
+		const CheatDBIndexEntry *indexEnd = this->_index + this->_indexCount;
+		const CheatDBIndexEntry *found = std::lower_bound(this->_index, indexEnd, key, &CheatDBIndexEntryKeyLess);
+		if ( (found == indexEnd) || (CheatDBIndexEntryKeyCompare(*found, key) != 0) )
+		{
+			return false;
 		}
 		
-	} while (fatEntryNext.addr > 0);
+		outEntry = *found;
+		return true;
+	}
+	
+	// Without an index (e.g. the database is on read-only media), fall back to walking the FAT.
+	std::vector<CheatDBIndexEntry> list;
+	this->_ReadFAT(list);
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		if (CheatDBIndexEntryKeyCompare(list[i], key) == 0)
+		{
+			outEntry = list[i];
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+u32 CheatDBFile::LoadGameList(const char *gameCode, const u32 gameDatabaseCRC, CheatDBGameList &outList)
+{
+	u32 entryCount = 0;
+	if (this->_fp == NULL)
+	{
+		return entryCount;
+	}
+	
+	u8 gameEntryBuffer[1024] = {0};
+	
+	// If gameCode is provided, then this method will search the file for the first matching
+	// serial and CRC, adding only a single entry to the game list. The lookup goes through the
+	// database index, which gets built the first time that it is needed. If all you need is a
+	// limited number of games (or just one game), then using this method is a CPU and memory
+	// efficient means to get an entry from game list.
+	//
+	// If gameCode is NULL, then this method will add all game entries from the database file
+	// to the game list. This will consume more CPU cycles and memory, but having the entire
+	// game list in memory can be useful for clients that allow for database browsing.
+	if (gameCode != NULL)
+	{
+		CheatDBIndexEntry foundEntry;
+		if (this->_FindGame(gameCode, gameDatabaseCRC, foundEntry))
+		{
+			CheatDBGame *foundGameEntry = GetCheatDBGameEntryFromList(outList, gameCode, gameDatabaseCRC);
+			if (foundGameEntry == NULL)
+			{
+				// Only add to the game list if the entry has not been added yet.
+				outList.push_back( this->_ReadGame(foundEntry, gameEntryBuffer) );
+			}
+			
+			entryCount = 1;
+		}
+		
+		return entryCount;
+	}
+	
+	// The entire game list will be rebuilt from scratch.
+	outList.resize(0);
+	
+	std::vector<CheatDBIndexEntry> list;
+	this->_ReadFAT(list);
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		outList.push_back( this->_ReadGame(list[i], gameEntryBuffer) );
+		entryCount++;
+	}
 	
 	return entryCount;
 }
@@ -151,6 +151,20 @@ public:
 	static bool XXCodeFromString(const char *codeString, CHEATS_LIST &outCheatItem);
 };
 
+#define CHEATSEARCH_MAX_THREADS 8
+
+enum CheatSearchCompare
+{
+	CheatSearchCompare_Greater   = 0, // current > previous
+	CheatSearchCompare_Lesser    = 1, // current < previous
+	CheatSearchCompare_Equal     = 2, // current == previous
+	CheatSearchCompare_NotEqual  = 3, // current != previous
+	
+	CheatSearchCompare_Exact     = 4, // current == value
+	CheatSearchCompare_Range     = 5, // minimum <= current <= maximum, honoring the search sign
+	CheatSearchCompare_Delta     = 6  // current - previous == delta
+};
+
 class CHEATSEARCH
 {
 private:
@@ -158,20 +172,27 @@ private:
 	u8	*_mem;
 	u32	_amount;
 	u32	_lastRecord;
+	u32	_ramSize;
 
 	u32	_type;
 	u32	_size;
 	u32	_sign;
+	
+	size_t	_threadCount;
+	
+	u32 _runSearch(CheatSearchCompare compare, u32 valueA, u32 valueB, bool updateMem);
 
 public:
 	CHEATSEARCH()
-			: _statMem(0), _mem(0), _amount(0), _lastRecord(0), _type(0), _size(0), _sign(0) 
+			: _statMem(0), _mem(0), _amount(0), _lastRecord(0), _ramSize(0), _type(0), _size(0), _sign(0), _threadCount(0)
 	{}
 	~CHEATSEARCH() { this->close(); }
 	bool start(u8 type, u8 size, u8 sign);
 	void close();
 	u32 search(u32 val);
 	u32 search(u8 comp);
+	u32 searchRange(u32 minVal, u32 maxVal);
+	u32 searchDelta(u32 delta);
 	u32 getAmount();
 	bool getList(u32 *address, u32 *curVal);
 	void getListReset();
@@ -198,6 +219,20 @@ typedef struct FAT_R4
 } FAT_R4;
 #pragma pack(pop)
 
+// An entry of the index that CheatDBFile keeps next to an R4 cheat database, so that a game
+// can be looked up with a binary search instead of walking the whole FAT. The entries are
+// sorted by serial, then CRC, and the CRC is stored big endian so that it compares with memcmp().
+#pragma pack(push)
+#pragma pack(1)
+typedef struct CheatDBIndexEntry
+{
+	u8  serial[4];
+	u8  crcKey[4];
+	u32 addr;
+	u32 dataSize;
+} CheatDBIndexEntry;
+#pragma pack(pop)
+
 // Wrapper for a single entry in a memory block that contains data read from a cheat database file.
 // This struct also maintains the hierarchical relationships between entries.
 struct CheatDBEntry
@@ -280,7 +315,17 @@ protected:
 	
 	FILE *_fp;
 	
-	CheatDBGame _ReadGame(const u32 encryptOffset, const FAT_R4 &fat, const u32 gameDataSize, u8 (&workingBuffer)[1024]);
+	void *_indexFile;
+	const CheatDBIndexEntry *_index;
+	u32 _indexCount;
+	bool _indexChecked;
+	
+	CheatDBGame _ReadGame(const CheatDBIndexEntry &entry, u8 (&workingBuffer)[1024]);
+	void _ReadFAT(std::vector<CheatDBIndexEntry> &outList);
+	bool _MapIndex(const std::string &indexPath, const u64 sourceSize, const u64 sourceTime);
+	bool _OpenIndex();
+	void _CloseIndex();
+	bool _FindGame(const char *gameCode, const u32 gameDatabaseCRC, CheatDBIndexEntry &outEntry);
 	
 public:
 	CheatDBFile();
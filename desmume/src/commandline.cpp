@@ -49,6 +49,14 @@ static std::string strtoupper(const std::string& str)
 static const char* help_string = \
 "Arguments affecting overall emulator behaviour: (`user settings`):" ENDL
 " --num-cores N              Override numcores detection and use this many" ENDL
+" --task-threads N           Threads in the shared task pool; default num-cores" ENDL
+" --task-group-limit GROUP:N[:MASK]" ENDL
+"                            Let GROUP (rasterizer, gpu, videofilter," ENDL
+"                            cheatsearch) use at most N pool threads at once," ENDL
+"                            and only the pool threads set in the hex MASK" ENDL
+" --gpu-async-sub-engine     Render the sub 2D engine on its own thread" ENDL
+" --gpu-deferred-2d          Render 2D lines in one batch at the end of each frame" ENDL
+" --gpu-line-reuse           Reuse 2D lines that are unchanged since the last frame" ENDL
 " --spu-synch                Use SPU synch (crackles; helps streams; default ON)" ENDL
 " --spu-method N             Select SPU synch method: 0:N, 1:Z, 2:P; default 0" ENDL
 " --3d-render [SW|AUTOGL|GL|OLDGL]" ENDL
@@ -78,11 +86,15 @@ static const char* help_string = \
 " --rtc-day D                Override RTC day, 0=Sunday, 6=Saturday" ENDL
 " --rtc-hour H               Override RTC hour, 0=midnight, 23=an hour before" ENDL
 " --frameskip N              Set frameskip to N; default 0" ENDL
+" --rewind N                 Keep about a minute of rewind history, taking a" ENDL
+"                            snapshot every N frames; default 0 (off)" ENDL
+" --rewind-buffer MB         Memory cap for the rewind history; default 128" ENDL
 ENDL
 "Arguments affecting overall emulation parameters (`sync settings`): " ENDL
 #ifdef HAVE_JIT
 " --jit-enable               Formerly --cpu-mode; default OFF" ENDL
 " --jit-size N               JIT block size 1-100; 1:accurate 100:fast (default)" ENDL
+" --jit-cache-size N         JIT code cache size in MB 1-32; default 32" ENDL
 #endif
 " --advanced-timing          Use advanced bus-level timing; default ON" ENDL
 " --rigorous-timing          Use more realistic component timings; default OFF" ENDL
@@ -119,6 +131,9 @@ ENDL
 " --load-slot N              loads savestate from slot N (0-9)" ENDL
 " --play-movie DSM_FILE      automatically plays movie" ENDL
 " --record-movie DSM_FILE    begin recording a movie" ENDL
+" --benchmark N              run N frames headless as fast as possible, print" ENDL
+"                            the timings as JSON and exit" ENDL
+" --benchmark-output FILE    write the benchmark JSON to FILE; default stdout" ENDL
 ENDL
 "Arguments affecting video filters:" ENDL
 " --scanline-filter-a N      Fadeout intensity (N/16) (topleft) (default 0)" ENDL
@@ -147,7 +162,12 @@ ENDL
 #define OPT_GPU_RESOLUTION_MULTIPLIER 82
 #define OPT_FRAMESKIP 83
 #define OPT_SCALE 84
+#define OPT_REWIND 85
+#define OPT_REWIND_BUFFER 86
+#define OPT_TASK_THREADS 87
+#define OPT_TASK_GROUP_LIMIT 88
 #define OPT_JIT_SIZE 100
+#define OPT_JIT_CACHE_SIZE 101
 
 #define OPT_CONSOLE_TYPE 200
 #define OPT_ARM9 201
@@ -162,6 +182,8 @@ ENDL
 #define OPT_LOAD_SLOT 400
 #define OPT_PLAY_MOVIE 410
 #define OPT_RECORD_MOVIE 411
+#define OPT_BENCHMARK 420
+#define OPT_BENCHMARK_OUTPUT 421
 
 #define OPT_SLOT2_CFLASH_IMAGE 500
 #define OPT_SLOT2_CFLASH_DIR 501
@@ -197,6 +219,12 @@ CommandLine::CommandLine()
 	_bios_swi                 = 0;
 	_spu_advanced             = 0;
 	_num_cores                = -1;
+	_task_threads             = -1;
+	_gpu_async_sub_engine     = 0;
+	_gpu_deferred_2d          = 0;
+	_gpu_line_reuse           = 0;
+	_rewind_interval          = -1;
+	_rewind_buffer_size       = -1;
 	_rigorous_timing          = 0;
 	_advanced_timing          = -1;
 	_gamehacks                = -1;
@@ -205,6 +233,7 @@ CommandLine::CommandLine()
 #ifdef HAVE_JIT
 	_cpu_mode                 = -1;
 	_jit_size                 = -1;
+	_jit_cache_size           = -1;
 #endif
 	_slot1                   = NULL;
 	_slot1_fat_dir           = NULL;
@@ -224,6 +253,8 @@ CommandLine::CommandLine()
 	nds_file                  = "";
 	play_movie_file           = "";
 	record_movie_file         = "";
+	benchmark_frames          = 0;
+	benchmark_output          = "";
 	arm9_gdb_port             = 0;
 	arm7_gdb_port             = 0;
 	start_paused              = 0;
@@ -264,6 +295,11 @@ bool CommandLine::parse(int argc,char **argv)
 
 			//user settings
 			{ "num-cores", required_argument, NULL, OPT_NUMCORES },
+			{ "task-threads", required_argument, NULL, OPT_TASK_THREADS },
+			{ "task-group-limit", required_argument, NULL, OPT_TASK_GROUP_LIMIT },
+			{ "gpu-async-sub-engine", no_argument, &_gpu_async_sub_engine, 1},
+			{ "gpu-deferred-2d", no_argument, &_gpu_deferred_2d, 1},
+			{ "gpu-line-reuse", no_argument, &_gpu_line_reuse, 1},
 			{ "spu-synch", no_argument, &_spu_sync_mode, 1 },
 			{ "spu-method", required_argument, NULL, OPT_SPU_METHOD },
 			{ "3d-render", required_argument, NULL, OPT_3D_RENDER },
@@ -279,6 +315,8 @@ bool CommandLine::parse(int argc,char **argv)
 				{ "scale", required_argument, NULL, OPT_SCALE},
 			#endif
 			{ "frameskip", required_argument, NULL, OPT_FRAMESKIP},
+			{ "rewind", required_argument, NULL, OPT_REWIND},
+			{ "rewind-buffer", required_argument, NULL, OPT_REWIND_BUFFER},
 			{ "disable-sound", no_argument, &disable_sound, 1},
 			{ "disable-limiter", no_argument, &disable_limiter, 1},
 			{ "rtc-day", required_argument, NULL, OPT_RTC_DAY},
@@ -288,6 +326,7 @@ bool CommandLine::parse(int argc,char **argv)
 			#ifdef HAVE_JIT
 				{ "jit-enable", no_argument, &_cpu_mode, 1},
 				{ "jit-size", required_argument, NULL, OPT_JIT_SIZE },
+				{ "jit-cache-size", required_argument, NULL, OPT_JIT_CACHE_SIZE },
 			#endif
 			{ "rigorous-timing", no_argument, &_rigorous_timing, 1},
 			{ "advanced-timing", no_argument, &_advanced_timing, 1},
@@ -321,6 +360,8 @@ bool CommandLine::parse(int argc,char **argv)
 			{ "load-slot", required_argument, NULL, OPT_LOAD_SLOT},
 			{ "play-movie", required_argument, NULL, OPT_PLAY_MOVIE},
 			{ "record-movie", required_argument, NULL, OPT_RECORD_MOVIE},
+			{ "benchmark", required_argument, NULL, OPT_BENCHMARK},
+			{ "benchmark-output", required_argument, NULL, OPT_BENCHMARK_OUTPUT},
 
 			//video filters
 			{ "scanline-filter-a", required_argument, NULL, OPT_SCANLINES_A},
@@ -351,12 +392,33 @@ bool CommandLine::parse(int argc,char **argv)
 
 		//user settings
 		case OPT_NUMCORES: _num_cores = atoi(optarg); break;
+		case OPT_TASK_THREADS: _task_threads = atoi(optarg); break;
+		case OPT_TASK_GROUP_LIMIT:
+		{
+			char groupName[32];
+			unsigned int maxThreads = 0;
+			unsigned int threadMask = 0;
+			if (sscanf(optarg, "%31[^:]:%u:%x", groupName, &maxThreads, &threadMask) >= 2)
+			{
+				const TaskGroup group = TaskPool_GroupFromName(groupName);
+				if (group != TaskGroupCount)
+				{
+					CommonSettings.task_group_limit[group].maxThreads = maxThreads;
+					CommonSettings.task_group_limit[group].threadMask = threadMask;
+					break;
+				}
+			}
+			printf("Invalid task group limit: %s\n", optarg);
+			break;
+		}
 		case OPT_SPU_METHOD: _spu_sync_method = atoi(optarg); break;
 		case OPT_3D_RENDER: _render3d = optarg; break;
 		case OPT_3D_TEXTURE_UPSCALE: texture_upscale = atoi(optarg); break;
 		case OPT_GPU_RESOLUTION_MULTIPLIER: gpu_resolution_multiplier = atoi(optarg); break;
 		case OPT_SCALE: scale = atof(optarg); break;
 		case OPT_FRAMESKIP: frameskip = atoi(optarg); break;
+		case OPT_REWIND: _rewind_interval = atoi(optarg); break;
+		case OPT_REWIND_BUFFER: _rewind_buffer_size = atoi(optarg); break;
 
 		//RTC settings
 		case OPT_RTC_DAY: _rtc_day = atoi(optarg); break;
@@ -365,6 +427,7 @@ bool CommandLine::parse(int argc,char **argv)
 		//sync settings
 		#ifdef HAVE_JIT
 		case OPT_JIT_SIZE: _jit_size = atoi(optarg); break;
+		case OPT_JIT_CACHE_SIZE: _jit_cache_size = atoi(optarg); break;
 		#endif
 
 		//system equipment
@@ -387,6 +450,8 @@ bool CommandLine::parse(int argc,char **argv)
 		case OPT_LOAD_SLOT: load_slot = atoi(optarg);  break;
 		case OPT_PLAY_MOVIE: play_movie_file = optarg; break;
 		case OPT_RECORD_MOVIE: record_movie_file = optarg; break;
+		case OPT_BENCHMARK: benchmark_frames = atoi(optarg); break;
+		case OPT_BENCHMARK_OUTPUT: benchmark_output = optarg; break;
 
 		//video filters
 		case OPT_SCANLINES_A: _scanline_filter_a = atoi(optarg); break;
@@ -412,6 +477,12 @@ bool CommandLine::parse(int argc,char **argv)
 
 	if(_load_to_memory != -1) CommonSettings.loadToMemory = (_load_to_memory == 1)?true:false;
 	if(_num_cores != -1) CommonSettings.num_cores = _num_cores;
+	if(_task_threads != -1) CommonSettings.task_pool_threads = _task_threads;
+	if(_gpu_async_sub_engine) CommonSettings.gpu_async_sub_engine = true;
+	if(_gpu_deferred_2d) CommonSettings.gpu_deferred_2d = true;
+	if(_gpu_line_reuse) CommonSettings.gpu_line_reuse = true;
+	if(_rewind_interval > 0) CommonSettings.rewind_interval = _rewind_interval;
+	if(_rewind_buffer_size > 0) CommonSettings.rewind_buffer_size = _rewind_buffer_size;
 	if(_rigorous_timing) CommonSettings.rigorous_timing = true;
 	if(_advanced_timing != -1) CommonSettings.advanced_timing = _advanced_timing==1;
 	if(_gamehacks != -1) CommonSettings.gamehacks.en = _gamehacks==1;
@@ -425,6 +496,13 @@ bool CommandLine::parse(int argc,char **argv)
 		else
 			CommonSettings.jit_max_block_size = _jit_size;
 	}
+	if(_jit_cache_size != -1)
+	{
+		if ((_jit_cache_size < 1) || (_jit_cache_size > 32))
+			CommonSettings.jit_cache_size = 32;
+		else
+			CommonSettings.jit_cache_size = _jit_cache_size;
+	}
 #endif
 
 	//process console type
@@ -522,6 +600,11 @@ bool CommandLine::validate()
 		return false;
 	}
 
+	if(benchmark_frames < 0) {
+		printerror("Benchmark frame count must be >= 0.\n");
+		return false;
+	}
+
 	if(cflash_path != "" && cflash_image != "") {
 		printerror("Cannot specify both cflash-image and cflash-path.\n");
 		return false;
@@ -565,6 +648,9 @@ bool CommandLine::validate()
 	if (_jit_size < -1 && (_jit_size == 0 || _jit_size > 100)) {
 		printerror("Invalid jit block size [1..100]. set to 100\n");
 	}
+	if (_jit_cache_size < -1 || _jit_cache_size == 0 || _jit_cache_size > 32) {
+		printerror("Invalid jit code cache size [1..32]. set to 32\n");
+	}
 #endif
         if (_rtc_day < -1 || _rtc_day > 6) {
                 printerror("Invalid rtc day override, valid values are from 0 to 6");
@@ -55,6 +55,12 @@ private:
 	int _bios_swi;
 	int _spu_advanced;
 	int _num_cores;
+	int _task_threads;
+	int _gpu_async_sub_engine;
+	int _gpu_deferred_2d;
+	int _gpu_line_reuse;
+	int _rewind_interval;
+	int _rewind_buffer_size;
 	int _rigorous_timing;
 	int _advanced_timing;
 	int _gamehacks;
@@ -63,6 +69,7 @@ private:
 #ifdef HAVE_JIT
 	int _cpu_mode;
 	int _jit_size;
+	int _jit_cache_size;
 #endif
 	char *_slot1;
 	char *_slot1_fat_dir;
@@ -83,6 +90,8 @@ public:
 	std::string nds_file;
 	std::string play_movie_file;
 	std::string record_movie_file;
+	int benchmark_frames;
+	std::string benchmark_output;
 	int arm9_gdb_port;
 	int arm7_gdb_port;
 	int start_paused;
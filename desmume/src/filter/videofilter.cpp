@@ -188,9 +188,7 @@ void VideoFilter::__InstanceInit(size_t srcWidth, size_t srcHeight, VideoFilterT
 		__vfThread[i].param.filterFunction = NULL;
 		
 		__vfThread[i].task = new Task;
-		char name[16];
-		snprintf(name, 16, "video filter %d", (int)i);
-		__vfThread[i].task->start(false, 0, name);
+		__vfThread[i].task->start(TaskGroup_VideoFilter, false);
 	}
 	
 	__vfFunc = _vfAttributes.filterFunction;
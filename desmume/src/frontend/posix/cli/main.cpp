@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <glib.h>
+#include <algorithm>
+#include <vector>
 
 #ifndef VERSION
 #define VERSION "Unknown version"
@@ -42,6 +44,8 @@
 #include "../render3D.h"
 #include "../rasterize.h"
 #include "../saves.h"
+#include "../rewind.h"
+#include "../movie.h"
 #include "../frontend/modules/osd/agg/agg_osd.h"
 #include "../shared/desmume_config.h"
 #include "../commandline.h"
@@ -328,10 +332,130 @@ static void desmume_cycle(struct ctrls_event_config * cfg)
       }
 
     update_keypad(cfg->keypad);     /* Update keypad */
-    NDS_exec<false>();
+    if (cfg->rewind && Rewind_Step()) {
+      /* run one frame from the restored state so there is something to show; it isn't recorded */
+      NDS_exec<false>();
+    } else {
+      NDS_exec<false>();
+      Rewind_Push();
+    }
     SPU_Emulate_user();
 }
 
+static void json_write_string(FILE *fp, const char *str) {
+  fputc('"', fp);
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\')
+      fprintf(fp, "\\%c", *str);
+    else if ((unsigned char)*str < 0x20)
+      fprintf(fp, "\\u%04x", (unsigned char)*str);
+    else
+      fputc(*str, fp);
+  }
+  fputc('"', fp);
+}
+
+/* nearest-rank percentile of an already sorted list */
+static double percentile_ms(const std::vector<u64> &sorted_ns, double p) {
+  size_t rank = (size_t)(p / 100.0 * sorted_ns.size() + 0.999999);
+  rank = std::min(std::max<size_t>(rank, 1), sorted_ns.size());
+  return sorted_ns[rank - 1] / 1e6;
+}
+
+/*
+ * Headless benchmark: runs a fixed number of frames as fast as possible, without a window,
+ * an audio device or the frame limiter, and reports the timings as JSON.
+ */
+static int run_benchmark(class configured_features *cfg) {
+  const size_t frames = cfg->benchmark_frames;
+  const double ns_per_tick = 1e9 / SDL_GetPerformanceFrequency();
+  std::vector<u64> frame_ns(frames);
+  u64 section_ns[NDSPerfSection_Count];
+  u64 total_ns = 0;
+
+  cfg->process_movieCommands();
+  if (cfg->load_slot != -1) {
+    loadstate_slot(cfg->load_slot);
+  }
+
+  NDS_PerfEnable(true);
+  GPU->GetEngineMain()->ResetLineReuseStats();
+  GPU->GetEngineSub()->ResetLineReuseStats();
+
+  for (size_t i = 0; i < frames; i++) {
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    NDS_beginProcessingInput();
+    FCEUMOV_AddInputState();
+    NDS_endProcessingInput();
+
+    NDS_exec<false>();
+    {
+      NDSPerfScope perfScope(NDSPerfSection_SPU);
+      SPU_Emulate_user();
+    }
+
+    frame_ns[i] = (u64)((SDL_GetPerformanceCounter() - start) * ns_per_tick);
+    total_ns += frame_ns[i];
+  }
+
+  NDS_PerfGetTimes(section_ns);
+  NDS_PerfEnable(false);
+
+  u64 reuse_checked[2], reuse_hits[2];
+  GPU->GetEngineMain()->GetLineReuseStats(reuse_checked[0], reuse_hits[0]);
+  GPU->GetEngineSub()->GetLineReuseStats(reuse_checked[1], reuse_hits[1]);
+
+  FILE *fp = stdout;
+  if (cfg->benchmark_output != "") {
+    fp = fopen(cfg->benchmark_output.c_str(), "w");
+    if (fp == NULL) {
+      fprintf(stderr, "Could not open %s for writing\n", cfg->benchmark_output.c_str());
+      return 1;
+    }
+  }
+
+  const double seconds = total_ns / 1e9;
+  u64 other_ns = total_ns;
+  for (int i = 0; i < NDSPerfSection_Count; i++)
+    other_ns -= std::min(other_ns, section_ns[i]);
+  std::sort(frame_ns.begin(), frame_ns.end());
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"rom\": ");
+  json_write_string(fp, cfg->nds_file.c_str());
+  fprintf(fp, ",\n");
+  fprintf(fp, "  \"frames\": %u,\n", (unsigned)frames);
+#ifdef HAVE_JIT
+  fprintf(fp, "  \"cpu_mode\": \"%s\",\n", CommonSettings.use_jit ? "jit" : "interpreter");
+#else
+  fprintf(fp, "  \"cpu_mode\": \"interpreter\",\n");
+#endif
+  fprintf(fp, "  \"engine_3d\": %d,\n", cfg->engine_3d);
+  fprintf(fp, "  \"num_cores\": %d,\n", CommonSettings.num_cores);
+  fprintf(fp, "  \"seconds\": %.6f,\n", seconds);
+  fprintf(fp, "  \"fps\": %.3f,\n", seconds > 0 ? frames / seconds : 0.0);
+  if (frames > 0) {
+    fprintf(fp, "  \"frame_time_ms\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            total_ns / 1e6 / frames, frame_ns.front() / 1e6, percentile_ms(frame_ns, 50), percentile_ms(frame_ns, 90),
+            percentile_ms(frame_ns, 95), percentile_ms(frame_ns, 99), frame_ns.back() / 1e6);
+  }
+  fprintf(fp, "  \"section_time_ms\": { \"cpu\": %.3f, \"gpu_2d\": %.3f, \"gpu_3d\": %.3f, \"spu\": %.3f, \"other\": %.3f },\n",
+          section_ns[NDSPerfSection_CPU] / 1e6, section_ns[NDSPerfSection_2D] / 1e6, section_ns[NDSPerfSection_3D] / 1e6,
+          section_ns[NDSPerfSection_SPU] / 1e6, other_ns / 1e6);
+  fprintf(fp, "  \"line_reuse\": { \"enabled\": %s, \"main_checked\": %llu, \"main_reused\": %llu, \"sub_checked\": %llu, \"sub_reused\": %llu, \"hit_rate\": %.4f }\n",
+          CommonSettings.gpu_line_reuse ? "true" : "false",
+          (unsigned long long)reuse_checked[0], (unsigned long long)reuse_hits[0],
+          (unsigned long long)reuse_checked[1], (unsigned long long)reuse_hits[1],
+          (reuse_checked[0] + reuse_checked[1]) > 0 ? (double)(reuse_hits[0] + reuse_hits[1]) / (reuse_checked[0] + reuse_checked[1]) : 0.0);
+  fprintf(fp, "}\n");
+
+  if (fp != stdout)
+    fclose(fp);
+
+  return 0;
+}
+
 #ifdef GDB_STUB
 static gdbstub_handle_t setup_gdb_stub(u16 port, armcpu_t *cpu, const armcpu_memory_iface *memio, const char* desc) {
 	gdbstub_handle_t stub = createStub_gdb(port, cpu, memio);
@@ -469,7 +593,8 @@ int main(int argc, char ** argv) {
 #endif
 
   if ( !my_config.disable_sound) {
-    SPU_ChangeSoundCore(SNDCORE_SDL, 735 * 4);
+    /* the benchmark still mixes sound, it just doesn't need anywhere to play it */
+    SPU_ChangeSoundCore(my_config.benchmark_frames ? SNDCORE_DUMMY : SNDCORE_SDL, 735 * 4);
   }
 
   if (!GPU->Change3DRendererByID(my_config.engine_3d)) {
@@ -487,6 +612,18 @@ int main(int argc, char ** argv) {
 
   execute = true;
 
+  if (my_config.benchmark_frames) {
+    error = run_benchmark(&my_config);
+#ifdef GDB_STUB
+    destroyStub_gdb( stubs[0]);
+    destroyStub_gdb( stubs[1]);
+
+    gdbstub_mutex_destroy();
+#endif
+    NDS_DeInit();
+    return error;
+  }
+
   /* X11 multi-threading support */
   if(!XInitThreads())
     {
@@ -550,6 +687,7 @@ int main(int argc, char ** argv) {
   ctrls_cfg.auto_pause = my_config.auto_pause;
   ctrls_cfg.focused = 1;
   ctrls_cfg.fake_mic = 0;
+  ctrls_cfg.rewind = 0;
   ctrls_cfg.keypad = 0;
   ctrls_cfg.screen_texture = NULL;
   ctrls_cfg.resize_cb = &resizeWindow_stub;
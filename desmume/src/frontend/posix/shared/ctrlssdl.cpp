@@ -839,6 +839,9 @@ process_ctrls_event( SDL_Event& event,
         }
 
         key = lookup_key(event.key.keysym.sym);
+        /* R steps back through the rewind history while held, unless it is bound to a DS key */
+        if (event.key.keysym.sym == SDLK_r && !key)
+            cfg->rewind = 1;
         ADD_KEY( cfg->keypad, key );
         break;
 
@@ -890,6 +893,8 @@ process_ctrls_event( SDL_Event& event,
                 break;
             default:
                 key = lookup_key(event.key.keysym.sym);
+                if (event.key.keysym.sym == SDLK_r)
+                    cfg->rewind = 0;
                 RM_KEY( cfg->keypad, key );
                 break;
         }
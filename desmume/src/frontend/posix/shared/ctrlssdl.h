@@ -102,6 +102,7 @@ struct ctrls_event_config {
   int focused;
   int sdl_quit;
   int fake_mic;
+  int rewind;
   void *screen_texture;
   void (*resize_cb)(u16 width, u16 height, void *screen_texture);
   SDL_Window *window;
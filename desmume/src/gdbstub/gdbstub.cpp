@@ -389,9 +389,8 @@ step_instruction_watch( void *data, uint32_t addr, UNUSED_PARM(int thunmb)) {
 
 
 /************************************************************************/
-/* BUFMAX defines the maximum number of characters in inbound/outbound buffers*/
+/* BUFMAX_GDB defines the maximum number of characters in inbound/outbound buffers*/
 /* at least NUMREGBYTES*2 are needed for register packets */
-#define BUFMAX 2048
 
 
 
@@ -454,23 +453,17 @@ hexToInt( const uint8_t **ptr, uint32_t *intValue)
 }
 
 /* Convert the memory pointed to by mem into hex, placing result in buf.
- * Return a pointer to the last char put in buf (null), in case of mem fault,
- * return 0.
- * If MAY_FAULT is non-zero, then we will handle memory faults by returning
- * a 0, else treat a fault like any other fault in the stub.
+ * Return a pointer to the last char put in buf (null).
  */
 
 static uint8_t *
-mem2hex ( armcpu_memory_iface *memio, uint32_t mem_addr,
-          uint8_t *buf, int count)
+mem2hex ( const uint8_t *mem, uint8_t *buf, int count)
 {
   uint8_t ch;
 
-  //set_mem_fault_trap(may_fault);
-
   while (count-- > 0)
     {
-      ch = memio->read8( memio->data, mem_addr++);
+      ch = *mem++;
       *buf++ = hexchars[ch >> 4];
       *buf++ = hexchars[ch & 0xf];
     }
@@ -481,16 +474,113 @@ mem2hex ( armcpu_memory_iface *memio, uint32_t mem_addr,
 }
 
 
+/**
+ * Receive whatever the socket has ready into the free part of the receive ring.
+ * Returns the result of the recv call.
+ */
+static int
+fillRxRing_gdb( struct gdb_stub_state *stub) {
+  uint32_t used = stub->rx_head - stub->rx_tail;
+  uint32_t offset = stub->rx_head & (RXBUF_GDB - 1);
+  uint32_t space = RXBUF_GDB - offset;
+  int sock_res;
+
+  if ( space > RXBUF_GDB - used)
+    space = RXBUF_GDB - used;
+
+  sock_res = recv( stub->sock_fd, (char*)&stub->rx_ring[offset], space, 0);
+
+  if ( sock_res > 0) {
+    stub->rx_head += sock_res;
+  }
+
+  return sock_res;
+}
+
+/**
+ * Get the next received byte, waiting for the socket if the ring is empty.
+ * Returns -1 if there is a socket error.
+ */
+static int
+getRxByte_gdb( struct gdb_stub_state *stub) {
+  while ( stub->rx_head == stub->rx_tail) {
+    int sock_res = fillRxRing_gdb( stub);
+
+    if ( sock_res == 0) {
+      return -1;
+    }
+    else if ( sock_res == -1) {
+      if ( errno != EAGAIN) {
+        return -1;
+      }
+    }
+  }
+
+  return stub->rx_ring[stub->rx_tail++ & (RXBUF_GDB - 1)];
+}
+
+/**
+ * Send len bytes, coping with the socket taking them in several goes.
+ * Returns -1 if there is a socket error.
+ */
+static int
+sendAll_gdb( SOCKET_TYPE sock, const uint8_t *buf, uint32_t len) {
+  while ( len > 0) {
+    int sock_res = send( sock, (const char*)buf, len, 0);
+
+    if ( sock_res <= 0) {
+      if ( sock_res == -1 && errno == EAGAIN) {
+        continue;
+      }
+      return -1;
+    }
+    buf += sock_res;
+    len -= sock_res;
+  }
+
+  return 0;
+}
+
+/**
+ * Send everything queued in the transmit buffer.
+ * Returns -1 if there is a socket error.
+ */
+static int
+flushTx_gdb( struct gdb_stub_state *stub) {
+  int res = sendAll_gdb( stub->sock_fd, stub->tx_buffer, stub->tx_size);
+
+  stub->tx_size = 0;
+  return res;
+}
+
 
+/**
+ * Run the received bytes through the packet state machine.
+ * The socket is only read if the ring is empty and fill_ring is set, so that
+ * bytes left over from an earlier read can be handled without blocking.
+ */
 static enum read_res_gdb
-readPacket_gdb( SOCKET_TYPE sock, struct packet_reader_gdb *packet) {
+readPacket_gdb( struct gdb_stub_state *stub, int fill_ring) {
+  struct packet_reader_gdb *packet = &stub->rx_packet;
   uint8_t cur_byte;
   enum read_res_gdb read_res = READ_NOT_FINISHED;
-  int sock_res;
+  int sock_res = 1;
 
   /* update the state */
 
-  while ( (sock_res = recv( sock, (char*)&cur_byte, 1, 0)) == 1) {
+  for (;;) {
+    if ( stub->rx_head == stub->rx_tail) {
+      if ( !fill_ring)
+        break;
+      fill_ring = 0;
+
+      sock_res = fillRxRing_gdb( stub);
+      if ( sock_res <= 0)
+        break;
+    }
+
+    cur_byte = stub->rx_ring[stub->rx_tail++ & (RXBUF_GDB - 1)];
+
     switch ( packet->state) {
     case IDLE_READ_STATE:
       /* wait for the '$' start of packet character
@@ -517,7 +607,7 @@ readPacket_gdb( SOCKET_TYPE sock, struct packet_reader_gdb *packet) {
 	DEBUG_LOG( "\nAbout to get checksum for %s\n", packet->buffer);
 	packet->state = FIRST_CHECKSUM_READ_STATE;
       }
-      else if ( packet->pos_index >= BUFMAX - 1) {
+      else if ( packet->pos_index >= BUFMAX_GDB - 1) {
 	//DEBUG_LOG( "read buffer exceeded\n");
 	packet->state = IDLE_READ_STATE;
       }
@@ -556,21 +646,20 @@ readPacket_gdb( SOCKET_TYPE sock, struct packet_reader_gdb *packet) {
 }
 
 
-struct hidden_debug_out_packet {
-  unsigned char *start_ptr;
-};
 struct debug_out_packet {
-  unsigned char *const start_ptr;
+  unsigned char *start_ptr;
 };
 
-static struct hidden_debug_out_packet the_out_packet;
-static unsigned char hidden_buffer[BUFMAX];
-
 
-static struct debug_out_packet *
-getOutPacket( void) {
-  the_out_packet.start_ptr = &hidden_buffer[1];
-  return (struct debug_out_packet *)&the_out_packet;
+/**
+ * The reply is built in place in the transmit buffer, after anything that is
+ * already queued there (such as the acknowledgement of the packet being answered).
+ */
+static struct debug_out_packet
+getOutPacket( struct gdb_stub_state *stub) {
+  struct debug_out_packet out_packet;
+  out_packet.start_ptr = &stub->tx_buffer[stub->tx_size + 1];
+  return out_packet;
 }
 
 #define CHECKSUM_PART_SIZE 3
@@ -578,11 +667,12 @@ getOutPacket( void) {
  * send the packet in buffer.
  */
 static int
-putpacket ( SOCKET_TYPE sock, struct debug_out_packet *out_packet, uint32_t size) {
+putpacket ( struct gdb_stub_state *stub, struct debug_out_packet *out_packet, uint32_t size) {
   unsigned char checksum = 0;
   uint32_t count;
   unsigned char *ch_ptr = (unsigned char *)&out_packet->start_ptr[-1];
-  uint8_t reply_ch;
+  unsigned char *packet_start = ch_ptr;
+  int reply_ch;
 
   //DEBUG_LOG_START( "Putting packet size %d ", size);
   /* add the '$' to the start of the packet */
@@ -604,27 +694,26 @@ putpacket ( SOCKET_TYPE sock, struct debug_out_packet *out_packet, uint32_t size
   /* add one for the '$' character */
   count += 1;
 
-  do {
-    int reply_found = 0;
+  /* the first attempt goes out together with whatever was queued in front of it */
+  stub->tx_size += count;
+  if ( flushTx_gdb( stub) == -1) {
+    return -1;
+  }
 
-    send( sock, (char*)&out_packet->start_ptr[-1], count, 0);
+  while ( !stub->no_ack_mode) {
+    reply_ch = getRxByte_gdb( stub);
 
-    do {
-      int read_res = recv( sock, (char*)&reply_ch, 1, 0);
+    if ( reply_ch == -1) {
+      return -1;
+    }
+    if ( reply_ch == '+') {
+      break;
+    }
 
-      if ( read_res == 0) {
-	return -1;
-      }
-      else if ( read_res == -1) {
-	if ( errno != EAGAIN) {
-	  return -1;
-	}
-      }
-      else {
-	reply_found = 1;
-      }
-    } while ( !reply_found);
-  } while ( reply_ch != '+');
+    if ( sendAll_gdb( stub->sock_fd, packet_start, count) == -1) {
+      return -1;
+    }
+  }
 
   /*  $<packet info>#<checksum>. */
   return count - 4;
@@ -694,12 +783,13 @@ make_stop_packet( uint8_t *ptr, enum stop_type type, uint32_t stop_address) {
  * Returns -1 if there is a socket error.
  */
 static int
-processPacket_gdb( SOCKET_TYPE sock, const uint8_t *packet,
-		   struct gdb_stub_state *stub) {
-  //  uint8_t remcomOutBuffer[BUFMAX_GDB];
-  struct debug_out_packet *out_packet = getOutPacket();
-  uint8_t *out_ptr = out_packet->start_ptr;
+processPacket_gdb( const uint8_t *packet, struct gdb_stub_state *stub) {
+  struct debug_out_packet out_packet = getOutPacket( stub);
+  uint8_t *out_ptr = out_packet.start_ptr;
+  uint8_t proc_id = ((armcpu_t *)stub->arm_cpu_object)->proc_ID;
   int send_reply = 1;
+  int start_no_ack = 0;
+  int res;
   uint32_t send_size = 0;
 
   DEBUG_LOG("Processing packet %c\n", packet[0]);
@@ -716,6 +806,22 @@ processPacket_gdb( SOCKET_TYPE sock, const uint8_t *packet,
     send_reply = 0;
     break;
 
+  case 'q':
+    if ( strncmp( (const char *)&packet[1], "Supported", 9) == 0) {
+      send_size = sprintf( (char *)out_ptr, "PacketSize=%x;QStartNoAckMode+",
+                           BUFMAX_GDB - 1);
+    }
+    break;
+
+  case 'Q':
+    if ( strcmp( (const char *)&packet[1], "StartNoAckMode") == 0) {
+      /* the OK is still acknowledged, acks stop after that */
+      strcpy( (char *)out_ptr, "OK");
+      send_size = 2;
+      start_no_ack = 1;
+    }
+    break;
+
   case '?':
     send_size = make_stop_packet( out_ptr, stub->stop_type, stub->stop_address);
     /**ptr++ = 'S';
@@ -800,20 +906,24 @@ processPacket_gdb( SOCKET_TYPE sock, const uint8_t *packet,
     if ( hexToInt( &rx_ptr, &addr)) {
       if ( *rx_ptr++ == ',') {
         if ( hexToInt( &rx_ptr, &length)) {
+          uint8_t mem_block[BUFMAX_GDB / 2];
+
+          /* a short reply is allowed, GDB asks again for the rest */
+          if ( length > sizeof( mem_block) - 1)
+            length = sizeof( mem_block) - 1;
+
           //DEBUG_LOG("mem read from %08x (%d)\n", addr, length);
-          if ( !mem2hex( stub->direct_memio, addr, out_ptr, length)) {
-            strcpy ( (char *)out_ptr, "E03");
-            send_size = 3;
-          }
-          else {
-            send_size = length * 2;
-          }
+          MMU_DumpMemBlock( proc_id, addr, length, mem_block);
+          mem2hex( mem_block, out_ptr, length);
+          send_size = length * 2;
           error01 = 0;
         }
       }
     }
-    if ( error01)
+    if ( error01) {
       strcpy( (char *)out_ptr,"E01");
+      send_size = 3;
+    }
     break;
   }
 
@@ -828,20 +938,16 @@ processPacket_gdb( SOCKET_TYPE sock, const uint8_t *packet,
     if ( hexToInt(&rx_ptr, &addr)) {
       if ( *rx_ptr++ == ',') {
         if ( hexToInt(&rx_ptr, &length)) {
-          if ( *rx_ptr++ == ':') {
-            uint8_t write_byte;
-            unsigned int i;
+          if ( *rx_ptr++ == ':' && length <= strlen( (const char *)rx_ptr) / 2) {
+            uint8_t mem_block[BUFMAX_GDB / 2];
             DEBUG_LOG("Memory write of %d bytes to %08x\n",
                       length, addr);
 
-            for ( i = 0; i < length; i++) {
-              rx_ptr = hex2mem( rx_ptr, &write_byte, 1);
-
-              stub->direct_memio->write8( stub->direct_memio->data,
-                                         addr++, write_byte);
-            }
+            hex2mem( rx_ptr, mem_block, length);
+            MMU_LoadMemBlock( proc_id, addr, length, mem_block);
 
             strcpy( (char *)out_ptr, "OK");
+            send_size = 2;
             error01 = 0;
           }
         }
@@ -859,6 +965,7 @@ processPacket_gdb( SOCKET_TYPE sock, const uint8_t *packet,
 
     if ( error01) {
       strcpy( (char *)out_ptr, "E02");
+      send_size = 3;
     }
     break;
   }
@@ -1081,10 +1188,17 @@ processPacket_gdb( SOCKET_TYPE sock, const uint8_t *packet,
   gdbstub_mutex_unlock();
 
   if ( send_reply) {
-    return putpacket( sock, out_packet, send_size);
+    res = putpacket( stub, &out_packet, send_size);
+  }
+  else {
+    res = flushTx_gdb( stub);
   }
 
-  return 0;
+  if ( start_no_ack) {
+    stub->no_ack_mode = 1;
+  }
+
+  return res;
 }
 
 
@@ -1210,8 +1324,8 @@ WINAPI listenerThread_gdb( void *data) {
 	case CPU_STOPPED_STUB_MESSAGE:
 	  if ( state->active &&
 		  state->ctl_stub_state != gdb_stub_state::STOPPED_GDB_STATE) {
-	    struct debug_out_packet *out_packet = getOutPacket();
-	    uint8_t *ptr = out_packet->start_ptr;
+	    struct debug_out_packet out_packet = getOutPacket( state);
+	    uint8_t *ptr = out_packet.start_ptr;
             uint32_t send_size;
 
 	    /* mark the stub as stopped and send the stop packet */
@@ -1224,7 +1338,9 @@ WINAPI listenerThread_gdb( void *data) {
 	    ptr[1] = hexchars[state->stop_reason >> 4];
 	    ptr[2] = hexchars[state->stop_reason & 0xf];*/
 
-	    putpacket( state->sock_fd, out_packet, send_size);
+	    if ( state->sock_fd != -1) {
+	      putpacket( state, &out_packet, send_size);
+	    }
 	    DEBUG_LOG( "\nBreak from Emulation\n");
 	  }
 	  else {
@@ -1275,6 +1391,10 @@ WINAPI listenerThread_gdb( void *data) {
 
               FD_SET( new_conn, &main_set);
               state->sock_fd = new_conn;
+              state->rx_packet.state = IDLE_READ_STATE;
+              state->rx_head = state->rx_tail = 0;
+              state->tx_size = 0;
+              state->no_ack_mode = 0;
             }
 
             if ( close_sock) {
@@ -1288,78 +1408,76 @@ WINAPI listenerThread_gdb( void *data) {
         if ( state->sock_fd != -1 && state->active) {
           SOCKET_TYPE gdb_sock = state->sock_fd;
           if ( FD_ISSET( gdb_sock, &read_sock_set)) {
-            enum read_res_gdb read_res = readPacket_gdb( gdb_sock, &state->rx_packet);
-
-            //DEBUG_LOG("socket read %d\n", read_res);
-
-            switch ( read_res) {
-            case READ_NOT_FINISHED:
-              /* do nothing here */
-              break;
-
-            case READ_SOCKET_ERROR:
-              /* close the socket */
-              CLOSESOCKET( gdb_sock);
-              state->sock_fd = -1;
-              FD_CLR( gdb_sock, &main_set);
-              break;
-
-            case READ_BREAK: {
-              /* break the running of the cpu */
-				if ( state->ctl_stub_state != gdb_stub_state::STOPPED_GDB_STATE) {
-                /* this will cause the emulation to break the execution */
-                DEBUG_LOG( "Breaking execution\n");
-
-                /* install the post execution function */
-                state->cpu_ctrl->install_post_ex_fn( state->cpu_ctrl->data,
-                                                     break_execution,
-                                                     state);
-              }
-              break;
-            }
+            int fill_ring = 1;
+
+            /* a single read can bring in several packets (and acks), so keep
+             * going until the ring is empty */
+            do {
+              enum read_res_gdb read_res = readPacket_gdb( state, fill_ring);
+              fill_ring = 0;
 
-            case READ_COMPLETE: {
-              uint8_t reply;
-              int write_res;
-              int process_packet = 0;
-              int close_socket = 0;
-              struct packet_reader_gdb *packet = &state->rx_packet;
+              //DEBUG_LOG("socket read %d\n", read_res);
 
-              if ( state->ctl_stub_state != gdb_stub_state::STOPPED_GDB_STATE) {
-                /* not ready to process packet yet, send a bad reply */
-                reply = '-';
+              switch ( read_res) {
+              case READ_NOT_FINISHED:
+                /* do nothing here */
+                break;
+
+              case READ_SOCKET_ERROR:
+                /* close the socket */
+                CLOSESOCKET( gdb_sock);
+                state->sock_fd = -1;
+                FD_CLR( gdb_sock, &main_set);
+                break;
+
+              case READ_BREAK: {
+                /* break the running of the cpu */
+  				if ( state->ctl_stub_state != gdb_stub_state::STOPPED_GDB_STATE) {
+                  /* this will cause the emulation to break the execution */
+                  DEBUG_LOG( "Breaking execution\n");
+
+                  /* install the post execution function */
+                  state->cpu_ctrl->install_post_ex_fn( state->cpu_ctrl->data,
+                                                       break_execution,
+                                                       state);
+                }
+                break;
               }
-              else {
-                /* send a reply based on the checksum and if okay process the packet */
-                if ( packet->read_checksum == packet->checksum) {
-                  reply = '+';
-                  process_packet = 1;
+
+              case READ_COMPLETE: {
+                uint8_t reply;
+                int process_packet = 0;
+                struct packet_reader_gdb *packet = &state->rx_packet;
+
+                if ( state->ctl_stub_state != gdb_stub_state::STOPPED_GDB_STATE) {
+                  /* not ready to process packet yet, send a bad reply */
+                  reply = '-';
                 }
                 else {
-                  reply = '-';
+                  /* send a reply based on the checksum and if okay process the packet */
+                  if ( packet->read_checksum == packet->checksum) {
+                    reply = '+';
+                    process_packet = 1;
+                  }
+                  else {
+                    reply = '-';
+                  }
                 }
-              }
 
-              write_res = send( gdb_sock, (char*)&reply, 1, 0);
-              
-              if ( write_res != 1) {
-                close_socket = 1;
-              }
-              else {
-                if ( processPacket_gdb( gdb_sock, state->rx_packet.buffer,
-                                        state) == -1) {
-                  close_socket = 1;
+                /* the ack is queued and goes out with the response */
+                if ( !state->no_ack_mode) {
+                  state->tx_buffer[state->tx_size++] = reply;
                 }
-              }
 
-              if ( close_socket) {
-                CLOSESOCKET( gdb_sock);
-                state->sock_fd = -1;
-                FD_CLR( gdb_sock, &main_set);
+                if ( processPacket_gdb( state->rx_packet.buffer, state) == -1) {
+                  CLOSESOCKET( gdb_sock);
+                  state->sock_fd = -1;
+                  FD_CLR( gdb_sock, &main_set);
+                }
+                break;
               }
-              break;
-            }
-            }
+              }
+            } while ( state->sock_fd != -1 && state->rx_head != state->rx_tail);
 	  }
 	}
       }
@@ -1576,6 +1694,9 @@ createStub_gdb( uint16_t port,
 	stub->emu_stub_state = gdb_stub_state::RUNNING_EMU_GDB_STATE;
 	stub->ctl_stub_state = gdb_stub_state::STOPPED_GDB_STATE;
     stub->rx_packet.state = IDLE_READ_STATE;
+    stub->rx_head = stub->rx_tail = 0;
+    stub->tx_size = 0;
+    stub->no_ack_mode = 0;
 
     stub->main_stop_flag = 1;
 
@@ -70,8 +70,13 @@ struct breakpoint_gdb {
 
 
 /*
+ * The largest packet the stub accepts or sends, not counting the framing.
+ * This is advertised to GDB through qSupported:PacketSize.
  */
-#define BUFMAX_GDB 2048
+#define BUFMAX_GDB 0x4000
+
+/** The size of the socket receive ring (must be a power of two) */
+#define RXBUF_GDB 0x1000
 
 struct packet_reader_gdb {
   int state;
@@ -149,6 +154,20 @@ struct gdb_stub_state {
 
   struct packet_reader_gdb rx_packet;
 
+  /** bytes received from the socket that have not been consumed yet.
+   * rx_head and rx_tail count up forever and are masked when indexing. */
+  uint8_t rx_ring[RXBUF_GDB];
+  uint32_t rx_head;
+  uint32_t rx_tail;
+
+  /** outgoing bytes, sent with a single call when a reply is complete.
+   * Room is left for an acknowledgement, the packet framing and a terminator. */
+  uint8_t tx_buffer[BUFMAX_GDB + 8];
+  uint32_t tx_size;
+
+  /** set once GDB has turned off acknowledgements with QStartNoAckMode */
+  int no_ack_mode;
+
   /** the socket information */
   uint16_t port_num;
   SOCKET_TYPE sock_fd;
@@ -50,6 +50,7 @@
 #include "readwrite.h"
 #include "FIFO.h"
 #include "utils/bits.h"
+#include "utils/task.h"
 #include "movie.h" //only for currframecounter which really ought to be moved into the core emu....
 
 //#define _SHOW_VTX_COUNTERS	// show polygon/vertex counters on screen
@@ -3241,16 +3242,46 @@ static FORCEINLINE s32 iround(const float f)
 	return (s32)( (f < 0.0f) ? f - 0.5f : f + 0.5f ); //lol
 }
 
+// Polygons are clipped in chunks of this many, which are spread over the rasterizer's pool threads.
+#define GFX3D_CLIP_CHUNK_SIZE 256
+#define GFX3D_CLIP_CHUNK_COUNT ((POLYLIST_SIZE + GFX3D_CLIP_CHUNK_SIZE - 1) / GFX3D_CLIP_CHUNK_SIZE)
+
+// The Y-sort splits the index list into no more than this many runs, and only when each run
+// would have at least GFX3D_SORT_RUN_MIN_SIZE polygons in it.
+#define GFX3D_SORT_RUN_MAX_COUNT 16
+#define GFX3D_SORT_RUN_MIN_SIZE 512
+
+struct GFX3D_ClipChunk
+{
+	const GFX3D_GeometryList *gList;
+	CPoly *outCPolyUnsortedList;
+	s64 wScalar;
+	s64 hScalar;
+	size_t polyBegin;
+	size_t polyEnd;
+	size_t clipCount;
+};
+
+struct GFX3D_SortRuns
+{
+	u16 *src;
+	u16 *dst;
+	size_t count;
+	size_t runCount;
+};
+
 template <ClipperMode CLIPPERMODE>
-size_t gfx3d_PerformClipping(const GFX3D_GeometryList &gList, CPoly *outCPolyUnsortedList)
+static void gfx3d_PerformClippingChunk(void *param, size_t chunkIndex)
 {
+	GFX3D_ClipChunk &chunk = ((GFX3D_ClipChunk *)param)[chunkIndex];
+	const GFX3D_GeometryList &gList = *chunk.gList;
+	const s64 wScalar = chunk.wScalar;
+	const s64 hScalar = chunk.hScalar;
+	
 	size_t clipCount = 0;
 	PolygonType cpType = POLYGON_TYPE_UNDEFINED;
 	
-	const s64 wScalar = (s64)CurrentRenderer->GetFramebufferWidth()  / (s64)GPU_FRAMEBUFFER_NATIVE_WIDTH;
-	const s64 hScalar = (s64)CurrentRenderer->GetFramebufferHeight() / (s64)GPU_FRAMEBUFFER_NATIVE_HEIGHT;
-	
-	for (size_t polyIndex = 0; polyIndex < gList.rawPolyCount; polyIndex++)
+	for (size_t polyIndex = chunk.polyBegin; polyIndex < chunk.polyEnd; polyIndex++)
 	{
 		const POLY &rawPoly = gList.rawPolyList[polyIndex];
 		const GFX3D_Viewport theViewport = rawPoly.viewport;
@@ -3262,7 +3293,9 @@ size_t gfx3d_PerformClipping(const GFX3D_GeometryList &gList, CPoly *outCPolyUns
 			(rawPoly.type == POLYGON_TYPE_QUAD) ? &gList.rawVtxList[rawPoly.vertIndexes[3]] : NULL
 		};
 		
-		CPoly &cPoly = outCPolyUnsortedList[clipCount];
+		// Every polygon has a slot of its own in the unsorted list, so that a chunk doesn't need to know
+		// how many polygons the chunks before it kept.
+		CPoly &cPoly = chunk.outCPolyUnsortedList[polyIndex];
 		
 		cpType = GFX3D_GenerateClippedPoly<CLIPPERMODE>(polyIndex, rawPoly.type, rawPolyVtx, cPoly);
 		if (cpType == POLYGON_TYPE_UNDEFINED)
@@ -3360,13 +3393,147 @@ size_t gfx3d_PerformClipping(const GFX3D_GeometryList &gList, CPoly *outCPolyUns
 			continue;
 		}
 		
-		// Incrementing the count will keep the polygon in the list.
+		//find the min and max y values for each poly that is kept.
+		//the w-division here is just an approximation to fix the shop in harvest moon island of happiness
+		//also the buttons in the knights in the nightmare frontend depend on this
+		//we process all polys here instead of just the opaque ones (which are sorted to the beginning of the index list later) because
+		//1. otherwise it is basically two passes through the list and will probably run slower than one pass through the list
+		//2. most geometry is opaque which is always sorted anyway
+		s64 y = (s64)gList.rawVtxList[rawPoly.vertIndexes[0]].position.y;
+		s64 w = (s64)gList.rawVtxList[rawPoly.vertIndexes[0]].position.w;
+		
+		// TODO: Possible divide by zero with the w-coordinate.
+		// Is the vertex being read correctly? Is 0 a valid value for w?
+		// If both of these questions answer to yes, then how does the NDS handle a NaN?
+		// For now, simply ignore w if it is zero.
+		if (w != 0)
+		{
+			y = ((y * 4096LL) + (w * 4096LL)) / (2LL * w);
+		}
+		
+		y = 4096LL - y;
+		
+		gfx3d.rawPolySortYMin[polyIndex] = y;
+		gfx3d.rawPolySortYMax[polyIndex] = y;
+		
+		for (size_t j = 1; j < (size_t)rawPoly.type; j++)
+		{
+			y = (s64)gList.rawVtxList[rawPoly.vertIndexes[j]].position.y;
+			w = (s64)gList.rawVtxList[rawPoly.vertIndexes[j]].position.w;
+			
+			if (w != 0)
+			{
+				y = ((y * 4096LL) + (w * 4096LL)) / (2LL * w);
+			}
+			
+			y = 4096LL - y;
+			
+			gfx3d.rawPolySortYMin[polyIndex] = std::min<s64>(gfx3d.rawPolySortYMin[polyIndex], y);
+			gfx3d.rawPolySortYMax[polyIndex] = std::max<s64>(gfx3d.rawPolySortYMax[polyIndex], y);
+		}
+		
+		// Listing the polygon will keep it. Each chunk lists its polygons at the start of its own range.
+		gfx3d.indexOfClippedPolyKeptList[chunk.polyBegin + clipCount] = (u16)polyIndex;
 		clipCount++;
 	}
 	
+	chunk.clipCount = clipCount;
+}
+
+template <ClipperMode CLIPPERMODE>
+size_t gfx3d_PerformClipping(const GFX3D_GeometryList &gList, CPoly *outCPolyUnsortedList)
+{
+	GFX3D_ClipChunk chunk[GFX3D_CLIP_CHUNK_COUNT];
+	const size_t chunkCount = (gList.rawPolyCount + GFX3D_CLIP_CHUNK_SIZE - 1) / GFX3D_CLIP_CHUNK_SIZE;
+	
+	const s64 wScalar = (s64)CurrentRenderer->GetFramebufferWidth()  / (s64)GPU_FRAMEBUFFER_NATIVE_WIDTH;
+	const s64 hScalar = (s64)CurrentRenderer->GetFramebufferHeight() / (s64)GPU_FRAMEBUFFER_NATIVE_HEIGHT;
+	
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		chunk[i].gList = &gList;
+		chunk[i].outCPolyUnsortedList = outCPolyUnsortedList;
+		chunk[i].wScalar = wScalar;
+		chunk[i].hScalar = hScalar;
+		chunk[i].polyBegin = i * GFX3D_CLIP_CHUNK_SIZE;
+		chunk[i].polyEnd = std::min<size_t>((i + 1) * GFX3D_CLIP_CHUNK_SIZE, gList.rawPolyCount);
+		chunk[i].clipCount = 0;
+	}
+	
+	TaskPool_ParallelFor(TaskGroup_Rasterizer, chunkCount, &gfx3d_PerformClippingChunk<CLIPPERMODE>, chunk);
+	
+	// Pack the chunks' lists together in chunk order, so that the kept polygons stay in the game's order.
+	size_t clipCount = 0;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		if (clipCount != chunk[i].polyBegin)
+		{
+			memmove(gfx3d.indexOfClippedPolyKeptList + clipCount, gfx3d.indexOfClippedPolyKeptList + chunk[i].polyBegin, chunk[i].clipCount * sizeof(u16));
+		}
+		
+		clipCount += chunk[i].clipCount;
+	}
+	
 	return clipCount;
 }
 
+static void gfx3d_SortRun(void *param, size_t runIndex)
+{
+	const GFX3D_SortRuns &sort = *(GFX3D_SortRuns *)param;
+	const size_t runBegin = (sort.count *  runIndex     ) / sort.runCount;
+	const size_t runEnd   = (sort.count * (runIndex + 1)) / sort.runCount;
+	
+	std::sort(sort.src + runBegin, sort.src + runEnd, gfx3d_ysort_compare);
+}
+
+static void gfx3d_MergeRuns(void *param, size_t pairIndex)
+{
+	const GFX3D_SortRuns &sort = *(GFX3D_SortRuns *)param;
+	const size_t runBegin  = (sort.count * (pairIndex * 2    )) / sort.runCount;
+	const size_t runMiddle = (sort.count * (pairIndex * 2 + 1)) / sort.runCount;
+	const size_t runEnd    = (sort.count * (pairIndex * 2 + 2)) / sort.runCount;
+	
+	std::merge(sort.src + runBegin, sort.src + runMiddle, sort.src + runMiddle, sort.src + runEnd, sort.dst + runBegin, gfx3d_ysort_compare);
+}
+
+// Sorts part of the clipped polygon index list by Y. gfx3d_ysort_compare() never considers two polygons
+// equal, so sorting runs of the list on separate threads and then merging them gives the very same order
+// as sorting the whole list at once.
+static void gfx3d_SortPolyIndexList(u16 *indexList, const size_t count)
+{
+	size_t runCount = 1;
+	while ( (runCount < GFX3D_SORT_RUN_MAX_COUNT) && ((count / (runCount * 2)) >= GFX3D_SORT_RUN_MIN_SIZE) )
+	{
+		runCount *= 2;
+	}
+	
+	if (runCount == 1)
+	{
+		std::sort(indexList, indexList + count, gfx3d_ysort_compare);
+		return;
+	}
+	
+	GFX3D_SortRuns sort;
+	sort.src = indexList;
+	sort.dst = gfx3d.indexOfClippedPolySortTemp;
+	sort.count = count;
+	sort.runCount = runCount;
+	
+	TaskPool_ParallelFor(TaskGroup_Rasterizer, sort.runCount, &gfx3d_SortRun, &sort);
+	
+	while (sort.runCount > 1)
+	{
+		TaskPool_ParallelFor(TaskGroup_Rasterizer, sort.runCount / 2, &gfx3d_MergeRuns, &sort);
+		std::swap(sort.src, sort.dst);
+		sort.runCount /= 2;
+	}
+	
+	if (sort.src != indexList)
+	{
+		memcpy(indexList, sort.src, count * sizeof(u16));
+	}
+}
+
 void GFX3D_GenerateRenderLists(const ClipperMode clippingMode, const GFX3D_State &inState, GFX3D_GeometryList &outGList)
 {
 	switch (clippingMode)
@@ -3396,77 +3563,32 @@ void GFX3D_GenerateRenderLists(const ClipperMode clippingMode, const GFX3D_State
 	size_t ctr = 0;
 	for (size_t i = 0; i < outGList.clippedPolyCount; i++)
 	{
-		const CPoly &clippedPoly = gfx3d.clippedPolyUnsortedList[i];
+		const u16 clippedPolyIndex = gfx3d.indexOfClippedPolyKeptList[i];
+		const CPoly &clippedPoly = gfx3d.clippedPolyUnsortedList[clippedPolyIndex];
 		if ( !GFX3D_IsPolyTranslucent(outGList.rawPolyList[clippedPoly.index]) )
-			gfx3d.indexOfClippedPolyUnsortedList[ctr++] = i;
+			gfx3d.indexOfClippedPolyUnsortedList[ctr++] = clippedPolyIndex;
 	}
 	outGList.clippedPolyOpaqueCount = ctr;
 	
 	//then look for translucent polys
 	for (size_t i = 0; i < outGList.clippedPolyCount; i++)
 	{
-		const CPoly &clippedPoly = gfx3d.clippedPolyUnsortedList[i];
+		const u16 clippedPolyIndex = gfx3d.indexOfClippedPolyKeptList[i];
+		const CPoly &clippedPoly = gfx3d.clippedPolyUnsortedList[clippedPolyIndex];
 		if ( GFX3D_IsPolyTranslucent(outGList.rawPolyList[clippedPoly.index]) )
-			gfx3d.indexOfClippedPolyUnsortedList[ctr++] = i;
+			gfx3d.indexOfClippedPolyUnsortedList[ctr++] = clippedPolyIndex;
 	}
 	
-	//find the min and max y values for each poly.
-	//the w-division here is just an approximation to fix the shop in harvest moon island of happiness
-	//also the buttons in the knights in the nightmare frontend depend on this
-	//we process all polys here instead of just the opaque ones (which have been sorted to the beginning of the index list earlier) because
-	//1. otherwise it is basically two passes through the list and will probably run slower than one pass through the list
-	//2. most geometry is opaque which is always sorted anyway
-	const NDSVertex *__restrict appliedVertList = outGList.rawVtxList;
-	
-	for (size_t i = 0; i < outGList.clippedPolyCount; i++)
-	{
-		const u16 rawPolyIndex = gfx3d.clippedPolyUnsortedList[i].index;
-		const POLY &poly = outGList.rawPolyList[rawPolyIndex];
-		
-		s64 y = (s64)appliedVertList[poly.vertIndexes[0]].position.y;
-		s64 w = (s64)appliedVertList[poly.vertIndexes[0]].position.w;
-		
-		// TODO: Possible divide by zero with the w-coordinate.
-		// Is the vertex being read correctly? Is 0 a valid value for w?
-		// If both of these questions answer to yes, then how does the NDS handle a NaN?
-		// For now, simply ignore w if it is zero.
-		if (w != 0)
-		{
-			y = ((y * 4096LL) + (w * 4096LL)) / (2LL * w);
-		}
-		
-		y = 4096LL - y;
-		
-		gfx3d.rawPolySortYMin[rawPolyIndex] = y;
-		gfx3d.rawPolySortYMax[rawPolyIndex] = y;
-		
-		for (size_t j = 1; j < (size_t)poly.type; j++)
-		{
-			y = (s64)appliedVertList[poly.vertIndexes[j]].position.y;
-			w = (s64)appliedVertList[poly.vertIndexes[j]].position.w;
-			
-			if (w != 0)
-			{
-				y = ((y * 4096LL) + (w * 4096LL)) / (2LL * w);
-			}
-			
-			y = 4096LL - y;
-			
-			gfx3d.rawPolySortYMin[rawPolyIndex] = std::min<s64>(gfx3d.rawPolySortYMin[rawPolyIndex], y);
-			gfx3d.rawPolySortYMax[rawPolyIndex] = std::max<s64>(gfx3d.rawPolySortYMax[rawPolyIndex], y);
-		}
-	}
-
 	//now we have to sort the opaque polys by y-value.
 	//(test case: harvest moon island of happiness character creator UI)
 	//should this be done after clipping??
-	std::sort(gfx3d.indexOfClippedPolyUnsortedList, gfx3d.indexOfClippedPolyUnsortedList + outGList.clippedPolyOpaqueCount, gfx3d_ysort_compare);
+	gfx3d_SortPolyIndexList(gfx3d.indexOfClippedPolyUnsortedList, outGList.clippedPolyOpaqueCount);
 	
 	if (inState.SWAP_BUFFERS.YSortMode == 0)
 	{
 		//if we are autosorting translucent polys, we need to do this also
 		//TODO - this is unverified behavior. need a test case
-		std::sort(gfx3d.indexOfClippedPolyUnsortedList + outGList.clippedPolyOpaqueCount, gfx3d.indexOfClippedPolyUnsortedList + outGList.clippedPolyCount, gfx3d_ysort_compare);
+		gfx3d_SortPolyIndexList(gfx3d.indexOfClippedPolyUnsortedList + outGList.clippedPolyOpaqueCount, outGList.clippedPolyCount - outGList.clippedPolyOpaqueCount);
 	}
 	
 	// Reorder the clipped polygon list to match our sorted index list.
@@ -3545,6 +3667,8 @@ void gfx3d_VBlankSignal()
 
 void gfx3d_VBlankEndSignal(bool skipFrame)
 {
+	NDSPerfScope perfScope(NDSPerfSection_3D);
+	
 	if (CurrentRenderer->GetRenderNeedsFinish())
 	{
 		GPU->ForceRender3DFinishAndFlush(false);
@@ -4239,6 +4363,7 @@ static FORCEINLINE void GFX3D_ClipPoint(const NDSVertex &insideVtx, const NDSVer
 			outClippedVtx.color.r = GFX3D_LerpUnsigned<u8>(t_u64, insideVtx.color.r, outsideVtx.color.r);
 			outClippedVtx.color.g = GFX3D_LerpUnsigned<u8>(t_u64, insideVtx.color.g, outsideVtx.color.g);
 			outClippedVtx.color.b = GFX3D_LerpUnsigned<u8>(t_u64, insideVtx.color.b, outsideVtx.color.b);
+			outClippedVtx.color.a = 0;
 			break;
 			
 		case ClipperMode_FullColorInterpolate:
@@ -4247,6 +4372,7 @@ static FORCEINLINE void GFX3D_ClipPoint(const NDSVertex &insideVtx, const NDSVer
 			outClippedVtx.color.r = GFX3D_LerpUnsigned<u8>(t_u64, insideVtx.color.r, outsideVtx.color.r);
 			outClippedVtx.color.g = GFX3D_LerpUnsigned<u8>(t_u64, insideVtx.color.g, outsideVtx.color.g);
 			outClippedVtx.color.b = GFX3D_LerpUnsigned<u8>(t_u64, insideVtx.color.b, outsideVtx.color.b);
+			outClippedVtx.color.a = 0;
 			break;
 			
 		case ClipperMode_DetermineClipOnly:
@@ -4267,8 +4393,14 @@ static FORCEINLINE void GFX3D_ClipPoint(const NDSVertex &insideVtx, const NDSVer
 }
 
 #define MAX_SCRATCH_CLIP_VERTS (4*6 + 40)
-static NDSVertex scratchClipVerts[MAX_SCRATCH_CLIP_VERTS];
-static size_t numScratchClipVerts = 0;
+
+// Holds the vertices that the clipper stages generate while clipping a single polygon.
+// Each polygon gets its own, so that polygons can be clipped on more than one thread at once.
+struct ClipperScratch
+{
+	NDSVertex vtx[MAX_SCRATCH_CLIP_VERTS];
+	size_t count;
+};
 
 template <ClipperMode CLIPPERMODE, int COORD, int WHICH, class NEXT>
 class ClipperPlane
@@ -4276,11 +4408,12 @@ class ClipperPlane
 public:
 	ClipperPlane(NEXT &next) : m_next(next) {}
 	
-	void init(NDSVertex *vtxList)
+	void init(NDSVertex *vtxList, ClipperScratch *scratch)
 	{
 		m_prevVert =  NULL;
 		m_firstVert = NULL;
-		m_next.init(vtxList);
+		m_scratch = scratch;
+		m_next.init(vtxList, scratch);
 	}
 	
 	void clipVert(const NDSVertex &vtx)
@@ -4311,6 +4444,7 @@ public:
 private:
 	NDSVertex *m_prevVert;
 	NDSVertex *m_firstVert;
+	ClipperScratch *m_scratch;
 	NEXT &m_next;
 	
 	FORCEINLINE void clipSegmentVsPlane(const NDSVertex &vtx0, const NDSVertex &vtx1)
@@ -4341,18 +4475,18 @@ private:
 		if (!out0 && out1)
 		{
 			CLIPLOG(" exiting\n");
-			assert((u32)numScratchClipVerts < MAX_SCRATCH_CLIP_VERTS);
-			GFX3D_ClipPoint<CLIPPERMODE, COORD, WHICH>(vtx0, vtx1, scratchClipVerts[numScratchClipVerts]);
-			m_next.clipVert(scratchClipVerts[numScratchClipVerts++]);
+			assert((u32)m_scratch->count < MAX_SCRATCH_CLIP_VERTS);
+			GFX3D_ClipPoint<CLIPPERMODE, COORD, WHICH>(vtx0, vtx1, m_scratch->vtx[m_scratch->count]);
+			m_next.clipVert(m_scratch->vtx[m_scratch->count++]);
 		}
 		
 		//entering volume: insert clipped point and the next (interior) point
 		if (out0 && !out1)
 		{
 			CLIPLOG(" entering\n");
-			assert((u32)numScratchClipVerts < MAX_SCRATCH_CLIP_VERTS);
-			GFX3D_ClipPoint<CLIPPERMODE, COORD, WHICH>(vtx1, vtx0, scratchClipVerts[numScratchClipVerts]);
-			m_next.clipVert(scratchClipVerts[numScratchClipVerts++]);
+			assert((u32)m_scratch->count < MAX_SCRATCH_CLIP_VERTS);
+			GFX3D_ClipPoint<CLIPPERMODE, COORD, WHICH>(vtx1, vtx0, m_scratch->vtx[m_scratch->count]);
+			m_next.clipVert(m_scratch->vtx[m_scratch->count++]);
 			m_next.clipVert(vtx1);
 		}
 	}
@@ -4361,7 +4495,7 @@ private:
 class ClipperOutput
 {
 public:
-	void init(NDSVertex *vtxList)
+	void init(NDSVertex *vtxList, ClipperScratch *scratch)
 	{
 		m_nextDestVert = vtxList;
 		m_numVerts = 0;
@@ -4387,32 +4521,39 @@ private:
 // see "Template juggling with Sutherland-Hodgman" http://www.codeguru.com/cpp/misc/misc/graphics/article.php/c8965__2/
 // for the idea behind setting things up like this.
 
-// Non-interpolated clippers
-static ClipperOutput clipperOut;
-typedef ClipperPlane<ClipperMode_Full, 2, 1,ClipperOutput> Stage6; static Stage6 clipper6 (clipperOut); // back plane //TODO - we need to parameterize back plane clipping
-typedef ClipperPlane<ClipperMode_Full, 2,-1,Stage6> Stage5;        static Stage5 clipper5 (clipper6); // front plane
-typedef ClipperPlane<ClipperMode_Full, 1, 1,Stage5> Stage4;        static Stage4 clipper4 (clipper5); // top plane
-typedef ClipperPlane<ClipperMode_Full, 1,-1,Stage4> Stage3;        static Stage3 clipper3 (clipper4); // bottom plane
-typedef ClipperPlane<ClipperMode_Full, 0, 1,Stage3> Stage2;        static Stage2 clipper2 (clipper3); // right plane
-typedef ClipperPlane<ClipperMode_Full, 0,-1,Stage2> Stage1;        static Stage1 clipper1 (clipper2); // left plane
-
-// Interpolated clippers
-static ClipperOutput clipperOuti;
-typedef ClipperPlane<ClipperMode_FullColorInterpolate, 2, 1,ClipperOutput> Stage6i; static Stage6i clipper6i (clipperOuti); // back plane //TODO - we need to parameterize back plane clipping
-typedef ClipperPlane<ClipperMode_FullColorInterpolate, 2,-1,Stage6i> Stage5i;       static Stage5i clipper5i (clipper6i); // front plane
-typedef ClipperPlane<ClipperMode_FullColorInterpolate, 1, 1,Stage5i> Stage4i;       static Stage4i clipper4i (clipper5i); // top plane
-typedef ClipperPlane<ClipperMode_FullColorInterpolate, 1,-1,Stage4i> Stage3i;       static Stage3i clipper3i (clipper4i); // bottom plane
-typedef ClipperPlane<ClipperMode_FullColorInterpolate, 0, 1,Stage3i> Stage2i;       static Stage2i clipper2i (clipper3i); // right plane
-typedef ClipperPlane<ClipperMode_FullColorInterpolate, 0,-1,Stage2i> Stage1i;       static Stage1i clipper1i (clipper2i); // left plane
-
-// Determine's clip status only
-static ClipperOutput clipperOutd;
-typedef ClipperPlane<ClipperMode_DetermineClipOnly, 2, 1,ClipperOutput> Stage6d; static Stage6d clipper6d (clipperOutd); // back plane //TODO - we need to parameterize back plane clipping
-typedef ClipperPlane<ClipperMode_DetermineClipOnly, 2,-1,Stage6d> Stage5d;       static Stage5d clipper5d (clipper6d); // front plane
-typedef ClipperPlane<ClipperMode_DetermineClipOnly, 1, 1,Stage5d> Stage4d;       static Stage4d clipper4d (clipper5d); // top plane
-typedef ClipperPlane<ClipperMode_DetermineClipOnly, 1,-1,Stage4d> Stage3d;       static Stage3d clipper3d (clipper4d); // bottom plane
-typedef ClipperPlane<ClipperMode_DetermineClipOnly, 0, 1,Stage3d> Stage2d;       static Stage2d clipper2d (clipper3d); // right plane
-typedef ClipperPlane<ClipperMode_DetermineClipOnly, 0,-1,Stage2d> Stage1d;       static Stage1d clipper1d (clipper2d); // left plane
+template <ClipperMode CLIPPERMODE>
+struct ClipperStages
+{
+	typedef ClipperPlane<CLIPPERMODE, 2, 1,ClipperOutput> Stage6; // back plane //TODO - we need to parameterize back plane clipping
+	typedef ClipperPlane<CLIPPERMODE, 2,-1,Stage6> Stage5;        // front plane
+	typedef ClipperPlane<CLIPPERMODE, 1, 1,Stage5> Stage4;        // top plane
+	typedef ClipperPlane<CLIPPERMODE, 1,-1,Stage4> Stage3;        // bottom plane
+	typedef ClipperPlane<CLIPPERMODE, 0, 1,Stage3> Stage2;        // right plane
+	typedef ClipperPlane<CLIPPERMODE, 0,-1,Stage2> Stage1;        // left plane
+};
+
+// Returns a bit for each clipping plane that the vertex lies outside of, in the same order that the clipper
+// stages test them: left, right, bottom, top, front, back.
+static FORCEINLINE u32 GFX3D_GetClipOutcode(const NDSVertex &vtx)
+{
+#ifdef ENABLE_SSE2
+	const v128s32 pos = _mm_loadu_si128((v128s32 *)vtx.position.coord);
+	const v128s32 w = _mm_shuffle_epi32(pos, 0xFF);
+	const v128s32 negW = _mm_sub_epi32(_mm_setzero_si128(), w);
+	const u32 outNeg = (u32)_mm_movemask_ps( _mm_castsi128_ps(_mm_cmplt_epi32(pos, negW)) );
+	const u32 outPos = (u32)_mm_movemask_ps( _mm_castsi128_ps(_mm_cmpgt_epi32(pos, w)) );
+	
+	return ((outNeg & 0x01)     ) | ((outPos & 0x01) << 1) |
+	       ((outNeg & 0x02) << 1) | ((outPos & 0x02) << 2) |
+	       ((outNeg & 0x04) << 2) | ((outPos & 0x04) << 3);
+#else
+	const s32 *coord = vtx.position.coord;
+	
+	return ((coord[0] < -coord[3]) ? 0x01 : 0) | ((coord[0] > coord[3]) ? 0x02 : 0) |
+	       ((coord[1] < -coord[3]) ? 0x04 : 0) | ((coord[1] > coord[3]) ? 0x08 : 0) |
+	       ((coord[2] < -coord[3]) ? 0x10 : 0) | ((coord[2] > coord[3]) ? 0x20 : 0);
+#endif
+}
 
 template <ClipperMode CLIPPERMODE>
 PolygonType GFX3D_GenerateClippedPoly(const u16 rawPolyIndex, const PolygonType rawPolyType, const NDSVertex *(&rawVtx)[4], CPoly &outCPoly)
@@ -4420,39 +4561,53 @@ PolygonType GFX3D_GenerateClippedPoly(const u16 rawPolyIndex, const PolygonType
 	CLIPLOG("==Begin poly==\n");
 	
 	PolygonType outClippedType;
-	numScratchClipVerts = 0;
 	
-	switch (CLIPPERMODE)
+	// Most polygons lie either entirely inside the view volume or entirely outside of one of its planes,
+	// so test the vertices against all of the planes at once before running the full clipper.
+	u32 anyOutcode = 0;
+	u32 allOutcode = 0x3F;
+	for (size_t i = 0; i < (size_t)rawPolyType; i++)
 	{
-		case ClipperMode_Full:
-		{
-			clipper1.init(outCPoly.vtx);
-			for (size_t i = 0; i < (size_t)rawPolyType; i++)
-				clipper1.clipVert(*rawVtx[i]);
-			
-			outClippedType = (PolygonType)clipper1.finish();
-			break;
-		}
-			
-		case ClipperMode_FullColorInterpolate:
-		{
-			clipper1i.init(outCPoly.vtx);
-			for (size_t i = 0; i < (size_t)rawPolyType; i++)
-				clipper1i.clipVert(*rawVtx[i]);
-			
-			outClippedType = (PolygonType)clipper1i.finish();
-			break;
-		}
-			
-		case ClipperMode_DetermineClipOnly:
+		const u32 outcode = GFX3D_GetClipOutcode(*rawVtx[i]);
+		anyOutcode |= outcode;
+		allOutcode &= outcode;
+	}
+	
+	if (anyOutcode == 0)
+	{
+		// Every clipper stage passes an inside polygon through starting from its second vertex, which
+		// rotates the vertex list by one place per stage. Keep that order so that the result is the same.
+		for (size_t i = 0; i < (size_t)rawPolyType; i++)
 		{
-			clipper1d.init(outCPoly.vtx);
-			for (size_t i = 0; i < (size_t)rawPolyType; i++)
-				clipper1d.clipVert(*rawVtx[i]);
-			
-			outClippedType = (PolygonType)clipper1d.finish();
-			break;
+			outCPoly.vtx[i] = *rawVtx[(i + 6) % (size_t)rawPolyType];
 		}
+		
+		outClippedType = rawPolyType;
+	}
+	else if ( (allOutcode & (anyOutcode & (0 - anyOutcode))) != 0 )
+	{
+		// All of the vertices lie outside of the first plane that any of them lie outside of. The stages
+		// before that plane pass the vertices through untouched, so that plane would discard all of them.
+		return POLYGON_TYPE_UNDEFINED;
+	}
+	else
+	{
+		ClipperScratch scratch;
+		scratch.count = 0;
+		
+		ClipperOutput clipperOut;
+		typename ClipperStages<CLIPPERMODE>::Stage6 clipper6(clipperOut);
+		typename ClipperStages<CLIPPERMODE>::Stage5 clipper5(clipper6);
+		typename ClipperStages<CLIPPERMODE>::Stage4 clipper4(clipper5);
+		typename ClipperStages<CLIPPERMODE>::Stage3 clipper3(clipper4);
+		typename ClipperStages<CLIPPERMODE>::Stage2 clipper2(clipper3);
+		typename ClipperStages<CLIPPERMODE>::Stage1 clipper1(clipper2);
+		
+		clipper1.init(outCPoly.vtx, &scratch);
+		for (size_t i = 0; i < (size_t)rawPolyType; i++)
+			clipper1.clipVert(*rawVtx[i]);
+		
+		outClippedType = (PolygonType)clipper1.finish();
 	}
 	
 	assert((u32)outClippedType < MAX_CLIPPED_VERTS);
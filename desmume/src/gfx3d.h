@@ -783,6 +783,8 @@ struct GFX3D
 	// Working lists for rendering.
 	CACHE_ALIGN CPoly clippedPolyUnsortedList[CLIPPED_POLYLIST_SIZE]; // Records clipped polygon info on first pass
 	CACHE_ALIGN u16 indexOfClippedPolyUnsortedList[CLIPPED_POLYLIST_SIZE];
+	CACHE_ALIGN u16 indexOfClippedPolyKeptList[POLYLIST_SIZE]; // Indexes of the polygons that survived clipping, in polygon order
+	CACHE_ALIGN u16 indexOfClippedPolySortTemp[CLIPPED_POLYLIST_SIZE]; // Temp buffer used for merging sorted runs of the index list
 	CACHE_ALIGN s64 rawPolySortYMin[POLYLIST_SIZE]; // Temp buffer used for processing polygon Y-sorting
 	CACHE_ALIGN s64 rawPolySortYMax[POLYLIST_SIZE]; // Temp buffer used for processing polygon Y-sorting
 	
@@ -1891,6 +1891,7 @@ DEFINE_LUA_FUNCTION(vram_writeword, "address,value")
 	int address = luaL_checkinteger(L,1);
 	u16 value = (u16)(luaL_checkinteger(L,2) & 0xFFFF);
 	T1WriteWord(MMU.ARM9_LCD,address,value);
+	MMU_VRAMMarkWritten(MMU.ARM9_LCD + address, sizeof(u16));
 	return 0;
 }
 DEFINE_LUA_FUNCTION(memory_writedword, "address,value")
@@ -5730,12 +5731,44 @@ void CloseLuaContext(int uid)
 
 
 TieredRegion hookedRegions [LUAMEMHOOK_COUNT];
+u32 hookedPages [LUAMEMHOOK_COUNT][LUAMEMHOOK_PAGE_WORDS];
 
 
-// currently disabled for desmume,
-// and the performance hit might not be accepable
-// unless we can switch the emulation into a whole separate path
-// that has this callback enabled.
+static void CalculateMemHookPages(LuaMemHookType hookType, const std::vector<unsigned int>& hookedBytes)
+{
+	static std::vector<u32> pages(LUAMEMHOOK_PAGE_WORDS);
+	std::fill(pages.begin(), pages.end(), 0);
+
+	for(size_t i = 0; i < hookedBytes.size(); i++)
+	{
+		// an access also reaches this byte if it starts up to 3 bytes earlier, possibly in the previous page
+		const u32 first = (hookedBytes[i] - 3) >> LUAMEMHOOK_PAGE_SHIFT;
+		const u32 last = hookedBytes[i] >> LUAMEMHOOK_PAGE_SHIFT;
+		pages[first >> 5] |= 1u << (first & 31);
+		pages[last >> 5] |= 1u << (last & 31);
+	}
+
+	u32 *current = hookedPages[hookType];
+	for(u32 word = 0; word < LUAMEMHOOK_PAGE_WORDS; word++)
+	{
+		const u32 changed = current[word] ^ pages[word];
+		if(!changed)
+			continue;
+		current[word] = pages[word];
+
+#ifdef HAVE_JIT
+		// the JIT only compiles the exec hook check into blocks on hooked pages,
+		// so the blocks on pages that gained or lost hooks have to be recompiled
+		if(hookType == LUAMEMHOOK_EXEC && CommonSettings.use_jit)
+		{
+			for(u32 bit = 0; bit < 32; bit++)
+				if(changed & (1u << bit))
+					arm_jit_invalidate(((word << 5) | bit) << LUAMEMHOOK_PAGE_SHIFT, 1 << LUAMEMHOOK_PAGE_SHIFT);
+		}
+#endif
+	}
+}
+
 static void CalculateMemHookRegions(LuaMemHookType hookType)
 {
 	std::vector<unsigned int> hookedBytes;
@@ -5768,6 +5801,7 @@ static void CalculateMemHookRegions(LuaMemHookType hookType)
 		++iter;
 	}
 	hookedRegions[hookType].Calculate(hookedBytes);
+	CalculateMemHookPages(hookType, hookedBytes);
 }
 
 
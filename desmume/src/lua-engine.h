@@ -205,6 +205,20 @@ struct TieredRegion
 };
 extern TieredRegion hookedRegions [LUAMEMHOOK_COUNT];
 
+// one bit per 4KB page of the address space for each hook type, set if an access of up to 4 bytes
+// that starts in the page could touch a hooked byte. this lets the memory accessors (and the JIT,
+// when it compiles a block) reject unhooked addresses with a single load.
+// CalculateMemHookRegions() rebuilds it together with hookedRegions.
+#define LUAMEMHOOK_PAGE_SHIFT 12
+#define LUAMEMHOOK_PAGE_WORDS ((1 << (32 - LUAMEMHOOK_PAGE_SHIFT)) / 32)
+extern u32 hookedPages [LUAMEMHOOK_COUNT][LUAMEMHOOK_PAGE_WORDS];
+
+FORCEINLINE bool IsLuaMemHookPage(unsigned int address, LuaMemHookType hookType)
+{
+	const u32 page = address >> LUAMEMHOOK_PAGE_SHIFT;
+	return (hookedPages[hookType][page >> 5] >> (page & 31)) & 1;
+}
+
 void CallRegisteredLuaMemHook_LuaMatch(unsigned int address, int size, unsigned int value, LuaMemHookType hookType);
 
 FORCEINLINE void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
@@ -214,7 +228,7 @@ FORCEINLINE void CallRegisteredLuaMemHook(unsigned int address, int size, unsign
 	// before and after, because even the most innocent change can make it become 30% to 400% slower.
 	// a good amount to test is: 100000000 calls with no hook set, and another 100000000 with a hook set.
 	// (on my system that consistently took 200 ms total in the former case and 350 ms total in the latter case)
-	if(hookedRegions[hookType].NotEmpty())
+	if(IsLuaMemHookPage(address, hookType))
 	{
 		//if((hookType <= LUAMEMHOOK_EXEC) && (address >= 0xE00000))
 		//	address |= 0xFF0000; // gens: account for mirroring of RAM
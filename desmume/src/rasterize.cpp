@@ -69,6 +69,13 @@
 #include "filter/filter.h"
 #include "filter/xbrz.h"
 
+// The number of fragments that the depth test can handle at once when using SIMD.
+#if defined(ENABLE_AVX2)
+	#define SOFTRASTERIZER_DEPTH_SPAN_LANES 8
+#elif defined(ENABLE_SSE2) || defined(ENABLE_NEON_A64)
+	#define SOFTRASTERIZER_DEPTH_SPAN_LANES 4
+#endif
+
 static u8 modulate_table[64][64];
 static u8 decal_table[32][64][64];
 
@@ -647,18 +654,11 @@ FORCEINLINE void RasterizerUnit<RENDERER>::_shade(const PolygonMode polygonMode,
 	}
 }
 
-template<bool RENDERER> template<bool ISFRONTFACING, bool ISSHADOWPOLYGON>
-FORCEINLINE void RasterizerUnit<RENDERER>::_pixel(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, const u32 depth, const Color4u8 &vtxColor, const Vector2s32 texCoord, const size_t fragmentIndex, Color4u8 &dstColor)
+template<bool RENDERER> template<bool ISFRONTFACING>
+FORCEINLINE bool RasterizerUnit<RENDERER>::_depthTest(const POLYGON_ATTR polyAttr, const u32 depth, const size_t fragmentIndex, const Color4u8 &dstColor)
 {
-	const GFX3D_State &renderState = *this->_softRender->currentRenderState;
-	
-	u32 &dstAttributeDepth				= this->_softRender->_framebufferAttributes->depth[fragmentIndex];
-	u8 &dstAttributeOpaquePolyID		= this->_softRender->_framebufferAttributes->opaquePolyID[fragmentIndex];
-	u8 &dstAttributeTranslucentPolyID	= this->_softRender->_framebufferAttributes->translucentPolyID[fragmentIndex];
-	u8 &dstAttributeStencil				= this->_softRender->_framebufferAttributes->stencil[fragmentIndex];
-	u8 &dstAttributeIsFogged			= this->_softRender->_framebufferAttributes->isFogged[fragmentIndex];
-	u8 &dstAttributeIsTranslucentPoly	= this->_softRender->_framebufferAttributes->isTranslucentPoly[fragmentIndex];
-	u8 &dstAttributePolyFacing			= this->_softRender->_framebufferAttributes->polyFacing[fragmentIndex];
+	const u32 dstAttributeDepth = this->_softRender->_framebufferAttributes->depth[fragmentIndex];
+	const u8 dstAttributePolyFacing = this->_softRender->_framebufferAttributes->polyFacing[fragmentIndex];
 	
 	// run the depth test
 	bool depthFail = false;
@@ -696,17 +696,174 @@ FORCEINLINE void RasterizerUnit<RENDERER>::_pixel(const POLYGON_ATTR polyAttr, c
 			depthFail = true;
 		}
 	}
+	
+	return !depthFail;
+}
 
-	if (depthFail)
+#ifdef SOFTRASTERIZER_DEPTH_SPAN_LANES
+template<bool RENDERER> template<bool ISFRONTFACING>
+FORCEINLINE u32 RasterizerUnit<RENDERER>::_depthTestSpanZ(const POLYGON_ATTR polyAttr, const s64 zFirst, const s64 zStep, const size_t fragmentIndex, const Color4u8 *dstColor, u32 *outDepth)
+{
+	// Runs the depth test on SOFTRASTERIZER_DEPTH_SPAN_LANES fragments at once, starting at fragmentIndex,
+	// using Z-depth without the fragment sampling hack. The depth of each fragment is written to outDepth,
+	// and a bitmask of the fragments that passed the depth test is returned. This must produce the exact
+	// same results as running _depthTest() on each fragment individually.
+	const u32 *dstAttrDepth = this->_softRender->_framebufferAttributes->depth + fragmentIndex;
+	const u8 *dstAttrPolyFacing = this->_softRender->_framebufferAttributes->polyFacing + fragmentIndex;
+	const Color4u8 *dst = dstColor + fragmentIndex;
+	u32 passMask = 0;
+	
+#if defined(ENABLE_AVX2)
+	// depth = (u32)(z / (1LL << (Z_EXTRAPRECISION + 7))) & 0xFFFFFFFE, rounding toward zero
+	const __m256i zStep4 = _mm256_set1_epi64x(zStep * 4);
+	const __m256i zRoundBias = _mm256_set1_epi64x((1LL << (Z_EXTRAPRECISION + 7)) - 1);
+	__m256i z0 = _mm256_set_epi64x(zFirst + (zStep * 3), zFirst + (zStep * 2), zFirst + zStep, zFirst);
+	__m256i z1 = _mm256_add_epi64(z0, zStep4);
+	
+	z0 = _mm256_add_epi64( z0, _mm256_and_si256(_mm256_shuffle_epi32(_mm256_srai_epi32(z0, 31), 0xF5), zRoundBias) );
+	z1 = _mm256_add_epi64( z1, _mm256_and_si256(_mm256_shuffle_epi32(_mm256_srai_epi32(z1, 31), 0xF5), zRoundBias) );
+	z0 = _mm256_permute4x64_epi64( _mm256_shuffle_epi32(_mm256_srli_epi64(z0, Z_EXTRAPRECISION + 7), 0x08), 0xD8 );
+	z1 = _mm256_permute4x64_epi64( _mm256_shuffle_epi32(_mm256_srli_epi64(z1, Z_EXTRAPRECISION + 7), 0x08), 0xD8 );
+	const v256u32 depth = _mm256_and_si256( _mm256_permute2x128_si256(z0, z1, 0x20), _mm256_set1_epi32(0xFFFFFFFE) );
+	_mm256_store_si256((v256u32 *)outDepth, depth);
+	
+	// SIMD only has signed comparisons, so flip the sign bits in order to do unsigned comparisons.
+	const v256u32 signBit = _mm256_set1_epi32(0x80000000);
+	const v256u32 dstDepth = _mm256_loadu_si256((v256u32 *)dstAttrDepth);
+	const v256u32 depthS = _mm256_xor_si256(depth, signBit);
+	v256u32 passed;
+	
+	if (polyAttr.DepthEqualTest_Enable)
 	{
-		//shadow mask polygons set stencil bit here
-		if (ISSHADOWPOLYGON && polyAttr.PolygonID == 0)
+		const v256u32 minDepthTemp = _mm256_sub_epi32(dstDepth, _mm256_set1_epi32(DEPTH_EQUALS_TEST_TOLERANCE));
+		const v256u32 minDepth = _mm256_andnot_si256(_mm256_srai_epi32(minDepthTemp, 31), minDepthTemp);
+		const v256u32 maxDepthTemp = _mm256_add_epi32(dstDepth, _mm256_set1_epi32(DEPTH_EQUALS_TEST_TOLERANCE));
+		const v256u32 maxDepth = _mm256_blendv_epi8( maxDepthTemp, _mm256_set1_epi32(0x00FFFFFF), _mm256_cmpgt_epi32(_mm256_xor_si256(maxDepthTemp, signBit), _mm256_set1_epi32(0x00FFFFFF ^ 0x80000000)) );
+		
+		passed = _mm256_or_si256( _mm256_cmpgt_epi32(_mm256_xor_si256(minDepth, signBit), depthS), _mm256_cmpgt_epi32(depthS, _mm256_xor_si256(maxDepth, signBit)) );
+		passed = _mm256_xor_si256(passed, _mm256_set1_epi32(0xFFFFFFFF));
+	}
+	else
+	{
+		const v256u32 dstDepthS = _mm256_xor_si256(dstDepth, signBit);
+		passed = _mm256_cmpgt_epi32(dstDepthS, depthS); // LESS
+		
+		if (ISFRONTFACING)
 		{
-			dstAttributeStencil = 1;
+			const v256u32 dstFacing = _mm256_cvtepu8_epi32( _mm_loadl_epi64((v128u8 *)dstAttrPolyFacing) );
+			const v256u32 dstAlpha = _mm256_srli_epi32( _mm256_loadu_si256((v256u32 *)dst), 24 );
+			const v256u32 useLEqual = _mm256_and_si256( _mm256_cmpeq_epi32(dstFacing, _mm256_set1_epi32(PolyFacing_Back)), _mm256_cmpeq_epi32(dstAlpha, _mm256_set1_epi32(0x1F)) );
+			const v256u32 passedLEqual = _mm256_xor_si256( _mm256_cmpgt_epi32(depthS, dstDepthS), _mm256_set1_epi32(0xFFFFFFFF) );
+			passed = _mm256_blendv_epi8(passed, passedLEqual, useLEqual);
 		}
-		return;
 	}
 	
+	passMask = (u32)_mm256_movemask_ps(_mm256_castsi256_ps(passed));
+	
+#elif defined(ENABLE_SSE2)
+	// depth = (u32)(z / (1LL << (Z_EXTRAPRECISION + 7))) & 0xFFFFFFFE, rounding toward zero
+	const __m128i zStep2 = _mm_set1_epi64x(zStep * 2);
+	const __m128i zRoundBias = _mm_set1_epi64x((1LL << (Z_EXTRAPRECISION + 7)) - 1);
+	__m128i z0 = _mm_set_epi64x(zFirst + zStep, zFirst);
+	__m128i z1 = _mm_add_epi64(z0, zStep2);
+	
+	z0 = _mm_add_epi64( z0, _mm_and_si128(_mm_shuffle_epi32(_mm_srai_epi32(z0, 31), 0xF5), zRoundBias) );
+	z1 = _mm_add_epi64( z1, _mm_and_si128(_mm_shuffle_epi32(_mm_srai_epi32(z1, 31), 0xF5), zRoundBias) );
+	z0 = _mm_shuffle_epi32(_mm_srli_epi64(z0, Z_EXTRAPRECISION + 7), 0x08);
+	z1 = _mm_shuffle_epi32(_mm_srli_epi64(z1, Z_EXTRAPRECISION + 7), 0x08);
+	const v128u32 depth = _mm_and_si128( _mm_unpacklo_epi64(z0, z1), _mm_set1_epi32(0xFFFFFFFE) );
+	_mm_store_si128((v128u32 *)outDepth, depth);
+	
+	// SIMD only has signed comparisons, so flip the sign bits in order to do unsigned comparisons.
+	const v128u32 signBit = _mm_set1_epi32(0x80000000);
+	const v128u32 dstDepth = _mm_loadu_si128((v128u32 *)dstAttrDepth);
+	const v128u32 depthS = _mm_xor_si128(depth, signBit);
+	v128u32 passed;
+	
+	if (polyAttr.DepthEqualTest_Enable)
+	{
+		const v128u32 minDepthTemp = _mm_sub_epi32(dstDepth, _mm_set1_epi32(DEPTH_EQUALS_TEST_TOLERANCE));
+		const v128u32 minDepth = _mm_andnot_si128(_mm_srai_epi32(minDepthTemp, 31), minDepthTemp);
+		const v128u32 maxDepthTemp = _mm_add_epi32(dstDepth, _mm_set1_epi32(DEPTH_EQUALS_TEST_TOLERANCE));
+		const v128u32 maxDepthClamp = _mm_cmpgt_epi32(_mm_xor_si128(maxDepthTemp, signBit), _mm_set1_epi32(0x00FFFFFF ^ 0x80000000));
+		const v128u32 maxDepth = _mm_or_si128( _mm_and_si128(maxDepthClamp, _mm_set1_epi32(0x00FFFFFF)), _mm_andnot_si128(maxDepthClamp, maxDepthTemp) );
+		
+		passed = _mm_or_si128( _mm_cmpgt_epi32(_mm_xor_si128(minDepth, signBit), depthS), _mm_cmpgt_epi32(depthS, _mm_xor_si128(maxDepth, signBit)) );
+		passed = _mm_xor_si128(passed, _mm_set1_epi32(0xFFFFFFFF));
+	}
+	else
+	{
+		const v128u32 dstDepthS = _mm_xor_si128(dstDepth, signBit);
+		passed = _mm_cmpgt_epi32(dstDepthS, depthS); // LESS
+		
+		if (ISFRONTFACING)
+		{
+			v128u32 dstFacing = _mm_cvtsi32_si128( *(s32 *)dstAttrPolyFacing );
+			dstFacing = _mm_unpacklo_epi16( _mm_unpacklo_epi8(dstFacing, _mm_setzero_si128()), _mm_setzero_si128() );
+			const v128u32 dstAlpha = _mm_srli_epi32( _mm_loadu_si128((v128u32 *)dst), 24 );
+			const v128u32 useLEqual = _mm_and_si128( _mm_cmpeq_epi32(dstFacing, _mm_set1_epi32(PolyFacing_Back)), _mm_cmpeq_epi32(dstAlpha, _mm_set1_epi32(0x1F)) );
+			const v128u32 passedLEqual = _mm_xor_si128( _mm_cmpgt_epi32(depthS, dstDepthS), _mm_set1_epi32(0xFFFFFFFF) );
+			passed = _mm_or_si128( _mm_and_si128(useLEqual, passedLEqual), _mm_andnot_si128(useLEqual, passed) );
+		}
+	}
+	
+	passMask = (u32)_mm_movemask_ps(_mm_castsi128_ps(passed));
+	
+#elif defined(ENABLE_NEON_A64)
+	// depth = (u32)(z / (1LL << (Z_EXTRAPRECISION + 7))) & 0xFFFFFFFE, rounding toward zero
+	const int64x2_t zRoundBias = vdupq_n_s64((1LL << (Z_EXTRAPRECISION + 7)) - 1);
+	int64x2_t z0 = vcombine_s64( vcreate_s64((u64)zFirst), vcreate_s64((u64)(zFirst + zStep)) );
+	int64x2_t z1 = vaddq_s64( z0, vdupq_n_s64(zStep * 2) );
+	
+	z0 = vshrq_n_s64( vaddq_s64(z0, vandq_s64(vshrq_n_s64(z0, 63), zRoundBias)), Z_EXTRAPRECISION + 7 );
+	z1 = vshrq_n_s64( vaddq_s64(z1, vandq_s64(vshrq_n_s64(z1, 63), zRoundBias)), Z_EXTRAPRECISION + 7 );
+	const uint32x4_t depth = vandq_u32( vcombine_u32(vmovn_u64(vreinterpretq_u64_s64(z0)), vmovn_u64(vreinterpretq_u64_s64(z1))), vdupq_n_u32(0xFFFFFFFE) );
+	vst1q_u32(outDepth, depth);
+	
+	const uint32x4_t dstDepth = vld1q_u32(dstAttrDepth);
+	uint32x4_t passed;
+	
+	if (polyAttr.DepthEqualTest_Enable)
+	{
+		const int32x4_t minDepthTemp = vsubq_s32( vreinterpretq_s32_u32(dstDepth), vdupq_n_s32(DEPTH_EQUALS_TEST_TOLERANCE) );
+		const uint32x4_t minDepth = vreinterpretq_u32_s32( vmaxq_s32(minDepthTemp, vdupq_n_s32(0)) );
+		const uint32x4_t maxDepth = vminq_u32( vaddq_u32(dstDepth, vdupq_n_u32(DEPTH_EQUALS_TEST_TOLERANCE)), vdupq_n_u32(0x00FFFFFF) );
+		passed = vandq_u32( vcgeq_u32(depth, minDepth), vcleq_u32(depth, maxDepth) );
+	}
+	else
+	{
+		passed = vcltq_u32(depth, dstDepth); // LESS
+		
+		if (ISFRONTFACING)
+		{
+			const uint32x4_t dstFacing = vmovl_u16( vget_low_u16(vmovl_u8(vcreate_u8((u64)*(u32 *)dstAttrPolyFacing))) );
+			const uint32x4_t dstAlpha = vshrq_n_u32( vld1q_u32((u32 *)dst), 24 );
+			const uint32x4_t useLEqual = vandq_u32( vceqq_u32(dstFacing, vdupq_n_u32(PolyFacing_Back)), vceqq_u32(dstAlpha, vdupq_n_u32(0x1F)) );
+			passed = vbslq_u32(useLEqual, vcleq_u32(depth, dstDepth), passed);
+		}
+	}
+	
+	static const u32 laneBit[4] = {1, 2, 4, 8};
+	passMask = vaddvq_u32( vandq_u32(passed, vld1q_u32(laneBit)) );
+#endif
+	
+	return passMask;
+}
+#endif // SOFTRASTERIZER_DEPTH_SPAN_LANES
+
+template<bool RENDERER> template<bool ISFRONTFACING, bool ISSHADOWPOLYGON>
+FORCEINLINE void RasterizerUnit<RENDERER>::_pixelAfterDepthTest(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, const u32 depth, const Color4u8 &vtxColor, const Vector2s32 texCoord, const size_t fragmentIndex, Color4u8 &dstColor)
+{
+	const GFX3D_State &renderState = *this->_softRender->currentRenderState;
+	
+	u32 &dstAttributeDepth				= this->_softRender->_framebufferAttributes->depth[fragmentIndex];
+	u8 &dstAttributeOpaquePolyID		= this->_softRender->_framebufferAttributes->opaquePolyID[fragmentIndex];
+	u8 &dstAttributeTranslucentPolyID	= this->_softRender->_framebufferAttributes->translucentPolyID[fragmentIndex];
+	u8 &dstAttributeStencil				= this->_softRender->_framebufferAttributes->stencil[fragmentIndex];
+	u8 &dstAttributeIsFogged			= this->_softRender->_framebufferAttributes->isFogged[fragmentIndex];
+	u8 &dstAttributeIsTranslucentPoly	= this->_softRender->_framebufferAttributes->isTranslucentPoly[fragmentIndex];
+	u8 &dstAttributePolyFacing			= this->_softRender->_framebufferAttributes->polyFacing[fragmentIndex];
+	
 	//handle shadow polys
 	if (ISSHADOWPOLYGON)
 	{
@@ -783,6 +940,22 @@ FORCEINLINE void RasterizerUnit<RENDERER>::_pixel(const POLYGON_ATTR polyAttr, c
 	}
 }
 
+template<bool RENDERER> template<bool ISFRONTFACING, bool ISSHADOWPOLYGON>
+FORCEINLINE void RasterizerUnit<RENDERER>::_pixel(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, const u32 depth, const Color4u8 &vtxColor, const Vector2s32 texCoord, const size_t fragmentIndex, Color4u8 &dstColor)
+{
+	if (!this->_depthTest<ISFRONTFACING>(polyAttr, depth, fragmentIndex, dstColor))
+	{
+		//shadow mask polygons set stencil bit here
+		if (ISSHADOWPOLYGON && polyAttr.PolygonID == 0)
+		{
+			this->_softRender->_framebufferAttributes->stencil[fragmentIndex] = 1;
+		}
+		return;
+	}
+	
+	this->_pixelAfterDepthTest<ISFRONTFACING, ISSHADOWPOLYGON>(polyAttr, isPolyTranslucent, depth, vtxColor, texCoord, fragmentIndex, dstColor);
+}
+
 //draws a single scanline
 template<bool RENDERER> template<bool ISFRONTFACING, bool ISSHADOWPOLYGON, bool USELINEHACK>
 FORCEINLINE void RasterizerUnit<RENDERER>::_drawscanline(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, Color4u8 *dstColor, const size_t framebufferWidth, const size_t framebufferHeight, const edge_fx_fl &pLeft, const edge_fx_fl &pRight)
@@ -943,6 +1116,80 @@ FORCEINLINE void RasterizerUnit<RENDERER>::_drawscanline(const POLYGON_ATTR poly
 	Color4u8 vtxColor;
 	Vector2s32 texCoord;
 	
+#ifdef SOFTRASTERIZER_DEPTH_SPAN_LANES
+	if ( !this->_softRender->currentRenderState->SWAP_BUFFERS.DepthMode && !this->_softRender->_enableFragmentSamplingHack )
+	{
+		// When using Z-depth without the fragment sampling hack, every interpolated value is a plain
+		// integer that is stepped by a constant, so the value at any fragment is simply the start value
+		// plus its step times the fragment offset. This lets us run the depth test on a whole group of
+		// fragments at once, and then only do the per-fragment divisions for the vertex color and
+		// texture coordinates on the fragments that actually passed the depth test.
+		CACHE_ALIGN u32 spanDepth[SOFTRASTERIZER_DEPTH_SPAN_LANES];
+		u8 *dstAttributeStencil = this->_softRender->_framebufferAttributes->stencil;
+		
+		for (s32 spanOffset = 0; spanOffset < rasterWidth; spanOffset += SOFTRASTERIZER_DEPTH_SPAN_LANES)
+		{
+			const size_t spanAdr = adr + spanOffset;
+			const size_t laneCount = std::min<size_t>(SOFTRASTERIZER_DEPTH_SPAN_LANES, rasterWidth - spanOffset);
+			u32 passMask = 0;
+			
+			if (laneCount == SOFTRASTERIZER_DEPTH_SPAN_LANES)
+			{
+				passMask = this->_depthTestSpanZ<ISFRONTFACING>(polyAttr, zInterpolated + (zInterpolated_dx * spanOffset), zInterpolated_dx, spanAdr, dstColor, spanDepth);
+			}
+			else
+			{
+				for (size_t lane = 0; lane < laneCount; lane++)
+				{
+					spanDepth[lane] = (u32)((zInterpolated + (zInterpolated_dx * (spanOffset + (s64)lane))) / (1LL << (Z_EXTRAPRECISION + 7))) & 0xFFFFFFFE;
+					passMask |= (this->_depthTest<ISFRONTFACING>(polyAttr, spanDepth[lane], spanAdr + lane, dstColor[spanAdr + lane])) ? (1 << lane) : 0;
+				}
+			}
+			
+			if (ISSHADOWPOLYGON && polyAttr.PolygonID == 0)
+			{
+				//shadow mask polygons set stencil bit here
+				for (size_t lane = 0; lane < laneCount; lane++)
+				{
+					if ( (passMask & (1 << lane)) == 0 )
+					{
+						dstAttributeStencil[spanAdr + lane] = 1;
+					}
+				}
+			}
+			
+			for (size_t lane = 0; passMask != 0; lane++, passMask >>= 1)
+			{
+				if ( (passMask & 1) == 0 )
+				{
+					continue;
+				}
+				
+				const s64 n = spanOffset + (s64)lane;
+				const s64 invW = invWInterpolated + (invWInterpolated_dx * n);
+				
+				vtxColor.r = std::max<u8>( 0x00, (u8)std::min<s64>(0x3F, (vtxColorInterpolated.r + (vtxColorInterpolated_dx.r * n)) / invW) );
+				vtxColor.g = std::max<u8>( 0x00, (u8)std::min<s64>(0x3F, (vtxColorInterpolated.g + (vtxColorInterpolated_dx.g * n)) / invW) );
+				vtxColor.b = std::max<u8>( 0x00, (u8)std::min<s64>(0x3F, (vtxColorInterpolated.b + (vtxColorInterpolated_dx.b * n)) / invW) );
+				vtxColor.a = vtxColorInterpolated.a;
+				
+				texCoord.s = (s32)((texCoordInterpolated.s + (texCoordInterpolated_dx.s * n)) * texScalingFactor / invW);
+				texCoord.t = (s32)((texCoordInterpolated.t + (texCoordInterpolated_dx.t * n)) * texScalingFactor / invW);
+				
+				this->_pixelAfterDepthTest<ISFRONTFACING, ISSHADOWPOLYGON>(polyAttr,
+																		   isPolyTranslucent,
+																		   spanDepth[lane],
+																		   vtxColor,
+																		   texCoord,
+																		   spanAdr + lane,
+																		   dstColor[spanAdr + lane]);
+			}
+		}
+		
+		return;
+	}
+#endif
+	
 	while (rasterWidth-- > 0)
 	{
 		if (this->_softRender->currentRenderState->SWAP_BUFFERS.DepthMode)
@@ -1280,10 +1527,11 @@ void RasterizerUnit<RENDERER>::SetRenderer(SoftRasterizerRenderer *theRenderer)
 }
 
 template<bool RENDERER> template <bool SLI, bool USELINEHACK>
-FORCEINLINE void RasterizerUnit<RENDERER>::Render()
+void RasterizerUnit<RENDERER>::_RenderPolygonList(const u32 *polyIndexList, const size_t polyCount)
 {
-	const size_t clippedPolyCount = this->_softRender->GetClippedPolyCount();
-	if (clippedPolyCount == 0)
+	// If polyIndexList is NULL, then every clipped polygon from 0 to polyCount-1 is rendered.
+	// Otherwise, only the clipped polygons listed in polyIndexList are rendered, in list order.
+	if (polyCount == 0)
 	{
 		return;
 	}
@@ -1295,17 +1543,20 @@ FORCEINLINE void RasterizerUnit<RENDERER>::Render()
 	const SoftRasterizerPrecalculation *softRastPrecalc = this->_softRender->GetPrecalculationList();
 	
 	const POLY *rawPolyList = this->_softRender->GetRawPolyList();
-	const CPoly &firstClippedPoly = this->_softRender->GetClippedPolyByIndex(0);
+	const size_t firstPolyIndex = (polyIndexList != NULL) ? polyIndexList[0] : 0;
+	const CPoly &firstClippedPoly = this->_softRender->GetClippedPolyByIndex(firstPolyIndex);
 	const POLY &firstPoly = rawPolyList[firstClippedPoly.index];
 	POLYGON_ATTR polyAttr = firstPoly.attribute;
 	TEXIMAGE_PARAM lastTexParams = firstPoly.texParam;
 	u32 lastTexPalette = firstPoly.texPalette;
 	
-	this->_SetupTexture(firstPoly, 0);
+	this->_SetupTexture(firstPoly, firstPolyIndex);
 
 	//iterate over polys
-	for (size_t i = 0; i < clippedPolyCount; i++)
+	for (size_t listIndex = 0; listIndex < polyCount; listIndex++)
 	{
+		const size_t i = (polyIndexList != NULL) ? polyIndexList[listIndex] : listIndex;
+		
 		if (!RENDERER) _debug_thisPoly = (i == this->_softRender->_debug_drawClippedUserPoly);
 		
 		const CPoly &clippedPoly = this->_softRender->GetClippedPolyByIndex(i);
@@ -1388,6 +1639,27 @@ FORCEINLINE void RasterizerUnit<RENDERER>::Render()
 	}
 }
 
+template<bool RENDERER> template <bool SLI, bool USELINEHACK>
+FORCEINLINE void RasterizerUnit<RENDERER>::Render()
+{
+	this->_RenderPolygonList<SLI, USELINEHACK>(NULL, this->_softRender->GetClippedPolyCount());
+}
+
+template<bool RENDERER> template <bool USELINEHACK>
+void RasterizerUnit<RENDERER>::RenderTiles()
+{
+	// Keep pulling tiles from the renderer's shared queue until none are left. Since each
+	// tile owns a distinct set of lines and its polygon list keeps the original rendering
+	// order, the result is identical to rendering every polygon over the whole framebuffer.
+	SoftRasterizerTile tile;
+	
+	while (this->_softRender->FetchNextTile(tile))
+	{
+		this->SetSLI(tile.startLine, tile.endLine, false);
+		this->_RenderPolygonList<true, USELINEHACK>(tile.polyIndexList, tile.polyCount);
+	}
+}
+
 template <bool USELINEHACK>
 void* _HACK_Viewer_ExecUnit(void *arg)
 {
@@ -1406,6 +1678,15 @@ void* SoftRasterizer_RunRasterizerUnit(void *arg)
 	return 0;
 }
 
+template <bool USELINEHACK>
+void* SoftRasterizer_RunRasterizerTiles(void *arg)
+{
+	RasterizerUnit<true> *unit = (RasterizerUnit<true> *)arg;
+	unit->RenderTiles<USELINEHACK>();
+	
+	return 0;
+}
+
 static void* SoftRasterizer_RunGetAndLoadAllTextures(void *arg)
 {
 	SoftRasterizerRenderer *softRender = (SoftRasterizerRenderer *)arg;
@@ -1419,6 +1700,10 @@ static void* SoftRasterizer_RunRasterizerPrecalculate(void *arg)
 	SoftRasterizerRenderer *softRender = (SoftRasterizerRenderer *)arg;
 	softRender->RasterizerPrecalculate();
 	
+	// This is only ever run when multithreading is enabled, which is also the only
+	// time that the geometry needs to be binned into tiles.
+	softRender->RasterizerBinPolygons();
+	
 	return NULL;
 }
 
@@ -1938,6 +2223,15 @@ SoftRasterizerRenderer::SoftRasterizerRenderer()
 	_clippedPolyList = (CPoly *)malloc_alignedCacheLine(CLIPPED_POLYLIST_SIZE * sizeof(CPoly));
 	_precalc = (SoftRasterizerPrecalculation *)malloc_alignedCacheLine(CLIPPED_POLYLIST_SIZE * MAX_CLIPPED_VERTS * sizeof(SoftRasterizerPrecalculation));
 	
+	_tileLineCount = _framebufferHeight;
+	_tileCount = 0;
+	_tileNextIndex = 0;
+	memset(_tileBinStart, 0, sizeof(_tileBinStart));
+	memset(_tileBinCursor, 0, sizeof(_tileBinCursor));
+	_tileBinPolyList = NULL;
+	_tileBinPolyListCapacity = 0;
+	_polyTileRange = (u8 *)malloc_alignedCacheLine(CLIPPED_POLYLIST_SIZE * 2 * sizeof(u8));
+	
 	_task = NULL;
 	
 	_debug_drawClippedUserPoly = 0;
@@ -2009,21 +2303,7 @@ SoftRasterizerRenderer::SoftRasterizerRenderer()
 			_rasterizerUnit[i].SetSLI(_threadPostprocessParam[i].startLine, _threadPostprocessParam[i].endLine, false);
 			_rasterizerUnit[i].SetRenderer(this);
 			
-			char name[16];
-			snprintf(name, 16, "rasterizer %d", (int)i);
-			
-#ifdef DESMUME_COCOA
-			if (coreCount > 1)
-			{
-				// The Cocoa port takes advantage of hand-optimized thread priorities
-				// to help stabilize performance when running SoftRasterizer.
-				_task[i].start(false, 43, name);
-			}
-			else
-#endif
-			{
-				_task[i].start(false, 0, name);
-			}
+			_task[i].start(TaskGroup_Rasterizer, false);
 		}
 	}
 	
@@ -2038,8 +2318,8 @@ SoftRasterizerRenderer::SoftRasterizerRenderer()
 	}
 	else
 	{
-		printf("SoftRasterizer: Running using %d additional %s. (Multithreading enabled.)\n",
-			   (int)_threadCount, (_threadCount == 1) ? "thread" : "threads");
+		printf("SoftRasterizer: Running %d %s on the shared task pool. (Multithreading enabled.)\n",
+			   (int)_threadCount, (_threadCount == 1) ? "task" : "tasks");
 	}
 }
 
@@ -2063,6 +2343,13 @@ SoftRasterizerRenderer::~SoftRasterizerRenderer()
 	free_aligned(this->_precalc);
 	this->_precalc = NULL;
 	
+	free_aligned(this->_tileBinPolyList);
+	this->_tileBinPolyList = NULL;
+	this->_tileBinPolyListCapacity = 0;
+	
+	free_aligned(this->_polyTileRange);
+	this->_polyTileRange = NULL;
+	
 	free_aligned(this->_clippedPolyList);
 	this->_clippedPolyList = NULL;
 }
@@ -2174,6 +2461,106 @@ void SoftRasterizerRenderer::RasterizerPrecalculate()
 	}
 }
 
+void SoftRasterizerRenderer::RasterizerBinPolygons()
+{
+	// Split the framebuffer into bands of lines, with a few bands per thread so that
+	// the rasterizer threads can balance out uneven geometry between themselves.
+	if (this->_threadCount == 0)
+	{
+		return;
+	}
+	
+	const size_t h = this->_framebufferHeight;
+	const size_t tileTarget = this->_threadCount * SOFTRASTERIZER_TILES_PER_THREAD;
+	const size_t tileLineCount = (h + tileTarget - 1) / tileTarget;
+	const size_t tileCount = (h + tileLineCount - 1) / tileLineCount;
+	
+	this->_tileLineCount = tileLineCount;
+	this->_tileCount = tileCount;
+	memset(this->_tileBinStart, 0, (tileCount + 1) * sizeof(u32));
+	
+	// First pass: Find the range of tiles that each polygon touches, and count the number
+	// of polygons in each tile. A polygon can only ever draw lines between its topmost and
+	// bottommost vertices, so the vertex bounds are always enough to contain it.
+	for (size_t i = 0; i < this->_clippedPolyCount; i++)
+	{
+		const CPoly &cPoly = this->_clippedPolyList[i];
+		const SoftRasterizerPrecalculation *precalc = &this->_precalc[i * MAX_CLIPPED_VERTS];
+		s64 yMin = precalc[0].positionCeil.y;
+		s64 yMax = precalc[0].positionCeil.y;
+		
+		for (size_t j = 1; j < (size_t)cPoly.type; j++)
+		{
+			yMin = std::min<s64>(yMin, precalc[j].positionCeil.y);
+			yMax = std::max<s64>(yMax, precalc[j].positionCeil.y);
+		}
+		
+		u8 &firstTile = this->_polyTileRange[(i * 2) + 0];
+		u8 &lastTile  = this->_polyTileRange[(i * 2) + 1];
+		
+		if ( (yMax < 0) || (yMin >= (s64)h) )
+		{
+			// No lines of this polygon are in the framebuffer, so don't bin it anywhere.
+			firstTile = 1;
+			lastTile = 0;
+			continue;
+		}
+		
+		yMin = std::max<s64>(yMin, 0);
+		yMax = std::min<s64>(yMax, (s64)h - 1);
+		firstTile = (u8)((size_t)yMin / tileLineCount);
+		lastTile  = (u8)((size_t)yMax / tileLineCount);
+		
+		for (size_t t = firstTile; t <= lastTile; t++)
+		{
+			this->_tileBinStart[t + 1]++;
+		}
+	}
+	
+	for (size_t t = 0; t < tileCount; t++)
+	{
+		this->_tileBinStart[t + 1] += this->_tileBinStart[t];
+		this->_tileBinCursor[t] = this->_tileBinStart[t];
+	}
+	
+	const size_t binnedPolyCount = this->_tileBinStart[tileCount];
+	if (binnedPolyCount > this->_tileBinPolyListCapacity)
+	{
+		free_aligned(this->_tileBinPolyList);
+		this->_tileBinPolyListCapacity = std::max<size_t>(binnedPolyCount, CLIPPED_POLYLIST_SIZE);
+		this->_tileBinPolyList = (u32 *)malloc_alignedCacheLine(this->_tileBinPolyListCapacity * sizeof(u32));
+	}
+	
+	// Second pass: Fill in each tile's polygon list. Polygons are visited in order, so
+	// each tile's list keeps the same rendering order as the full clipped polygon list.
+	for (size_t i = 0; i < this->_clippedPolyCount; i++)
+	{
+		const size_t firstTile = this->_polyTileRange[(i * 2) + 0];
+		const size_t lastTile  = this->_polyTileRange[(i * 2) + 1];
+		
+		for (size_t t = firstTile; t <= lastTile; t++)
+		{
+			this->_tileBinPolyList[this->_tileBinCursor[t]++] = (u32)i;
+		}
+	}
+}
+
+bool SoftRasterizerRenderer::FetchNextTile(SoftRasterizerTile &outTile)
+{
+	const s32 tileIndex = atomic_inc_barrier32(&this->_tileNextIndex) - 1;
+	if (tileIndex >= (s32)this->_tileCount)
+	{
+		return false;
+	}
+	
+	outTile.startLine = (size_t)tileIndex * this->_tileLineCount;
+	outTile.endLine = std::min<size_t>(outTile.startLine + this->_tileLineCount, this->_framebufferHeight);
+	outTile.polyIndexList = this->_tileBinPolyList + this->_tileBinStart[tileIndex];
+	outTile.polyCount = this->_tileBinStart[tileIndex + 1] - this->_tileBinStart[tileIndex];
+	
+	return true;
+}
+
 Render3DError SoftRasterizerRenderer::ApplyRenderingSettings(const GFX3D_State &renderState)
 {
 	this->_enableHighPrecisionColorInterpolation = CommonSettings.GFX3D_HighResolutionInterpolateColor;
@@ -2240,18 +2627,21 @@ Render3DError SoftRasterizerRenderer::RenderGeometry()
 	// Render the geometry
 	if (this->_threadCount > 0)
 	{
+		// All threads consume tiles from the same queue, which was binned in BeginRender().
+		this->_tileNextIndex = 0;
+		
 		if (this->_enableLineHack)
 		{
 			for (size_t i = 0; i < this->_threadCount; i++)
 			{
-				this->_task[i].execute(&SoftRasterizer_RunRasterizerUnit<true>, &this->_rasterizerUnit[i]);
+				this->_task[i].execute(&SoftRasterizer_RunRasterizerTiles<true>, &this->_rasterizerUnit[i]);
 			}
 		}
 		else
 		{
 			for (size_t i = 0; i < this->_threadCount; i++)
 			{
-				this->_task[i].execute(&SoftRasterizer_RunRasterizerUnit<false>, &this->_rasterizerUnit[i]);
+				this->_task[i].execute(&SoftRasterizer_RunRasterizerTiles<false>, &this->_rasterizerUnit[i]);
 			}
 		}
 		
@@ -23,6 +23,8 @@
 
 
 #define SOFTRASTERIZER_MAX_THREADS 32
+#define SOFTRASTERIZER_TILES_PER_THREAD 4
+#define SOFTRASTERIZER_MAX_TILES (SOFTRASTERIZER_MAX_THREADS * SOFTRASTERIZER_TILES_PER_THREAD)
 
 extern GPU3DInterface gpu3DRasterize;
 
@@ -55,6 +57,16 @@ struct SoftRasterizerClearParam
 	size_t endPixel;
 };
 
+// A tile is a band of framebuffer lines, along with the list of clipped polygon
+// indices that touch it. Polygon indices are stored in rendering order.
+struct SoftRasterizerTile
+{
+	size_t startLine;
+	size_t endLine;
+	const u32 *polyIndexList;
+	size_t polyCount;
+};
+
 struct SoftRasterizerPostProcessParams
 {
 	SoftRasterizerRenderer *renderer;
@@ -146,6 +158,9 @@ protected:
 	FORCEINLINE float _round_s(const float val);
 	
 	template<bool ISSHADOWPOLYGON> FORCEINLINE void _shade(const PolygonMode polygonMode, const Color4u8 vtxColor, const Vector2s32 &texCoord, Color4u8 &outColor);
+	template<bool ISFRONTFACING> FORCEINLINE bool _depthTest(const POLYGON_ATTR polyAttr, const u32 depth, const size_t fragmentIndex, const Color4u8 &dstColor);
+	template<bool ISFRONTFACING> FORCEINLINE u32 _depthTestSpanZ(const POLYGON_ATTR polyAttr, const s64 zFirst, const s64 zStep, const size_t fragmentIndex, const Color4u8 *dstColor, u32 *outDepth);
+	template<bool ISFRONTFACING, bool ISSHADOWPOLYGON> FORCEINLINE void _pixelAfterDepthTest(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, const u32 depth, const Color4u8 &vtxColor, const Vector2s32 texCoord, const size_t fragmentIndex, Color4u8 &dstColor);
 	template<bool ISFRONTFACING, bool ISSHADOWPOLYGON> FORCEINLINE void _pixel(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, const u32 depth, const Color4u8 &vtxColor, const Vector2s32 texCoord, const size_t fragmentIndex, Color4u8 &dstColor);
 	template<bool ISFRONTFACING, bool ISSHADOWPOLYGON, bool USELINEHACK> FORCEINLINE void _drawscanline(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, Color4u8 *dstColor, const size_t framebufferWidth, const size_t framebufferHeight, const edge_fx_fl &pLeft, const edge_fx_fl &pRight);
 	template<bool SLI, bool ISFRONTFACING, bool ISSHADOWPOLYGON, bool USELINEHACK> void _runscanlines(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, Color4u8 *dstColor, const size_t framebufferWidth, const size_t framebufferHeight, const bool isHorizontal, edge_fx_fl &left, edge_fx_fl &right);
@@ -153,11 +168,13 @@ protected:
 	template<int TYPE> FORCEINLINE void _rot_verts();
 	template<bool ISFRONTFACING, int TYPE> void _sort_verts();
 	template<bool SLI, bool ISFRONTFACING, bool ISSHADOWPOLYGON, bool USELINEHACK> void _shape_engine(const POLYGON_ATTR polyAttr, const bool isPolyTranslucent, Color4u8 *dstColor, const size_t framebufferWidth, const size_t framebufferHeight, int type);
+	template<bool SLI, bool USELINEHACK> void _RenderPolygonList(const u32 *polyIndexList, const size_t polyCount);
 	
 public:
 	void SetSLI(const size_t startLine, const size_t endLine, bool debug);
 	void SetRenderer(SoftRasterizerRenderer *theRenderer);
 	template<bool SLI, bool USELINEHACK> FORCEINLINE void Render();
+	template<bool USELINEHACK> void RenderTiles();
 };
 
 #if defined(ENABLE_AVX2)
@@ -191,6 +208,15 @@ protected:
 	
 	SoftRasterizerPrecalculation *_precalc;
 	
+	size_t _tileLineCount;
+	size_t _tileCount;
+	volatile s32 _tileNextIndex;
+	u32 _tileBinStart[SOFTRASTERIZER_MAX_TILES + 1];
+	u32 _tileBinCursor[SOFTRASTERIZER_MAX_TILES];
+	u32 *_tileBinPolyList;
+	size_t _tileBinPolyListCapacity;
+	u8 *_polyTileRange;
+	
 	u8 _fogTable[32768];
 	Color4u8 _edgeMarkTable[8];
 	bool _edgeMarkDisabled[8];
@@ -227,6 +253,8 @@ public:
 	
 	void GetAndLoadAllTextures();
 	void RasterizerPrecalculate();
+	void RasterizerBinPolygons();
+	bool FetchNextTile(SoftRasterizerTile &outTile);
 	Render3DError RenderEdgeMarkingAndFog(const SoftRasterizerPostProcessParams &param);
 	
 	SoftRasterizerTexture* GetLoadedTextureFromPolygon(const POLY &thePoly, bool enableTexturing);
@@ -0,0 +1,269 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "rewind.h"
+
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "NDSSystem.h"
+#include "saves.h"
+#include "emufile.h"
+
+//one minute at 60fps
+#define REWIND_HISTORY_FRAMES 3600
+
+struct RewindSlot
+{
+	//the snapshot that came before the next newer one, xored against it and packed.
+	//empty while the slot is unused.
+	std::vector<u8> delta;
+	u32 length;        //length of the snapshot itself
+	u32 packedLength;  //length of the packed delta before deflating
+	bool deflated;
+};
+
+static std::vector<RewindSlot*> ring;
+static u32 ringHead = 0;    //oldest slot
+static u32 ringCount = 0;
+static u32 ringInterval = 0;
+static u32 frameCounter = 0;
+
+static std::vector<u8> current; //the newest snapshot, whole
+static std::vector<u8> newest;
+static std::vector<u8> packed;
+
+static u64 deltaBytes = 0;  //capacity of all the slots' deltas
+static RewindStats stats;
+
+//word i of a snapshot, zero padded past its end
+static FORCEINLINE u64 rewind_word(const std::vector<u8> &buf, size_t i)
+{
+	u64 word = 0;
+	if (i * 8 < buf.size())
+		memcpy(&word, &buf[i * 8], std::min<size_t>(8, buf.size() - i * 8));
+	return word;
+}
+
+//the delta is walked in 64bit words: runs of zero words are skipped and the words in between are
+//copied out, as <u32 zero words><u32 literal words><literal words>
+static void rewind_pack(const std::vector<u8> &older, const std::vector<u8> &newer, std::vector<u8> &out)
+{
+	const size_t len = std::max(older.size(), newer.size());
+	const size_t words = (len + 7) / 8;
+
+	out.resize(0);
+	size_t i = 0;
+	while (i < words)
+	{
+		const size_t zeroStart = i;
+		u64 word = 0;
+		while (i < words && (word = rewind_word(older, i) ^ rewind_word(newer, i)) == 0) i++;
+
+		const size_t at = out.size();
+		const size_t literalStart = i;
+		out.resize(at + 8);
+		while (i < words && word != 0)
+		{
+			out.resize(out.size() + 8);
+			memcpy(&out[out.size() - 8], &word, 8);
+			if (++i < words)
+				word = rewind_word(older, i) ^ rewind_word(newer, i);
+		}
+
+		const u32 header[2] = { (u32)(literalStart - zeroStart), (u32)(i - literalStart) };
+		memcpy(&out[at], header, sizeof(header));
+	}
+}
+
+//turns the newer snapshot in buf back into the older one
+static void rewind_unpack(const u8 *in, size_t inLength, u32 olderLength, std::vector<u8> &buf)
+{
+	const size_t words = (std::max((size_t)olderLength, buf.size()) + 7) / 8;
+	const size_t newerLength = buf.size();
+	buf.resize(words * 8);
+	memset(&buf[0] + newerLength, 0, buf.size() - newerLength);
+
+	u64 *w = (u64 *)&buf[0];
+	size_t i = 0;
+	const u8 *end = in + inLength;
+	while (in < end)
+	{
+		u32 header[2];
+		memcpy(header, in, sizeof(header));
+		in += sizeof(header);
+		i += header[0];
+		for (u32 n = 0; n < header[1]; n++, i++, in += 8)
+		{
+			u64 word;
+			memcpy(&word, in, 8);
+			w[i] ^= word;
+		}
+	}
+
+	buf.resize(olderLength);
+}
+
+static void rewind_configure()
+{
+	const u32 slots = (REWIND_HISTORY_FRAMES + CommonSettings.rewind_interval - 1) / CommonSettings.rewind_interval;
+
+	Rewind_Reset();
+	for (u32 i = 0; i < slots; i++)
+		ring.push_back(new RewindSlot());
+	ringInterval = CommonSettings.rewind_interval;
+}
+
+//frees a slot that has left the history, so that dropped deltas don't keep holding memory
+static void rewind_free_slot(RewindSlot &slot)
+{
+	deltaBytes -= slot.delta.capacity();
+	std::vector<u8>().swap(slot.delta);
+}
+
+static void rewind_drop_oldest()
+{
+	rewind_free_slot(*ring[ringHead]);
+	ringHead = (ringHead + 1) % ring.size();
+	ringCount--;
+}
+
+//the budget covers everything rewind allocates: the deltas as well as the newest snapshot and the
+//working buffers, counted by capacity since that is what they actually hold on to
+static void rewind_update_buffered()
+{
+	stats.bufferedBytes = deltaBytes + current.capacity() + newest.capacity() + packed.capacity();
+}
+
+void Rewind_Push()
+{
+	if (CommonSettings.rewind_interval == 0)
+		return;
+	if (++frameCounter < CommonSettings.rewind_interval)
+		return;
+	frameCounter = 0;
+
+	if (ringInterval != CommonSettings.rewind_interval)
+		rewind_configure();
+
+	EMUFILE_MEMORY ms(&newest);
+	ms.truncate(0);
+	if (!savestate_save(ms, Z_NO_COMPRESSION))
+		return;
+	ms.truncate(ms.size());
+	//the savestate grows the buffer geometrically; don't keep the slack around for good
+	if (newest.capacity() > newest.size() + (newest.size() >> 4))
+		newest.shrink_to_fit();
+
+	stats.lastStateBytes = (u32)newest.size();
+
+	if (!current.empty())
+	{
+		if (ringCount == ring.size())
+			rewind_drop_oldest();
+
+		RewindSlot &slot = *ring[(ringHead + ringCount) % ring.size()];
+		rewind_pack(current, newest, packed);
+		slot.length = (u32)current.size();
+		slot.packedLength = (u32)packed.size();
+
+		uLongf deflatedLength = compressBound(slot.packedLength);
+		slot.delta.resize(deflatedLength);
+		slot.deflated = (compress2(&slot.delta[0], &deflatedLength, &packed[0], slot.packedLength, Z_BEST_SPEED) == Z_OK);
+		if (slot.deflated)
+			slot.delta.resize(deflatedLength);
+		else
+			slot.delta.assign(packed.begin(), packed.end());
+		slot.delta.shrink_to_fit();
+
+		ringCount++;
+		deltaBytes += slot.delta.capacity();
+		stats.lastStoredBytes = (u32)slot.delta.size();
+		stats.storedBytes += stats.lastStoredBytes;
+		stats.pushes++;
+	}
+
+	current.swap(newest);
+	rewind_update_buffered();
+
+	const u64 budget = (u64)CommonSettings.rewind_buffer_size << 20;
+	while (ringCount > 0 && stats.bufferedBytes > budget)
+	{
+		rewind_drop_oldest();
+		rewind_update_buffered();
+	}
+}
+
+bool Rewind_Step()
+{
+	if (current.empty())
+		return false;
+
+	EMUFILE_MEMORY ms(&current);
+	if (!savestate_load(ms))
+		return false;
+
+	if (ringCount > 0)
+	{
+		RewindSlot &slot = *ring[(ringHead + ringCount - 1) % ring.size()];
+		const u8 *in = &slot.delta[0];
+		if (slot.deflated)
+		{
+			uLongf packedLength = slot.packedLength;
+			packed.resize(slot.packedLength);
+			if (uncompress(&packed[0], &packedLength, in, (uLong)slot.delta.size()) != Z_OK || packedLength != slot.packedLength)
+			{
+				//shouldnt happen, but the rest of the history can't be trusted either
+				Rewind_Reset();
+				return true;
+			}
+			in = &packed[0];
+		}
+		rewind_unpack(in, slot.packedLength, slot.length, current);
+		rewind_free_slot(slot);
+		ringCount--;
+		rewind_update_buffered();
+	}
+
+	frameCounter = 0;
+	return true;
+}
+
+void Rewind_Reset()
+{
+	for (size_t i = 0; i < ring.size(); i++)
+		delete ring[i];
+	ring.clear();
+	ringHead = ringCount = 0;
+	ringInterval = 0;
+	frameCounter = 0;
+
+	std::vector<u8>().swap(current);
+	std::vector<u8>().swap(newest);
+	std::vector<u8>().swap(packed);
+	deltaBytes = 0;
+
+	memset(&stats, 0, sizeof(stats));
+}
+
+void Rewind_GetStats(RewindStats &outStats)
+{
+	outStats = stats;
+	outStats.snapshots = ringCount + (current.empty() ? 0 : 1);
+}
@@ -0,0 +1,52 @@
+/*
+	Copyright (C) 2025 DeSmuME team
+
+	This file is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 2 of the License, or
+	(at your option) any later version.
+
+	This file is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with the this software.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include "types.h"
+
+//In-memory rewind history.
+//Every CommonSettings.rewind_interval frames a savestate is taken. The newest one is kept whole, and each
+//older one is kept as the xor against the one after it, with its runs of zeroes squeezed out and the rest
+//deflated at the fastest level. The history covers about a minute and is also capped at
+//CommonSettings.rewind_buffer_size MB, which counts the working buffers too; the oldest snapshots are
+//dropped first, but the newest one is always kept.
+
+struct RewindStats
+{
+	u32 snapshots;        //snapshots currently held, including the newest one
+	u32 lastStateBytes;   //size of the last savestate taken
+	u32 lastStoredBytes;  //what the snapshot before it shrank to once it became a delta
+	u64 bufferedBytes;    //memory held by the history and its working buffers
+	u64 pushes;           //deltas made so far
+	u64 storedBytes;      //sum of lastStoredBytes over all of them, for bytes per snapshot
+};
+
+//call once per emulated frame; takes a snapshot when one is due. does nothing while rewind is disabled.
+void Rewind_Push();
+
+//loads the newest snapshot and drops it from the history, so that the next step goes further back.
+//the oldest snapshot is never dropped. returns false if there is nothing to go back to.
+bool Rewind_Step();
+
+//forgets the whole history, e.g. when another game is loaded
+void Rewind_Reset();
+
+void Rewind_GetStats(RewindStats &stats);
+
+#endif
@@ -1158,6 +1158,8 @@ static void writechunks(EMUFILE &os)
 
 	save_time_data = tm.get_Ticks();
 	
+	// The 2D engines may still be writing to their registers and framebuffers.
+	GPU->FinishPendingLineRender();
 	gfx3d_PrepareSaveStateBufferWrite();
 
 	savestate_WriteChunk(os,1,SF_ARM9);
@@ -1317,6 +1319,12 @@ static bool ReadStateChunks(EMUFILE &is, s32 totalsize)
 
 static void loadstate()
 {
+	// VRAM was just replaced, so anything that tracks VRAM changes needs to recheck it
+	MMU_VRAMMarkAllWritten();
+
+	// the sequencer's cached deadlines may not match the timer/dma/div state that was just loaded
+	NDS_RescheduleAll();
+	
     // This should regenerate the vram banks
     for (int i = 0; i < 0xA; i++)
        _MMU_write08<ARMCPU_ARM9>(0x04000240+i, _MMU_read08<ARMCPU_ARM9>(0x04000240+i));
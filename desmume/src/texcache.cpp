@@ -43,6 +43,9 @@
 //only dump this from ogl renderer. for now, softrasterizer creates things in an incompatible pixel format
 //#define DEBUG_DUMP_TEXTURE
 
+//always compare textures against VRAM, and report whenever the VRAM generation counters failed to notice a change
+//#define DEBUG_VERIFY_TEXTURE_VRAM_GENERATION
+
 #if defined(DEBUG_DUMP_TEXTURE) && defined(WIN32)
 	#define DO_DEBUG_DUMP_TEXTURE
 #endif
@@ -66,6 +69,7 @@ public:
 		u32 len;
 		u8* ptr;
 		u32 ofs; //offset within the memspan
+		u32 generation; //generation of the texture slot that ptr was taken from
 	} items[MAXSIZE];
 
 	int size;
@@ -88,6 +92,23 @@ public:
 		return 0;
 	}
 
+	//sums up the generation counters of the slots and VRAM pages covered by this MemSpan.
+	//the counters only ever increase, so if neither sum changed, then nothing was remapped or written to.
+	void generations(u64 &slotSum, u64 &pageSum) const
+	{
+		slotSum = 0;
+		pageSum = 0;
+		for(int i=0;i<numItems;i++)
+		{
+			const Item &item = items[i];
+			const size_t firstPage = (size_t)(item.ptr - MMU.ARM9_LCD) >> VRAM_GENERATION_PAGE_SHIFT;
+			const size_t lastPage = (size_t)(item.ptr + item.len - 1 - MMU.ARM9_LCD) >> VRAM_GENERATION_PAGE_SHIFT;
+			slotSum += item.generation;
+			for(size_t page = firstPage; page <= lastPage; page++)
+				pageSum += MMU.vramPageGeneration[page];
+		}
+	}
+
 	//TODO - get rid of duplication between these two methods.
 
 	//dumps the memspan to the specified buffer
@@ -161,6 +182,7 @@ static MemSpan MemSpan_TexMem(u32 ofs, u32 len)
 			PROGINFO("Tried to reference unmapped texture memory: slot %d\n",slot);
 		}
 		curr.ptr = ptr + curr.start;
+		curr.generation = MMU.textureSlotGeneration[slot];
 	}
 	return ret;
 }
@@ -175,8 +197,9 @@ static MemSpan MemSpan_TexPalette(u32 ofs, u32 len, bool silent)
 		MemSpan::Item &curr = ret.items[ret.numItems++];
 		curr.start = ofs&0x3FFF;
 		u32 slot = (ofs>>14)&7; //this masks to 8 slots, but there are really only 6
-		if(slot>5 && !silent) {
-			PROGINFO("Texture palette overruns texture memory. Wrapping at palette slot 0.\n");
+		if(slot>5) {
+			if(!silent)
+				PROGINFO("Texture palette overruns texture memory. Wrapping at palette slot 0.\n");
 			slot -= 5;
 		}
 		curr.len = std::min(len,0x4000-curr.start);
@@ -192,6 +215,7 @@ static MemSpan MemSpan_TexPalette(u32 ofs, u32 len, bool silent)
 			PROGINFO("Tried to reference unmapped texture palette memory: 16k slot #%d\n",slot);
 		}
 		curr.ptr = ptr + curr.start;
+		curr.generation = MMU.texPalSlotGeneration[slot];
 	}
 	return ret;
 }
@@ -218,6 +242,8 @@ TextureCache::TextureCache()
 	_actualCacheSize = 0;
 	_cacheSizeThreshold = TEXCACHE_DEFAULT_THRESHOLD;
 	memset(_paletteDump, 0, sizeof(_paletteDump));
+	_paletteSlotGenerationSum = 0;
+	_palettePageGenerationSum = 0;
 }
 
 size_t TextureCache::GetActualCacheSize() const
@@ -238,13 +264,32 @@ void TextureCache::SetCacheSizeThreshold(size_t newThreshold)
 void TextureCache::Invalidate()
 {
 	//check whether the palette memory changed
-	//TODO - we should handle this instead by setting dirty flags in the vram memory mapping and noting whether palette memory was dirty.
-	//but this will work for now
+	//the palette slots and pages carry generation counters, so we only need to compare the palette dump if one of them moved
 	MemSpan mspal = MemSpan_TexPalette(0, PALETTE_DUMP_SIZE, true);
-	const bool paletteDirty = mspal.memcmp(this->_paletteDump);
-	if (paletteDirty)
+	u64 slotGenerationSum;
+	u64 pageGenerationSum;
+	mspal.generations(slotGenerationSum, pageGenerationSum);
+	
+	const bool generationChanged = (slotGenerationSum != this->_paletteSlotGenerationSum) || (pageGenerationSum != this->_palettePageGenerationSum);
+	this->_paletteSlotGenerationSum = slotGenerationSum;
+	this->_palettePageGenerationSum = pageGenerationSum;
+	
+	bool paletteDirty = false;
+#ifndef DEBUG_VERIFY_TEXTURE_VRAM_GENERATION
+	if (generationChanged)
+#endif
 	{
-		mspal.dump(this->_paletteDump);
+		paletteDirty = (mspal.memcmp(this->_paletteDump) != 0);
+		if (paletteDirty)
+		{
+#ifdef DEBUG_VERIFY_TEXTURE_VRAM_GENERATION
+			if (!generationChanged)
+			{
+				printf("TextureCache: VRAM generation counters missed a change to the texture palette.\n");
+			}
+#endif
+			mspal.dump(this->_paletteDump);
+		}
 	}
 	
 	for (TextureCacheMap::iterator it(this->_texCacheMap.begin()); it != this->_texCacheMap.end(); ++it)
@@ -399,6 +444,8 @@ TextureStore::TextureStore()
 	_packSizeFirstSlot = 0;
 	
 	_packTotalSize = 0;
+	_vramSlotGenerationSum = 0;
+	_vramPageGenerationSum = 0;
 	
 	_suspectedInvalid = false;
 	_assumedInvalid = false;
@@ -490,6 +537,10 @@ TextureStore::TextureStore(const TEXIMAGE_PARAM texAttributes, const u32 palAttr
 	currentPackedTexDataMS.dump(_packData);
 	_packSizeFirstSlot = currentPackedTexDataMS.items[0].len;
 	
+	_vramSlotGenerationSum = 0;
+	_vramPageGenerationSum = 0;
+	this->_UpdateVRAMGeneration();
+	
 	_suspectedInvalid = false;
 	_assumedInvalid = false;
 	_isLoadNeeded = true;
@@ -765,14 +816,58 @@ void TextureStore::Update()
 	
 	this->SetTextureData(currentPackedTexDataMS, currentPackedTexIndexMS);
 	this->SetTexturePalette(currentPaletteMS);
+	this->_UpdateVRAMGeneration();
 	
 	this->_assumedInvalid = false;
 	this->_suspectedInvalid = false;
 	this->_isLoadNeeded = true;
 }
 
+bool TextureStore::_UpdateVRAMGeneration()
+{
+	u64 slotGenerationSum;
+	u64 pageGenerationSum;
+	u64 itemSlotSum;
+	u64 itemPageSum;
+	
+	MemSpan_TexMem(this->_packAddress, this->_packSize).generations(slotGenerationSum, pageGenerationSum);
+	
+	if (this->_packFormat == TEXMODE_4X4)
+	{
+		MemSpan_TexMem(this->_packIndexAddress, this->_packIndexSize).generations(itemSlotSum, itemPageSum);
+		slotGenerationSum += itemSlotSum;
+		pageGenerationSum += itemPageSum;
+	}
+	
+	if (this->_paletteSize > 0)
+	{
+		MemSpan_TexPalette(this->_paletteAddress, this->_paletteSize, true).generations(itemSlotSum, itemPageSum);
+		slotGenerationSum += itemSlotSum;
+		pageGenerationSum += itemPageSum;
+	}
+	
+	const bool didChange = (slotGenerationSum != this->_vramSlotGenerationSum) || (pageGenerationSum != this->_vramPageGenerationSum);
+	this->_vramSlotGenerationSum = slotGenerationSum;
+	this->_vramPageGenerationSum = pageGenerationSum;
+	
+	return didChange;
+}
+
 void TextureStore::VRAMCompareAndUpdate()
 {
+	// If none of the slots or pages this texture reads from were remapped or written
+	// to since we last looked, then VRAM can't differ from our packed copy.
+	const bool generationChanged = this->_UpdateVRAMGeneration();
+	
+#ifndef DEBUG_VERIFY_TEXTURE_VRAM_GENERATION
+	if (!generationChanged)
+	{
+		this->_assumedInvalid = false;
+		this->_suspectedInvalid = false;
+		return;
+	}
+#endif
+	
 	MemSpan currentPaletteMS = MemSpan_TexPalette(this->_paletteAddress, this->_paletteSize, false);
 	MemSpan currentPackedTexDataMS = MemSpan_TexMem(this->_packAddress, this->_packSize);
 	MemSpan currentPackedTexIndexMS;
@@ -799,6 +894,12 @@ void TextureStore::VRAMCompareAndUpdate()
 	// like a normal palette, so they go through a different system.
 	if (memcmp(this->_packData, this->_workingData, this->_packTotalSize))
 	{
+#ifdef DEBUG_VERIFY_TEXTURE_VRAM_GENERATION
+		if (!generationChanged)
+		{
+			printf("TextureCache: VRAM generation counters missed a change to the texture at 0x%05X.\n", this->_packAddress);
+		}
+#endif
 		// If the packed data is different from VRAM, then swap pointers with
 		// the working buffer and flag this texture for reload.
 		u8 *tempDataPtr = this->_packData;
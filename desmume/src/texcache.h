@@ -69,6 +69,8 @@ protected:
   size_t _actualCacheSize;
   size_t _cacheSizeThreshold;
   u8 _paletteDump[PALETTE_DUMP_SIZE];
+  u64 _paletteSlotGenerationSum; // Sums of the VRAM generation counters
+  u64 _palettePageGenerationSum; // covered by _paletteDump
 
 public:
   TextureCache();
@@ -117,6 +119,9 @@ protected:
 
   size_t _packTotalSize;
 
+  u64 _vramSlotGenerationSum; // Sums of the VRAM generation counters covered
+  u64 _vramPageGenerationSum; // by the packed data, index and palette
+
   bool _suspectedInvalid;
   bool _assumedInvalid;
   bool _isLoadNeeded;
@@ -128,6 +133,8 @@ protected:
                     // this value, the older the texture.
   size_t _cacheUsageCount;
 
+  bool _UpdateVRAMGeneration();
+
 public:
   TextureStore();
   TextureStore(const TEXIMAGE_PARAM texAttributes, const u32 palAttributes);
@@ -17,6 +17,8 @@
 
 #include <stdio.h>
 #include <time.h>
+#include <algorithm>
+#include <vector>
 
 #define TIXML_USE_STL
 #include "tinyxml/tinyxml.h"
@@ -25,6 +27,7 @@
 #include "../common.h"
 #include "../mc.h"
 #include "../emufile.h"
+#include "../ROMReader.h"
 
 ADVANsCEne advsc;
 
@@ -33,6 +36,65 @@ ADVANsCEne advsc;
 #define _ADVANsCEne_BASE_VERSION_MINOR 0
 #define _ADVANsCEne_BASE_NAME "ADVANsCEne Nintendo DS Collection"
 
+// Version 2 of the converted database keeps the records of version 1 and follows them with
+// two tables that index the records by serial and by CRC32, so that checkDB() can binary
+// search the memory mapped file instead of reading every record. It gets its own ID since
+// older versions only check the ID, and would read the tables as if they were records.
+#define _ADVANsCEne_INDEXED_ID "DeSmuME indexed database (ADVANsCEne)\x1A"
+#define _ADVANsCEne_INDEXED_VERSION_MAJOR 2
+#define _ADVANsCEne_INDEXED_VERSION_MINOR 0
+#define _ADVANsCEne_INDEXED_HEADER_SIZE (strlen(_ADVANsCEne_INDEXED_ID) + 2 + 4 + 8 + 4)
+
+// serial(8) + crc32(4) + save_type(1) = 13 + reserved(8) = 21
+#define _ADVANsCEne_RECORD_SIZE 21
+
+// key(4) + record number(4). The keys compare with memcmp(), so the CRC32 is stored big endian.
+#define _ADVANsCEne_INDEX_ENTRY_SIZE 8
+
+struct ADVANsCEneIndexEntry
+{
+	u8 key[4];
+	u32 record;
+	
+	bool operator<(const ADVANsCEneIndexEntry &other) const
+	{
+		const int cmp = memcmp(key, other.key, 4);
+		return (cmp < 0) || ((cmp == 0) && (record < other.record));
+	}
+};
+
+static void ADVANsCEne_MakeCRCKey(const u32 crc, u8 (&outKey)[4])
+{
+	outKey[0] = (u8)(crc >> 24);
+	outKey[1] = (u8)(crc >> 16);
+	outKey[2] = (u8)(crc >>  8);
+	outKey[3] = (u8)(crc >>  0);
+}
+
+// Returns the number of the first record that has the key, or 0xFFFFFFFF if there is none.
+// Entries with the same key are sorted by their record number.
+static u32 ADVANsCEne_FindFirstRecord(const u8 *table, const u32 count, const u8 *key)
+{
+	u32 lo = 0;
+	u32 hi = count;
+	
+	while (lo < hi)
+	{
+		const u32 mid = lo + ((hi - lo) >> 1);
+		if (memcmp(table + (mid * _ADVANsCEne_INDEX_ENTRY_SIZE), key, 4) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	
+	if ( (lo >= count) || (memcmp(table + (lo * _ADVANsCEne_INDEX_ENTRY_SIZE), key, 4) != 0) )
+		return 0xFFFFFFFF;
+	
+	u32 record = 0;
+	memcpy(&record, table + (lo * _ADVANsCEne_INDEX_ENTRY_SIZE) + 4, 4);
+	return LE_TO_LOCAL_32(record);
+}
+
 
 ADVANsCEne::ADVANsCEne()
 {
@@ -69,55 +131,84 @@ std::string ADVANsCEne::getDatabase() const
 u8 ADVANsCEne::checkDB(const char *ROMserial, u32 crc)
 {
 	loaded = false;
-	FILE *fp = fopen(database_path.c_str(), "rb");
-	if (fp)
+	void *file = MMAPROMReader.Init(database_path.c_str());
+	if (file == NULL)
+		return false;
+	
+	const u8 *data = MMAPROMReaderGetData(file);
+	const u32 size = MMAPROMReader.Size(file);
+	const u8 *record = NULL;
+	
+	const size_t indexedIdLength = strlen(_ADVANsCEne_INDEXED_ID);
+	const size_t baseIdLength = strlen(_ADVANsCEne_BASE_ID);
+	
+	if ( (size >= _ADVANsCEne_INDEXED_HEADER_SIZE) && (memcmp(data, _ADVANsCEne_INDEXED_ID, indexedIdLength) == 0) )
 	{
-		char buf[64];
-		memset(buf, 0, sizeof(buf));
-		if (fread(buf, 1, strlen(_ADVANsCEne_BASE_ID), fp) == strlen(_ADVANsCEne_BASE_ID))
+		// header: ID + version base(2) + version(4) + create time(8) + record count(4)
+		const u8 *header = data + indexedIdLength;
+		memcpy(&versionBase[0], header, 2);
+		memcpy(&version[0], header + 2, 4);
+		u64 time64 = 0;
+		memcpy(&time64, header + 6, 8);
+		createTime = (time_t)LE_TO_LOCAL_64(time64);
+		u32 count = 0;
+		memcpy(&count, header + 14, 4);
+		count = LE_TO_LOCAL_32(count);
+		
+		const u8 *records = data + _ADVANsCEne_INDEXED_HEADER_SIZE;
+		const u8 *serialIndex = records + (count * _ADVANsCEne_RECORD_SIZE);
+		const u8 *crcIndex = serialIndex + (count * _ADVANsCEne_INDEX_ENTRY_SIZE);
+		
+		if ( (count <= ((size - _ADVANsCEne_INDEXED_HEADER_SIZE) / (_ADVANsCEne_RECORD_SIZE + (_ADVANsCEne_INDEX_ENTRY_SIZE * 2)))) )
+		{
+			// the first record that matches either the serial or the CRC wins, just like with a linear scan
+			u8 crcKey[4];
+			ADVANsCEne_MakeCRCKey(crc, crcKey);
+			const u32 serialRecord = ADVANsCEne_FindFirstRecord(serialIndex, count, (const u8 *)ROMserial);
+			const u32 crcRecord = ADVANsCEne_FindFirstRecord(crcIndex, count, crcKey);
+			const u32 firstRecord = std::min<u32>(serialRecord, crcRecord);
+			
+			if (firstRecord < count)
+				record = records + (firstRecord * _ADVANsCEne_RECORD_SIZE);
+		}
+	}
+	else if ( (size >= baseIdLength + 6 + sizeof(time_t)) && (memcmp(data, _ADVANsCEne_BASE_ID, baseIdLength) == 0) )
+	{
+		// databases converted by older versions have no index, so they still need to be scanned
+		const u8 *header = data + baseIdLength;
+		memcpy(&versionBase[0], header, 2);
+		memcpy(&version[0], header + 2, 4);
+		memcpy(&createTime, header + 6, sizeof(time_t));
+		
+		for (u32 pos = (u32)(baseIdLength + 6 + sizeof(time_t)); (pos + _ADVANsCEne_RECORD_SIZE) <= size; pos += _ADVANsCEne_RECORD_SIZE)
 		{
-			//printf("ID: %s\n", buf);
-			if (strcmp(buf, _ADVANsCEne_BASE_ID) == 0)
+			u32 dbcrc = 0;
+			memcpy(&dbcrc, data + pos + 8, 4);
+			
+			if ( (memcmp(data + pos + 4, ROMserial, 4) == 0) || (crc == LE_TO_LOCAL_32(dbcrc)) )
 			{
-				if (fread(&versionBase[0], 1, 2, fp) == 2)
-				{
-					//printf("Version base: %i.%i\n", versionBase[0], versionBase[1]);
-					if (fread(&version[0], 1, 4, fp) == 4)
-					{
-						//printf("Version: %c%c%c%c\n", version[3], version[2], version[1], version[0]);
-						if (fread(&createTime, 1, sizeof(time_t), fp) == sizeof(time_t))
-						{
-							memset(buf, 0,sizeof(buf));
-							// serial(8) + crc32(4) + save_type(1) = 13 + reserved(8) = 21
-							while (true)
-							{
-								if (fread(buf, 1, 21, fp) != 21) break;
-
-								bool serialFound = (memcmp(&buf[4], ROMserial, 4) == 0);
-								u32 dbcrc = LE_TO_LOCAL_32(*(u32*)(buf+8));
-								bool crcFound = (crc == dbcrc);
-
-								if(serialFound || crcFound)
-								{
-									foundAsCrc = crcFound;
-									foundAsSerial = serialFound;
-									memcpy(&crc32, &buf[8], 4);
-									memcpy(&serial[0], &buf[4], 4);
-									//printf("%s founded: crc32=%04X, save type %02X\n", ROMserial, crc32, buf[12]);
-									saveType = buf[12];
-									fclose(fp);
-									loaded = true;
-									return true;
-								}
-							}
-						}
-					}
-				}
+				record = data + pos;
+				break;
 			}
 		}
-		fclose(fp);
 	}
-	return false;
+	
+	if (record != NULL)
+	{
+		u32 dbcrc = 0;
+		memcpy(&dbcrc, record + 8, 4);
+		
+		foundAsCrc = (crc == LE_TO_LOCAL_32(dbcrc));
+		foundAsSerial = (memcmp(record + 4, ROMserial, 4) == 0);
+		memcpy(&crc32, record + 8, 4);
+		memcpy(&serial[0], record + 4, 4);
+		//printf("%s founded: crc32=%04X, save type %02X\n", ROMserial, crc32, record[12]);
+		saveType = record[12];
+		loaded = true;
+	}
+	
+	MMAPROMReader.DeInit(file);
+	return loaded;
 }
 
 bool ADVANsCEne::getXMLConfig(const char *in_filename)
@@ -173,7 +264,6 @@ u32 ADVANsCEne::convertDB(const char *in_filename, EMUFILE &output)
 	TiXmlElement	*el_crc32 = NULL;
 	TiXmlElement	*el_saveType = NULL;
 	u32				db_crc32 = 0;
-	u32				reserved = 0;
 
 	lastImportErrorMessage = "";
 
@@ -184,19 +274,6 @@ u32 ADVANsCEne::convertDB(const char *in_filename, EMUFILE &output)
 		if (datName != _ADVANsCEne_BASE_NAME) return 0;
 	}
 
-	// Header
-	output.fwrite(_ADVANsCEne_BASE_ID, strlen(_ADVANsCEne_BASE_ID));
-	output.write_u8(_ADVANsCEne_BASE_VERSION_MAJOR);
-	output.write_u8(_ADVANsCEne_BASE_VERSION_MINOR);
-	
-	if (datVersion.size()) 
-		output.fwrite(&datVersion[0], datVersion.size());
-	else
-		output.write_u8(0);
-	
-	time_t __time = time(NULL);
-	output.fwrite(&__time, sizeof(time_t));
-
 	xml = new TiXmlDocument();
 	if (!xml) return 0;
 	if (!xml->LoadFile(in_filename)) return 0;
@@ -207,6 +284,9 @@ u32 ADVANsCEne::convertDB(const char *in_filename, EMUFILE &output)
 	el = el_games->FirstChildElement("game");
 	if (!el) return 0;
 	u32 count = 0;
+	std::vector<u8> records;
+	std::vector<ADVANsCEneIndexEntry> serialIndex;
+	std::vector<ADVANsCEneIndexEntry> crcIndex;
 	
 	while (el)
 	{
@@ -225,12 +305,17 @@ u32 ADVANsCEne::convertDB(const char *in_filename, EMUFILE &output)
 			lastImportErrorMessage = "Missing <serial> element. Did you use the right xml file? We need the RtoolDS one.";
 			return 0;
 		}
-		output.fwrite(el_serial->GetText(), 8);
+		u8 record[_ADVANsCEne_RECORD_SIZE];
+		memset(record, 0, sizeof(record));
+		strncpy((char *)record, el_serial->GetText(), 8);
 
 		// CRC32
 		el_crc32 = el->FirstChildElement("files"); 
 		sscanf(el_crc32->FirstChildElement("romCRC")->GetText(), "%x", &db_crc32);
-		output.write_32LE(db_crc32);
+		record[ 8] = (u8)(db_crc32 >>  0);
+		record[ 9] = (u8)(db_crc32 >>  8);
+		record[10] = (u8)(db_crc32 >> 16);
+		record[11] = (u8)(db_crc32 >> 24);
 		
 		// Save type
 		el_saveType = el->FirstChildElement("saveType"); 
@@ -257,9 +342,15 @@ u32 ADVANsCEne::convertDB(const char *in_filename, EMUFILE &output)
 			}
 		}
 		
-		output.write_u8(selectedSaveType);
-		output.write_32LE(reserved);
-		output.write_32LE(reserved);
+		record[12] = selectedSaveType;
+		records.insert(records.end(), record, record + sizeof(record));
+		
+		ADVANsCEneIndexEntry entry;
+		entry.record = count;
+		memcpy(entry.key, &record[4], 4);
+		serialIndex.push_back(entry);
+		ADVANsCEne_MakeCRCKey(db_crc32, entry.key);
+		crcIndex.push_back(entry);
 		
 		count++;
 		el = el->NextSiblingElement("game");
@@ -268,6 +359,35 @@ u32 ADVANsCEne::convertDB(const char *in_filename, EMUFILE &output)
 	printf("\n");
 	delete xml;
 	
+	std::sort(serialIndex.begin(), serialIndex.end());
+	std::sort(crcIndex.begin(), crcIndex.end());
+	
+	// Header
+	char versionField[4] = { 0, 0, 0, 0 };
+	memcpy(versionField, datVersion.c_str(), std::min<size_t>(datVersion.size(), sizeof(versionField)));
+	
+	output.fwrite(_ADVANsCEne_INDEXED_ID, strlen(_ADVANsCEne_INDEXED_ID));
+	output.write_u8(_ADVANsCEne_INDEXED_VERSION_MAJOR);
+	output.write_u8(_ADVANsCEne_INDEXED_VERSION_MINOR);
+	output.fwrite(versionField, sizeof(versionField));
+	output.write_64LE((u64)time(NULL));
+	output.write_32LE(count);
+	
+	if (count > 0)
+		output.fwrite(&records[0], records.size());
+	
+	for (size_t i = 0; i < serialIndex.size(); i++)
+	{
+		output.fwrite(serialIndex[i].key, 4);
+		output.write_32LE(serialIndex[i].record);
+	}
+	
+	for (size_t i = 0; i < crcIndex.size(); i++)
+	{
+		output.fwrite(crcIndex[i].key, 4);
+		output.write_32LE(crcIndex[i].record);
+	}
+	
 	if (count > 0) 
 		printf("done\n");
 	else
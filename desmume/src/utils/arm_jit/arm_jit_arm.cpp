@@ -117,6 +117,13 @@ void jit_write() {
 
 u32 saveBlockSizeJIT = 0;
 
+JIT_LINK_struct JIT_LINK = {0, 0, 0, 0};
+
+// the code cache is flushed as a whole when it fills up, so nothing reads these page stamps back;
+// they only exist for the CPU loop to write to
+u32 JIT_PAGE_USE[2][0x4000];
+u32 jit_use_clock = 0;
+
 static volatile unsigned int label_gen_num=0;
 unsigned int genlabel() {
 	return ++label_gen_num;
@@ -2177,6 +2184,14 @@ static u32 DESMUME_FASTCALL OP_LDM_STM(u32 adr, u32 regslo, u32 regshi, int n)
 		// the memory region spans a page boundary, so we can't factor the address translation out of the loop
 		return OP_LDM_STM_generic<PROCNUM, store, dir>(adr, regs, n);
 	}
+#ifdef HAVE_LUA
+	// the direct paths below bypass the memory accessors, which are what report to the Lua hooks
+	else if(IsLuaMemHookPage(adr, store ? LUAMEMHOOK_WRITE : LUAMEMHOOK_READ) ||
+	        IsLuaMemHookPage(adr + (dir>0 ? (n-1)*4 : -(n-1)*4), store ? LUAMEMHOOK_WRITE : LUAMEMHOOK_READ))
+	{
+		return OP_LDM_STM_generic<PROCNUM, store, dir>(adr, regs, n);
+	}
+#endif
 	else if(PROCNUM==ARMCPU_ARM9 && (adr & ~0x3FFF) == MMU.DTCMRegion)
 	{
 		// don't special-case DTCM cycles, even though that would be both faster and more accurate,
@@ -2190,6 +2205,8 @@ static u32 DESMUME_FASTCALL OP_LDM_STM(u32 adr, u32 regslo, u32 regshi, int n)
 	{
 		ptr = MMU.MAIN_MEM + (adr & _MMU_MAIN_MEM_MASK32);
 		cycles = n * ((PROCNUM==ARMCPU_ARM9) ? 4 : 2);
+		if(store)
+			SPU_WatchMainWriteRange((adr & _MMU_MAIN_MEM_MASK32) - (dir>0 ? 0 : (n-1)*4), n*4);
 	}
 	else if(PROCNUM==ARMCPU_ARM7 && !store && (adr & 0xFF800000) == 0x03800000)
 	{
@@ -3963,6 +3980,31 @@ static void emit_armop_call(u32 opcode)
 	emit_write_ptr32_reg(g_out, (uintptr_t)&bb_cycles, R0);	
 }
 
+#ifdef HAVE_LUA
+template<int SIZE>
+static void DESMUME_FASTCALL lua_exec_hook(u32 adr, u32 opcode)
+{
+	CallRegisteredLuaMemHook(adr, SIZE, opcode, LUAMEMHOOK_EXEC);
+}
+#endif
+
+// The interpreter reports every instruction it executes to the Lua exec hooks. A compiled block
+// only does so on the pages that have exec hooks when it is compiled; the hook code invalidates
+// the pages whose hooks change.
+static void emit_lua_exec_hook(u32 opcode)
+{
+#ifdef HAVE_LUA
+	if(!IsLuaMemHookPage(bb_adr, LUAMEMHOOK_EXEC))
+		return;
+
+	JIT_COMMENT("lua exec hook");
+	emit_movimm(g_out, bb_adr, R0);
+	emit_movimm(g_out, opcode, R1);
+	emit_ptr(g_out, bb_thumb ? (uintptr_t)lua_exec_hook<2> : (uintptr_t)lua_exec_hook<4>, R3);
+	callR3(g_out);
+#endif
+}
+
 static void _armlog(u8 proc, u32 addr, u32 opcode)
 {
 #if 0
@@ -4074,6 +4116,7 @@ static u32 compile_basicblock()
 				sync_r15(opcode, 0, 0);
 			}
 			
+			emit_lua_exec_hook(opcode);
 			emit_armop_call(opcode);
 			
 			if(cycles == 0)
@@ -4093,6 +4136,7 @@ static u32 compile_basicblock()
 		else
 		{
 			sync_r15(opcode, bEndBlock, 0);
+			emit_lua_exec_hook(opcode);
 			emit_armop_call(opcode);
 			
 			if(cycles == 0)
@@ -4165,6 +4209,30 @@ template<int PROCNUM> u32 arm_jit_compile()
 template u32 arm_jit_compile<0>();
 template u32 arm_jit_compile<1>();
 
+// blocks aren't linked to each other on ARM hosts, so a chain is just the one block
+u32 arm_jit_run_linked(ArmOpCompiled f, s32 linkBudget)
+{
+	return f();
+}
+
+// Drops the compiled code that may cover the guest memory in [adr, adr+size), on both CPUs.
+// Blocks are only looked up by their first instruction, so the blocks that start up to one
+// maximum block length in front of the range and run into it have to go as well.
+void arm_jit_invalidate(u32 adr, u32 size)
+{
+	const u32 reach = std::max<u32>(CommonSettings.jit_max_block_size, saveBlockSizeJIT) * 4;
+	const u32 start = ((adr > reach) ? (adr - reach + 2) : 0) & ~1;
+	const u32 end = adr + size;
+
+	for (u32 a = start; a < end; a += 2)
+	{
+		if (JIT_MAPPED(a & 0x0FFFFFFF, 0))
+			JIT_COMPILED_FUNC(a, 0) = 0;
+		if (JIT_MAPPED(a & 0x0FFFFFFF, 1))
+			JIT_COMPILED_FUNC(a, 1) = 0;
+	}
+}
+
 void arm_jit_reset(bool enable, bool suppress_msg)
 {
 #if LOG_JIT
@@ -87,7 +87,8 @@ static void *armjitarm_alloc_func(size_t size) {
             //return NULL;
         }
 
-        int memsize = 4 * 10000000;
+        // --jit-cache-size bounds the code region; when it fills up, all code is dropped
+        int memsize = std::max<u32>(CommonSettings.jit_cache_size, 1) << 20;
         g_curr_jit_block = (char *)alloc_executable_memory(memsize);
         if (! g_curr_jit_block) return NULL;
         g_curr_jit_ptr = g_curr_jit_block;
@@ -17,34 +17,561 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
 
 #include "types.h"
 #include "task.h"
 #include <rthreads/rthreads.h>
 
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #ifdef __APPLE__
 #include <AvailabilityMacros.h>
 #include <CoreFoundation/CoreFoundation.h>
 #include <pthread.h>
 #endif
 
+// Waiting for work (in finish(), and in the pool threads when they run out of work) starts by spinning,
+// since most of the work handed to tasks finishes within microseconds and waking a sleeping thread takes
+// longer than that. The number of spins adapts: it doubles whenever spinning paid off, and halves
+// whenever the waiter had to go to sleep anyway.
+#define TASK_SPIN_MIN         64
+#define TASK_SPIN_MAX         4096
+#define TASK_SPIN_MAX_SPINLOCK 65536
+
+static FORCEINLINE void Task_CPUPause()
+{
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+	_mm_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+static FORCEINLINE void Task_AdaptSpin(u32 &spinCount, const u32 spinMax, const bool didSpinPayOff)
+{
+	if (didSpinPayOff)
+		spinCount = std::min<u32>(spinCount * 2, spinMax);
+	else
+		spinCount = std::max<u32>(spinCount / 2, TASK_SPIN_MIN);
+}
+
+enum TaskJobState
+{
+	TaskJobState_Idle = 0,
+	TaskJobState_Queued,
+	TaskJobState_Running,
+	TaskJobState_Done
+};
+
+struct TaskJob
+{
+	Task::TWork work;
+	void *param;
+	void *ret;
+	TaskGroup group;
+	std::atomic<s32> state;
+	std::atomic<u32> queueIndex; // the pool thread queue that holds the job while it's queued
+
+	TaskJob() : work(NULL), param(NULL), ret(NULL), group(TaskGroup_Default), state(TaskJobState_Idle), queueIndex(0) {}
+};
+
+class TaskPool;
+
+struct TaskPoolThread
+{
+	TaskPool *pool;
+	size_t index;
+	sthread_t *thread;
+	std::atomic<bool> exitThread;
+
+	slock_t *queueLock;
+	std::deque<TaskJob *> queue;
+	std::atomic<u32> queueSize; // so that other threads can skip an empty queue without taking its lock
+};
+
+struct TaskPoolGroupLimit
+{
+	std::atomic<u32> maxThreads;
+	std::atomic<u32> threadMask;
+	std::atomic<u32> runningCount;
+};
+
+//The shared thread pool. Every pool thread has its own queue. New work is spread over the queues of the
+//threads that may run it, and a thread that runs out of work takes the oldest work it may run from the
+//other queues. A thread that waits on work which hasn't started yet takes it back and runs it itself.
+class TaskPool
+{
+private:
+	TaskPoolThread _thread[TASKPOOL_MAX_THREADS];
+	size_t _threadCount;           // threads running right now
+	size_t _configuredThreadCount; // threads to run once the pool is needed
+	size_t _nextThread;
+	slock_t *_configLock;
+
+	TaskPoolGroupLimit _groupLimit[TaskGroupCount];
+
+	// pool threads sleep until _workGeneration changes
+	std::atomic<u32> _workGeneration;
+	std::atomic<s32> _sleepingThreads;
+	slock_t *_workLock;
+	scond_t *_workCond;
+
+	// waiters sleep until the job they wait on is done
+	std::atomic<s32> _sleepingWaiters;
+	slock_t *_doneLock;
+	scond_t *_doneCond;
+
+	bool _CanRunOnThread(const TaskGroup group, const size_t threadIndex) const;
+	bool _ClaimGroupThread(const TaskGroup group);
+	void _ReleaseGroupThread(const TaskGroup group);
+	TaskJob* _TakeJob(const size_t threadIndex);
+	void _Wake();
+	void _EnsureThreads();
+	void _StartThreads(const size_t threadCount);
+	void _StopThreads();
+
+public:
+	TaskPool();
+
+	static TaskPool& Get();
+
+	void ThreadProc(TaskPoolThread &thread);
+
+	void Submit(TaskJob &job);
+	bool Reclaim(TaskJob &job);
+	void Wait(TaskJob &job, u32 &spinCount, const u32 spinMax);
+
+	void SetThreadCount(size_t threadCount);
+	size_t GetThreadCount();
+	size_t GetGroupThreadCount(const TaskGroup group);
+	void SetGroupLimit(const TaskGroup group, const size_t maxThreads, const u32 threadMask);
+	void Shutdown();
+};
+
+static void TaskPool_ThreadProc(void *arg)
+{
+	TaskPoolThread *thread = (TaskPoolThread *)arg;
+	thread->pool->ThreadProc(*thread);
+}
+
+TaskPool::TaskPool()
+{
+	for (size_t i = 0; i < TASKPOOL_MAX_THREADS; i++)
+	{
+		_thread[i].pool = this;
+		_thread[i].index = i;
+		_thread[i].thread = NULL;
+		_thread[i].exitThread = false;
+		_thread[i].queueLock = slock_new();
+		_thread[i].queueSize = 0;
+	}
+
+	for (size_t i = 0; i < TaskGroupCount; i++)
+	{
+		_groupLimit[i].maxThreads = 0;
+		_groupLimit[i].threadMask = 0;
+		_groupLimit[i].runningCount = 0;
+	}
+
+	_threadCount = 0;
+	_configuredThreadCount = std::min<size_t>(std::max<size_t>(std::thread::hardware_concurrency(), 1), TASKPOOL_MAX_THREADS);
+	_nextThread = 0;
+	_configLock = slock_new();
+
+	_workGeneration = 0;
+	_sleepingThreads = 0;
+	_workLock = slock_new();
+	_workCond = scond_new();
+
+	_sleepingWaiters = 0;
+	_doneLock = slock_new();
+	_doneCond = scond_new();
+}
+
+TaskPool& TaskPool::Get()
+{
+	// Never destroyed, since work may still be handed to it while other static objects are torn down.
+	static TaskPool *pool = new TaskPool;
+	return *pool;
+}
+
+bool TaskPool::_CanRunOnThread(const TaskGroup group, const size_t threadIndex) const
+{
+	const u32 threadMask = this->_groupLimit[group].threadMask.load(std::memory_order_relaxed);
+	const u32 ownMask = (this->_threadCount >= 32) ? 0xFFFFFFFF : ((1U << this->_threadCount) - 1);
+
+	// a mask that leaves out every running thread would strand the group, so ignore it
+	if ( (threadMask & ownMask) == 0 )
+		return true;
+
+	return (threadMask & (1U << threadIndex)) != 0;
+}
+
+bool TaskPool::_ClaimGroupThread(const TaskGroup group)
+{
+	TaskPoolGroupLimit &limit = this->_groupLimit[group];
+	const u32 maxThreads = limit.maxThreads.load(std::memory_order_relaxed);
+
+	if (limit.runningCount.fetch_add(1) >= maxThreads && maxThreads != 0)
+	{
+		limit.runningCount.fetch_sub(1);
+		return false;
+	}
+
+	return true;
+}
+
+void TaskPool::_ReleaseGroupThread(const TaskGroup group)
+{
+	TaskPoolGroupLimit &limit = this->_groupLimit[group];
+	limit.runningCount.fetch_sub(1);
+
+	// work that was held back by the limit may be able to run now
+	if (limit.maxThreads.load(std::memory_order_relaxed) != 0)
+		this->_Wake();
+}
+
+TaskJob* TaskPool::_TakeJob(const size_t threadIndex)
+{
+	// own queue first, then the others, oldest work first
+	for (size_t n = 0; n < this->_threadCount; n++)
+	{
+		TaskPoolThread &victim = this->_thread[(threadIndex + n) % this->_threadCount];
+		if (victim.queueSize.load(std::memory_order_relaxed) == 0)
+			continue;
+
+		TaskJob *job = NULL;
+
+		slock_lock(victim.queueLock);
+		for (std::deque<TaskJob *>::iterator it = victim.queue.begin(); it != victim.queue.end(); ++it)
+		{
+			if ( this->_CanRunOnThread((*it)->group, threadIndex) && this->_ClaimGroupThread((*it)->group) )
+			{
+				job = *it;
+				victim.queue.erase(it);
+				victim.queueSize--;
+				job->state = TaskJobState_Running;
+				break;
+			}
+		}
+		slock_unlock(victim.queueLock);
+
+		if (job != NULL)
+			return job;
+	}
+
+	return NULL;
+}
+
+void TaskPool::_Wake()
+{
+	this->_workGeneration.fetch_add(1);
+
+	if (this->_sleepingThreads.load() > 0)
+	{
+		slock_lock(this->_workLock);
+		scond_broadcast(this->_workCond);
+		slock_unlock(this->_workLock);
+	}
+}
+
+void TaskPool::ThreadProc(TaskPoolThread &thread)
+{
+	u32 spinCount = TASK_SPIN_MIN;
+
+	while (!thread.exitThread.load())
+	{
+		// read the generation before looking, so that work queued while looking is never slept through
+		const u32 generation = this->_workGeneration.load();
+
+		TaskJob *job = this->_TakeJob(thread.index);
+		if (job != NULL)
+		{
+			job->ret = job->work(job->param);
+			const TaskGroup group = job->group;
+
+			// the job may be reused or freed as soon as the waiter sees it done, so don't touch it after this
+			job->state.store(TaskJobState_Done);
+			if (this->_sleepingWaiters.load() > 0)
+			{
+				slock_lock(this->_doneLock);
+				scond_broadcast(this->_doneCond);
+				slock_unlock(this->_doneLock);
+			}
+
+			this->_ReleaseGroupThread(group);
+			continue;
+		}
+
+		bool didSpinPayOff = false;
+		for (u32 i = 0; i < spinCount; i++)
+		{
+			if (this->_workGeneration.load(std::memory_order_relaxed) != generation || thread.exitThread.load(std::memory_order_relaxed))
+			{
+				didSpinPayOff = true;
+				break;
+			}
+			Task_CPUPause();
+		}
+		Task_AdaptSpin(spinCount, TASK_SPIN_MAX, didSpinPayOff);
+
+		if (!didSpinPayOff)
+		{
+			slock_lock(this->_workLock);
+			this->_sleepingThreads.fetch_add(1);
+			while ( (this->_workGeneration.load() == generation) && !thread.exitThread.load() )
+			{
+				scond_wait(this->_workCond, this->_workLock);
+			}
+			this->_sleepingThreads.fetch_sub(1);
+			slock_unlock(this->_workLock);
+		}
+	}
+}
+
+void TaskPool::_StartThreads(const size_t threadCount)
+{
+	// the threads read this as soon as they start, and only ever while they run
+	this->_threadCount = threadCount;
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		this->_thread[i].exitThread = false;
+		this->_thread[i].thread = sthread_create(&TaskPool_ThreadProc, &this->_thread[i]);
+
+#if !defined(USE_WIN32_THREADS) && !defined(__APPLE__)
+		char name[16];
+		snprintf(name, 16, "task pool %d", (int)i);
+		sthread_setname(this->_thread[i].thread, name);
+#endif
+	}
+}
+
+// call with _configLock held
+void TaskPool::_EnsureThreads()
+{
+	if (this->_threadCount == 0)
+		this->_StartThreads(this->_configuredThreadCount);
+}
+
+void TaskPool::_StopThreads()
+{
+	// every thread finishes the job it's running first
+	for (size_t i = 0; i < this->_threadCount; i++)
+		this->_thread[i].exitThread = true;
+
+	this->_Wake();
+
+	for (size_t i = 0; i < this->_threadCount; i++)
+	{
+		sthread_join(this->_thread[i].thread);
+		this->_thread[i].thread = NULL;
+	}
+}
+
+void TaskPool::SetThreadCount(size_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	threadCount = std::min<size_t>(threadCount, TASKPOOL_MAX_THREADS);
+
+	slock_lock(this->_configLock);
+
+	this->_configuredThreadCount = threadCount;
+
+	// a pool that isn't running picks up the new count when it starts
+	if ( (this->_threadCount == 0) || (threadCount == this->_threadCount) )
+	{
+		slock_unlock(this->_configLock);
+		return;
+	}
+
+	const size_t oldThreadCount = this->_threadCount;
+	this->_StopThreads();
+
+	// hand the queued work of the threads that are going away to the ones that stay
+	for (size_t i = threadCount; i < oldThreadCount; i++)
+	{
+		TaskPoolThread &from = this->_thread[i];
+		TaskPoolThread &to = this->_thread[i % threadCount];
+
+		slock_lock(from.queueLock);
+		slock_lock(to.queueLock);
+		while (!from.queue.empty())
+		{
+			TaskJob *job = from.queue.front();
+			from.queue.pop_front();
+			job->queueIndex = (u32)to.index;
+			to.queue.push_back(job);
+		}
+		from.queueSize = 0;
+		to.queueSize = (u32)to.queue.size();
+		slock_unlock(to.queueLock);
+		slock_unlock(from.queueLock);
+	}
+
+	this->_StartThreads(threadCount);
+	slock_unlock(this->_configLock);
+}
+
+size_t TaskPool::GetThreadCount()
+{
+	slock_lock(this->_configLock);
+	this->_EnsureThreads();
+	const size_t threadCount = this->_threadCount;
+	slock_unlock(this->_configLock);
+
+	return threadCount;
+}
+
+size_t TaskPool::GetGroupThreadCount(const TaskGroup group)
+{
+	const size_t threadCount = this->GetThreadCount();
+	size_t groupThreadCount = 0;
+
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		if (this->_CanRunOnThread(group, i))
+			groupThreadCount++;
+	}
+
+	const u32 maxThreads = this->_groupLimit[group].maxThreads.load(std::memory_order_relaxed);
+	if (maxThreads != 0)
+		groupThreadCount = std::min<size_t>(groupThreadCount, maxThreads);
+
+	return groupThreadCount;
+}
+
+void TaskPool::SetGroupLimit(const TaskGroup group, const size_t maxThreads, const u32 threadMask)
+{
+	this->_groupLimit[group].maxThreads = (u32)maxThreads;
+	this->_groupLimit[group].threadMask = threadMask;
+	this->_Wake();
+}
+
+void TaskPool::Shutdown()
+{
+	slock_lock(this->_configLock);
+	this->_StopThreads();
+	this->_threadCount = 0;
+	slock_unlock(this->_configLock);
+}
+
+void TaskPool::Submit(TaskJob &job)
+{
+	slock_lock(this->_configLock);
+	this->_EnsureThreads();
+
+	// spread the work over the threads that may run it
+	size_t threadIndex = this->_nextThread;
+	for (size_t n = 0; n < this->_threadCount; n++)
+	{
+		threadIndex = (this->_nextThread + n) % this->_threadCount;
+		if (this->_CanRunOnThread(job.group, threadIndex))
+			break;
+	}
+	this->_nextThread = (threadIndex + 1) % this->_threadCount;
+
+	TaskPoolThread &thread = this->_thread[threadIndex];
+	slock_lock(thread.queueLock);
+	job.queueIndex = (u32)threadIndex;
+	job.state = TaskJobState_Queued;
+	thread.queue.push_back(&job);
+	thread.queueSize++;
+	slock_unlock(thread.queueLock);
+
+	slock_unlock(this->_configLock);
+
+	this->_Wake();
+}
+
+bool TaskPool::Reclaim(TaskJob &job)
+{
+	while (job.state.load() == TaskJobState_Queued)
+	{
+		TaskPoolThread &thread = this->_thread[job.queueIndex.load()];
+		bool didReclaim = false;
+
+		slock_lock(thread.queueLock);
+		std::deque<TaskJob *>::iterator it = std::find(thread.queue.begin(), thread.queue.end(), &job);
+		if (it != thread.queue.end())
+		{
+			thread.queue.erase(it);
+			thread.queueSize--;
+			job.state = TaskJobState_Running;
+			didReclaim = true;
+		}
+		slock_unlock(thread.queueLock);
+
+		if (didReclaim)
+			return true;
+
+		// otherwise a pool thread took it, or it moved to another queue while the pool was resized
+	}
+
+	return false;
+}
+
+void TaskPool::Wait(TaskJob &job, u32 &spinCount, const u32 spinMax)
+{
+	if (job.state.load() == TaskJobState_Done)
+		return;
+
+	bool didSpinPayOff = false;
+	for (u32 i = 0; i < spinCount; i++)
+	{
+		if (job.state.load(std::memory_order_acquire) == TaskJobState_Done)
+		{
+			didSpinPayOff = true;
+			break;
+		}
+		Task_CPUPause();
+	}
+	Task_AdaptSpin(spinCount, spinMax, didSpinPayOff);
+
+	if (!didSpinPayOff)
+	{
+		slock_lock(this->_doneLock);
+		this->_sleepingWaiters.fetch_add(1);
+		while (job.state.load() != TaskJobState_Done)
+		{
+			scond_wait(this->_doneCond, this->_doneLock);
+		}
+		this->_sleepingWaiters.fetch_sub(1);
+		slock_unlock(this->_doneLock);
+	}
+}
+
 class Task::Impl {
 private:
 	sthread_t* _thread;
 	bool _isThreadRunning;
-	
+	bool _isPooled;
+
+	TaskJob _job;
+	u32 _spinCount;
+	u32 _spinMax;
+
 public:
 	Impl();
 	~Impl();
 
 	void start(bool spinlock, int threadPriority, const char *name);
+	void start(TaskGroup group, bool spinlock);
 	void execute(const TWork &work, void *param);
+	bool runIfQueued();
 	void* finish();
 	void shutdown();
 
 	bool needSetThreadName;
 	char threadName[16]; // pthread_setname_np() assumes a max character length of 16.
-	
+
 	slock_t *mutex;
 	scond_t *condWork;
 	TWork workFunc;
@@ -56,7 +583,7 @@ public:
 static void taskProc(void *arg)
 {
 	Task::Impl *ctx = (Task::Impl *)arg;
-	
+
 	// The pthread_setname_np() function is gimped on macOS because it can't set thread
 	// names from any thread other than the current thread. That's why we can only set the
 	// thread name right here. We are not modifying rthreads, which is meant to be
@@ -78,13 +605,22 @@ static void taskProc(void *arg)
 		}
 
 		if (ctx->workFunc != NULL) {
-			ctx->ret = ctx->workFunc(ctx->workFuncParam);
+			// workFunc stays set while the work runs, so that execute() and finish() can tell it's busy
+			Task::TWork workFunc = ctx->workFunc;
+			void *workFuncParam = ctx->workFuncParam;
+			slock_unlock(ctx->mutex);
+
+			void *ret = workFunc(workFuncParam);
+
+			slock_lock(ctx->mutex);
+			ctx->ret = ret;
 		} else {
 			ctx->ret = NULL;
 		}
 
 		ctx->workFunc = NULL;
-		scond_signal(ctx->condWork);
+		// wakes finish() and any execute() that's waiting for the task to go idle
+		scond_broadcast(ctx->condWork);
 
 		slock_unlock(ctx->mutex);
 
@@ -94,11 +630,14 @@ static void taskProc(void *arg)
 Task::Impl::Impl()
 {
 	_isThreadRunning = false;
+	_isPooled = false;
+	_spinCount = TASK_SPIN_MIN;
+	_spinMax = TASK_SPIN_MAX;
 	workFunc = NULL;
 	workFuncParam = NULL;
 	ret = NULL;
 	exitThread = false;
-	
+
 	memset(threadName, 0, sizeof(threadName));
 	needSetThreadName = false;
 
@@ -116,44 +655,95 @@ Task::Impl::~Impl()
 void Task::Impl::start(bool spinlock, int threadPriority, const char *name)
 {
 	slock_lock(this->mutex);
-	
+
 	if (this->_isThreadRunning) {
 		slock_unlock(this->mutex);
 		return;
 	}
-	
+
 	this->workFunc = NULL;
 	this->workFuncParam = NULL;
 	this->ret = NULL;
 	this->exitThread = false;
+	this->_isPooled = false;
 	this->_thread = sthread_create_with_priority(&taskProc, this, threadPriority);
 	this->_isThreadRunning = true;
-	
+
 #if !defined(USE_WIN32_THREADS) && !defined(__APPLE__)
 	sthread_setname(this->_thread, name);
 #else
-	
+
 #if defined(DESMUME_COCOA) && defined(MAC_OS_X_VERSION_10_6) && (MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_X_VERSION_10_6)
 	// Setting the thread name on macOS uses pthread_setname_np(), but this requires macOS v10.6 or later.
 	this->needSetThreadName = (kCFCoreFoundationVersionNumber >= kCFCoreFoundationVersionNumber10_6) && (name != NULL);
 #else
 	this->needSetThreadName = (name != NULL);
 #endif
-	
+
 	if (this->needSetThreadName)
 	{
 		strncpy(this->threadName, name, sizeof(this->threadName));
 	}
 #endif
-	
+
 	slock_unlock(this->mutex);
 }
 
+void Task::Impl::start(TaskGroup group, bool spinlock)
+{
+	slock_lock(this->mutex);
+
+	if (this->_isThreadRunning) {
+		slock_unlock(this->mutex);
+		return;
+	}
+
+	this->_job.group = group;
+	this->_job.state = TaskJobState_Idle;
+	this->_spinMax = (spinlock) ? TASK_SPIN_MAX_SPINLOCK : TASK_SPIN_MAX;
+	this->_spinCount = TASK_SPIN_MIN;
+	this->_isPooled = true;
+	this->_isThreadRunning = true;
+
+	slock_unlock(this->mutex);
+
+	// get the pool threads going now rather than on the first bit of work
+	TaskPool::Get().GetThreadCount();
+}
+
 void Task::Impl::execute(const TWork &work, void *param)
 {
+	if (this->_isPooled)
+	{
+		if ((work == NULL) || !this->_isThreadRunning)
+			return;
+
+		// like the dedicated thread, don't drop the work, wait for the previous work to be done
+		if (this->_job.state.load() != TaskJobState_Idle)
+			this->finish();
+
+		this->_job.work = work;
+		this->_job.param = param;
+		this->_job.ret = NULL;
+		TaskPool::Get().Submit(this->_job);
+		return;
+	}
+
 	slock_lock(this->mutex);
 
-	if ((work == NULL) || (this->workFunc != NULL) || !this->_isThreadRunning)
+	if ((work == NULL) || !this->_isThreadRunning)
+	{
+		slock_unlock(this->mutex);
+		return;
+	}
+
+	// the worker doesn't hold the mutex while the work runs, so wait for it to be idle
+	while ((this->workFunc != NULL) && !this->exitThread)
+	{
+		scond_wait(this->condWork, this->mutex);
+	}
+
+	if (this->exitThread)
 	{
 		slock_unlock(this->mutex);
 		return;
@@ -161,15 +751,39 @@ void Task::Impl::execute(const TWork &work, void *param)
 
 	this->workFunc = work;
 	this->workFuncParam = param;
-	scond_signal(this->condWork);
+	// the worker shares condWork with anyone waiting in execute() or finish()
+	scond_broadcast(this->condWork);
 
 	slock_unlock(this->mutex);
 }
 
+bool Task::Impl::runIfQueued()
+{
+	if (!this->_isPooled || !TaskPool::Get().Reclaim(this->_job))
+		return false;
+
+	this->_job.ret = this->_job.work(this->_job.param);
+	this->_job.state = TaskJobState_Done;
+	return true;
+}
+
 void* Task::Impl::finish()
 {
 	void *returnValue = NULL;
 
+	if (this->_isPooled)
+	{
+		if (this->_job.state.load() == TaskJobState_Idle)
+			return returnValue;
+
+		if (!this->runIfQueued())
+			TaskPool::Get().Wait(this->_job, this->_spinCount, this->_spinMax);
+
+		returnValue = this->_job.ret;
+		this->_job.state = TaskJobState_Idle;
+		return returnValue;
+	}
+
 	slock_lock(this->mutex);
 
 	if ((this->workFunc == NULL) || !this->_isThreadRunning) {
@@ -191,6 +805,13 @@ void* Task::Impl::finish()
 
 void Task::Impl::shutdown()
 {
+	if (this->_isPooled)
+	{
+		this->finish();
+		this->_isThreadRunning = false;
+		return;
+	}
+
 	slock_lock(this->mutex);
 
 	if (!this->_isThreadRunning) {
@@ -200,7 +821,7 @@ void Task::Impl::shutdown()
 
 	this->workFunc = NULL;
 	this->exitThread = true;
-	scond_signal(this->condWork);
+	scond_broadcast(this->condWork);
 
 	slock_unlock(this->mutex);
 
@@ -213,10 +834,82 @@ void Task::Impl::shutdown()
 
 void Task::start(bool spinlock) { impl->start(spinlock, 0, NULL); }
 void Task::start(bool spinlock, int threadPriority, const char *name) { impl->start(spinlock, threadPriority, name); }
+void Task::start(TaskGroup group, bool spinlock) { impl->start(group, spinlock); }
 void Task::shutdown() { impl->shutdown(); }
 Task::Task() : impl(new Task::Impl()) {}
 Task::~Task() { delete impl; }
 void Task::execute(const TWork &work, void* param) { impl->execute(work,param); }
+bool Task::runIfQueued() { return impl->runIfQueued(); }
 void* Task::finish() { return impl->finish(); }
 
+struct TaskPoolParallelFor
+{
+	TaskPoolParallelWork work;
+	void *param;
+	size_t count;
+	std::atomic<size_t> nextIndex;
+};
+
+static void* TaskPool_RunParallelFor(void *arg)
+{
+	TaskPoolParallelFor *parallelFor = (TaskPoolParallelFor *)arg;
+
+	for (size_t i = parallelFor->nextIndex.fetch_add(1); i < parallelFor->count; i = parallelFor->nextIndex.fetch_add(1))
+	{
+		parallelFor->work(parallelFor->param, i);
+	}
+
+	return NULL;
+}
+
+void TaskPool_ParallelFor(TaskGroup group, size_t count, TaskPoolParallelWork work, void *param)
+{
+	if (count == 0)
+		return;
+
+	TaskPool &pool = TaskPool::Get();
+	const size_t helperCount = std::min<size_t>(count - 1, pool.GetGroupThreadCount(group));
 
+	TaskPoolParallelFor parallelFor;
+	parallelFor.work = work;
+	parallelFor.param = param;
+	parallelFor.count = count;
+	parallelFor.nextIndex = 0;
+
+	TaskJob helper[TASKPOOL_MAX_THREADS];
+	for (size_t i = 0; i < helperCount; i++)
+	{
+		helper[i].work = &TaskPool_RunParallelFor;
+		helper[i].param = &parallelFor;
+		helper[i].group = group;
+		pool.Submit(helper[i]);
+	}
+
+	TaskPool_RunParallelFor(&parallelFor);
+
+	// every index has been handed out by now, so a helper that hasn't started has nothing left to do
+	u32 spinCount = TASK_SPIN_MIN;
+	for (size_t i = 0; i < helperCount; i++)
+	{
+		if (!pool.Reclaim(helper[i]))
+			pool.Wait(helper[i], spinCount, TASK_SPIN_MAX);
+	}
+}
+
+void TaskPool_SetThreadCount(size_t threadCount) { TaskPool::Get().SetThreadCount(threadCount); }
+size_t TaskPool_GetThreadCount() { return TaskPool::Get().GetThreadCount(); }
+void TaskPool_SetGroupLimit(TaskGroup group, size_t maxThreads, u32 threadMask) { TaskPool::Get().SetGroupLimit(group, maxThreads, threadMask); }
+void TaskPool_Shutdown() { TaskPool::Get().Shutdown(); }
+
+TaskGroup TaskPool_GroupFromName(const char *name)
+{
+	static const char *groupName[TaskGroupCount] = { "default", "rasterizer", "gpu", "videofilter", "cheatsearch" };
+
+	for (size_t i = 0; i < TaskGroupCount; i++)
+	{
+		if (strcmp(name, groupName[i]) == 0)
+			return (TaskGroup)i;
+	}
+
+	return TaskGroupCount;
+}
@@ -18,23 +18,52 @@
 #ifndef _TASK_H_
 #define _TASK_H_
 
+#include <stddef.h>
+#include "types.h"
+
+//the shared task pool can't have more threads than this, so that a u32 can select any set of them
+#define TASKPOOL_MAX_THREADS 32
+
+//the subsystems that hand work to the shared task pool.
+//each one can be held to a number of pool threads and to a subset of the pool threads (see TaskPool_SetGroupLimit())
+enum TaskGroup
+{
+	TaskGroup_Default = 0,
+	TaskGroup_Rasterizer,
+	TaskGroup_GPU,
+	TaskGroup_VideoFilter,
+	TaskGroup_CheatSearch,
+
+	TaskGroupCount
+};
+
 //Sort of like a single-thread thread pool.
-//You hand it a worker function and then call finish() to synch with its completion
+//You hand it a worker function and then call finish() to synch with its completion.
+//The work either runs on a thread of the task's own, or on the thread pool that all tasks share.
 class Task
 {
 public:
 	Task();
 	~Task();
-	
+
 	typedef void * (*TWork)(void *);
 
-	// initialize task runner
+	// initialize task runner on a thread of its own.
+	// use this for work that blocks for a long time (like waiting on a socket), since it would tie up a pool thread.
 	void start(bool spinlock);
 	void start(bool spinlock, int threadPriority, const char *name);
 
+	// initialize task runner on the shared thread pool.
+	// with spinlock set, finish() is willing to spin for longer before it sleeps, which suits work that takes microseconds.
+	void start(TaskGroup group, bool spinlock);
+
 	//execute some work
 	void execute(const TWork &work, void* param);
 
+	//if no pool thread has picked up the work yet, run it on the calling thread instead and return true.
+	//anything that waits on the work's progress without calling finish() should call this while it waits.
+	bool runIfQueued();
+
 	//wait for the work to complete
 	void* finish();
 
@@ -46,4 +75,26 @@ public:
 
 };
 
+typedef void (*TaskPoolParallelWork)(void *param, size_t index);
+
+//calls work(param, i) for every i in [0, count), spread over the pool threads that the group may use.
+//the calling thread takes its share too. returns once all of the calls have returned.
+void TaskPool_ParallelFor(TaskGroup group, size_t count, TaskPoolParallelWork work, void *param);
+
+//sets how many threads the shared pool runs; 0 uses one per CPU core.
+//can be called at any time. work that is already queued is carried over.
+void TaskPool_SetThreadCount(size_t threadCount);
+size_t TaskPool_GetThreadCount();
+
+//lets a group run on at most maxThreads pool threads at once (0 for no limit), and only on the pool threads
+//whose bits are set in threadMask (0 for any). a thread waiting on the work can always run it itself,
+//so a group that is held back never stalls.
+void TaskPool_SetGroupLimit(TaskGroup group, size_t maxThreads, u32 threadMask);
+
+//looks up a group by name (default, rasterizer, gpu, videofilter, cheatsearch); returns TaskGroupCount if there is none
+TaskGroup TaskPool_GroupFromName(const char *name);
+
+//stops the pool threads. they start again the next time the pool is needed.
+void TaskPool_Shutdown();
+
 #endif